@@ -0,0 +1,225 @@
+#pragma once
+#include "src/workload.h"
+#include "stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <pack/pack.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fty::bench {
+
+// =====================================================================================================================
+
+/// Latency summary in microseconds
+class Latency : public pack::Node
+{
+public:
+    pack::UInt64 count  = FIELD("count");
+    pack::UInt64 errors = FIELD("errors");
+    pack::UInt64 mean   = FIELD("mean");
+    pack::UInt64 p50    = FIELD("p50");
+    pack::UInt64 p90    = FIELD("p90");
+    pack::UInt64 p99    = FIELD("p99");
+    pack::UInt64 max    = FIELD("max");
+
+public:
+    using pack::Node::Node;
+    META(Latency, count, errors, mean, p50, p90, p99, max);
+
+public:
+    void set(const stats::Histogram& hist)
+    {
+        count  = hist.count;
+        errors = hist.errors;
+        mean   = hist.count ? hist.sum / hist.count : 0;
+        p50    = hist.percentile(0.5);
+        p90    = hist.percentile(0.9);
+        p99    = hist.percentile(0.99);
+        max    = hist.max;
+    }
+};
+
+/// Resources used by the process and its children (nut drivers)
+class Usage : public pack::Node
+{
+public:
+    pack::Double cpuUser   = FIELD("cpu_user");   // seconds
+    pack::Double cpuSystem = FIELD("cpu_system"); // seconds
+    pack::UInt64 rss       = FIELD("rss");        // current resident set, kB
+    pack::UInt64 maxRss    = FIELD("max_rss");    // peak resident set, kB
+
+public:
+    using pack::Node::Node;
+    META(Usage, cpuUser, cpuSystem, rss, maxRss);
+
+public:
+    /// Current usage
+    static Usage now()
+    {
+        auto res = Resources::now();
+
+        Usage usage;
+        usage.cpuUser   = res.cpuUser;
+        usage.cpuSystem = res.cpuSystem;
+        usage.rss       = res.rss;
+        usage.maxRss    = res.maxRss;
+        return usage;
+    }
+
+    /// Usage since `start`, memory is the current one
+    Usage since(const Usage& start) const
+    {
+        Usage diff     = *this;
+        diff.cpuUser   = cpuUser - start.cpuUser;
+        diff.cpuSystem = cpuSystem - start.cpuSystem;
+        return diff;
+    }
+};
+
+// =====================================================================================================================
+
+/// Measured value checked by the regression gate, lower is better
+class Result : public pack::Node
+{
+public:
+    pack::String name    = FIELD("name");
+    pack::String unit    = FIELD("unit");
+    pack::Double mean    = FIELD("mean");
+    pack::Double stddev  = FIELD("stddev");
+    pack::UInt64 samples = FIELD("samples");
+
+public:
+    using pack::Node::Node;
+    META(Result, name, unit, mean, stddev, samples);
+};
+
+/// Results of one benchmark run, saved as baseline or compared with it by `fty-discovery-ng-gate`
+class Results : public pack::Node
+{
+public:
+    pack::ObjectList<Result> results = FIELD("results");
+
+public:
+    using pack::Node::Node;
+    META(Results, results);
+};
+
+/// Latency of the histogram as gate result, deviation is estimated from bucket middles
+inline Result result(const std::string& name, const stats::Histogram& hist)
+{
+    double mean = hist.count ? double(hist.sum) / double(hist.count) : 0;
+    double sum  = 0;
+    for (size_t i = 0; i < hist.buckets.size(); ++i) {
+        if (hist.buckets[i]) {
+            double low  = i ? double(stats::Histogram::highest(i - 1) + 1) : 0;
+            double diff = (low + double(stats::Histogram::highest(i))) / 2 - mean;
+            sum += diff * diff * double(hist.buckets[i]);
+        }
+    }
+
+    Result res;
+    res.name    = name;
+    res.unit    = "us";
+    res.mean    = mean;
+    res.stddev  = hist.count > 1 ? std::sqrt(sum / double(hist.count - 1)) : 0;
+    res.samples = hist.count;
+    return res;
+}
+
+/// Name of the reference result, the gate compares other results as its multiples
+static constexpr const char* Reference = "reference";
+
+/// Fixed CPU bound work (string formatting, sort and map lookups as in parsing of driver outputs) measured in every
+/// run next to the benchmarks, so their ratios to it do not depend on the speed of the machine
+inline size_t referenceWork()
+{
+    std::vector<std::string> keys;
+    keys.reserve(512);
+    for (uint32_t i = 0; i < 512; ++i) {
+        keys.push_back("device." + std::to_string((i * 2654435761u) % 100000) + ".value");
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        index.emplace(keys[i], i);
+    }
+
+    size_t sum = 0;
+    for (const auto& key : keys) {
+        sum += index[key];
+    }
+    return sum;
+}
+
+/// Reference work measured `samples` times as gate result
+inline Result reference(uint32_t samples)
+{
+    static volatile size_t sink = 0;
+
+    std::vector<double> times;
+    for (uint32_t i = 0; i < samples; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        sink       = sink + referenceWork();
+        times.push_back(double(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+    }
+
+    double mean = 0;
+    for (double time : times) {
+        mean += time;
+    }
+    mean = times.empty() ? 0 : mean / double(times.size());
+
+    double sum = 0;
+    for (double time : times) {
+        sum += (time - mean) * (time - mean);
+    }
+
+    Result res;
+    res.name    = Reference;
+    res.unit    = "ns";
+    res.mean    = mean;
+    res.stddev  = times.size() > 1 ? std::sqrt(sum / double(times.size() - 1)) : 0;
+    res.samples = times.size();
+    return res;
+}
+
+inline Expected<void> save(const std::string& path, const Results& results)
+{
+    auto json = pack::json::serialize(results);
+    if (!json) {
+        return unexpected(json.error());
+    }
+    std::ofstream st(path);
+    st << *json << std::endl;
+    if (!st) {
+        return unexpected("Cannot write {}", path);
+    }
+    return {};
+}
+
+inline Expected<Results> load(const std::string& path)
+{
+    std::ifstream st(path);
+    if (!st) {
+        return unexpected("Cannot read {}", path);
+    }
+    std::stringstream ss;
+    ss << st.rdbuf();
+
+    Results results;
+    if (auto res = pack::json::deserialize(ss.str(), results); !res) {
+        return unexpected("{}: {}", path, res.error());
+    }
+    return results;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::bench
@@ -0,0 +1,111 @@
+#include "fleet.h"
+#include <fty/command-line.h>
+#include <fty/string-utils.h>
+#include <iostream>
+
+// =====================================================================================================================
+
+/// Generates synthetic fleet of simulated devices.
+///
+/// Recorded devices are used as templates, every generated device gets own serial numbers, MAC address, daisy chain
+/// and outlet counts (ePDU) and response delay. The output directory is loaded by the simulated agent, e.g. by the
+/// load benchmark as `--data <output> --devices '*'`.
+
+// =====================================================================================================================
+
+/// Parses inclusive range as `min-max` or single value
+static fty::Expected<std::pair<uint32_t, uint32_t>> parseRange(const std::string& str)
+{
+    auto parts = fty::split(str, "-");
+    try {
+        if (parts.size() == 1) {
+            uint32_t val = uint32_t(std::stoul(parts[0]));
+            return std::make_pair(val, val);
+        }
+        if (parts.size() == 2) {
+            return std::make_pair(uint32_t(std::stoul(parts[0])), uint32_t(std::stoul(parts[1])));
+        }
+    } catch (const std::exception&) {
+    }
+    return fty::unexpected("Wrong range '{}'", str);
+}
+
+int main(int argc, char** argv)
+{
+    using namespace fty;
+
+    std::string templates = "assets";
+    std::string count     = "1000";
+    std::string seed      = "1";
+    std::string chain     = "1-4";
+    std::string outlets   = "8-24";
+    std::string delay     = "0";
+    std::string output    = "fleet";
+    bool        help      = false;
+
+    // clang-format off
+    fty::CommandLine cmd("Synthetic fleet of simulated devices", {
+        {"--templates", templates, "Directory with snmprec recordings used as templates"},
+        {"--count",     count,     "Count of generated devices"},
+        {"--seed",      seed,      "Random seed, the same seed generates the same fleet"},
+        {"--chain",     chain,     "Daisy chain size of ePDUs, as 'min-max'"},
+        {"--outlets",   outlets,   "Outlets of each ePDU unit, as 'min-max'"},
+        {"--delay",     delay,     "Response delay in milliseconds, as 'min-max'"},
+        {"--output",    output,    "Output directory"},
+        {"--help",      help,      "Show this help"}
+    });
+    // clang-format on
+
+    if (auto res = cmd.parse(argc, argv); !res) {
+        std::cerr << res.error() << std::endl;
+        std::cout << std::endl;
+        std::cout << cmd.help() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (help) {
+        std::cout << cmd.help() << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    auto chainRange   = parseRange(chain);
+    auto outletsRange = parseRange(outlets);
+    auto delayRange   = parseRange(delay);
+    for (const auto* range : {&chainRange, &outletsRange, &delayRange}) {
+        if (!*range) {
+            std::cerr << range->error() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    sim::fleet::Options options;
+    options.count      = convert<uint32_t>(count);
+    options.seed       = convert<uint64_t>(seed);
+    options.minChain   = chainRange->first;
+    options.maxChain   = chainRange->second;
+    options.minOutlets = outletsRange->first;
+    options.maxOutlets = outletsRange->second;
+    options.minDelay   = sim::Impairment::Duration(delayRange->first);
+    options.maxDelay   = sim::Impairment::Duration(delayRange->second);
+
+    auto sources = sim::fleet::templates(templates);
+    if (!sources) {
+        std::cerr << sources.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto devices = sim::fleet::generate(*sources, options);
+    if (!devices) {
+        std::cerr << devices.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (auto res = sim::fleet::save(output, *devices); !res) {
+        std::cerr << res.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Generated " << devices->size() << " devices from " << sources->size() << " templates to " << output
+              << std::endl;
+    return EXIT_SUCCESS;
+}
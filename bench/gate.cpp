@@ -0,0 +1,256 @@
+#include "common.h"
+#include <cmath>
+#include <fty/command-line.h>
+#include <fty/string-utils.h>
+#include <iostream>
+#include <map>
+#include <vector>
+
+// =====================================================================================================================
+
+/// Performance regression gate.
+///
+/// Compares `--current` results of a benchmark (`fty-discovery-ng-micro` with `FTY_BENCH_RESULTS`, load benchmark with
+/// `--results`) with committed `--baseline`. Both runs measure the same reference work next to the benchmarks and
+/// results are compared as multiples of it, so a baseline recorded on one machine holds on another. A result regresses
+/// when its ratio exceeds the baseline ratio by more than `--tolerance` percent and the excess is significant on
+/// `--significance` level of one sided Welch t test (Welch-Satterthwaite degrees of freedom), so noisy runs slightly
+/// above the tolerance pass. Fails without baseline, `--update` saves the current results as the baseline.
+
+namespace fty::bench {
+
+// =====================================================================================================================
+
+/// Squared standard error of a mean with degrees of freedom of the deviation it comes from
+struct Component
+{
+    double variance = 0;
+    double dof      = 0;
+};
+
+/// Estimated mean, its variance is the sum of independent components
+struct Estimate
+{
+    double                 mean = 0;
+    std::vector<Component> components;
+};
+
+/// Ratio of the result to the reference of the same run, variance by the delta method
+static Estimate ratio(const Result& res, const Result& ref)
+{
+    double mean    = res.mean.value();
+    double refMean = ref.mean.value();
+    double samples = double(std::max<uint64_t>(res.samples.value(), 1));
+    double refs    = double(std::max<uint64_t>(ref.samples.value(), 1));
+
+    Estimate est;
+    est.mean = mean / refMean;
+    est.components.push_back(
+        {res.stddev.value() * res.stddev.value() / samples / (refMean * refMean), samples - 1});
+    est.components.push_back(
+        {est.mean * est.mean * ref.stddev.value() * ref.stddev.value() / refs / (refMean * refMean), refs - 1});
+    return est;
+}
+
+/// Continued fraction of the incomplete beta function (modified Lentz)
+static double betaFraction(double a, double b, double x)
+{
+    constexpr double tiny = 1e-300;
+
+    double c = 1;
+    double d = 1 - (a + b) * x / (a + 1);
+    d        = 1 / (std::fabs(d) < tiny ? tiny : d);
+    double h = d;
+    for (int m = 1; m <= 300; ++m) {
+        for (double num : {m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)),
+                 -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1))}) {
+            d = 1 + num * d;
+            d = 1 / (std::fabs(d) < tiny ? tiny : d);
+            c = 1 + num / c;
+            c = std::fabs(c) < tiny ? tiny : c;
+            h *= d * c;
+        }
+        if (std::fabs(d * c - 1) < 1e-12) {
+            break;
+        }
+    }
+    return h;
+}
+
+/// Regularized incomplete beta function I_x(a, b)
+static double incompleteBeta(double a, double b, double x)
+{
+    if (x <= 0) {
+        return 0;
+    }
+    if (x >= 1) {
+        return 1;
+    }
+    double front =
+        std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1 - x));
+    if (x < (a + 1) / (a + b + 2)) {
+        return front * betaFraction(a, b, x) / a;
+    }
+    return 1 - front * betaFraction(b, a, 1 - x) / b;
+}
+
+/// Probability of Student t distribution with `dof` degrees of freedom exceeding `t`
+static double upperTail(double t, double dof)
+{
+    if (!std::isfinite(dof) || dof > 1e7) {
+        return 0.5 * std::erfc(t / std::sqrt(2.));
+    }
+    double tail = 0.5 * incompleteBeta(dof / 2, 0.5, dof / (dof + t * t));
+    return t >= 0 ? tail : 1 - tail;
+}
+
+/// p-value of `current` exceeding `baseline` by more than `tolerance` of the baseline (one sided Welch t test)
+static double pvalue(const Estimate& baseline, const Estimate& current, double tolerance)
+{
+    double delta  = current.mean - baseline.mean;
+    double margin = baseline.mean * tolerance;
+
+    double variance = 0;
+    double denom    = 0;
+    for (const auto* est : {&baseline, &current}) {
+        for (const auto& comp : est->components) {
+            variance += comp.variance;
+            if (comp.dof > 0) {
+                denom += comp.variance * comp.variance / comp.dof;
+            }
+        }
+    }
+    if (variance == 0) {
+        return delta > margin ? 0 : 1;
+    }
+
+    // Welch-Satterthwaite
+    double dof = denom > 0 ? variance * variance / denom : HUGE_VAL;
+    return upperTail((delta - margin) / std::sqrt(variance), dof);
+}
+
+/// Result of the reference work
+static const Result* findReference(const Results& results)
+{
+    for (const auto& res : results.results) {
+        if (res.name.value() == Reference && res.mean.value() > 0) {
+            return &res;
+        }
+    }
+    return nullptr;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::bench
+
+int main(int argc, char** argv)
+{
+    using namespace fty;
+
+    std::string baseline;
+    std::string current;
+    std::string tolerance    = "10";
+    std::string significance = "0.01";
+    bool        update       = false;
+    bool        help         = false;
+
+    // clang-format off
+    fty::CommandLine cmd("Performance regression gate", {
+        {"--baseline",     baseline,     "Baseline results"},
+        {"--current",      current,      "Results of the current run"},
+        {"--tolerance",    tolerance,    "Tolerated slowdown in percents"},
+        {"--significance", significance, "Significance level of the regression"},
+        {"--update",       update,       "Save current results as the baseline"},
+        {"--help",         help,         "Show this help"}
+    });
+    // clang-format on
+
+    if (auto res = cmd.parse(argc, argv); !res) {
+        std::cerr << res.error() << std::endl;
+        std::cout << std::endl;
+        std::cout << cmd.help() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (help || baseline.empty() || current.empty()) {
+        std::cout << cmd.help() << std::endl;
+        return help ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    auto cur = bench::load(current);
+    if (!cur) {
+        std::cerr << cur.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (update) {
+        if (auto res = bench::save(baseline, *cur); !res) {
+            std::cerr << res.error() << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "Baseline " << baseline << " updated" << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    auto base = bench::load(baseline);
+    if (!base) {
+        std::cerr << "No baseline, record it with --update: " << base.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const bench::Result* curRef  = bench::findReference(*cur);
+    const bench::Result* baseRef = bench::findReference(*base);
+    if (!curRef || !baseRef) {
+        std::cerr << "No '" << bench::Reference << "' result in " << (curRef ? baseline : current) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    double tol   = convert<double>(tolerance) / 100;
+    double level = convert<double>(significance);
+
+    std::map<std::string, bench::Result> baselines;
+    for (const auto& res : base->results) {
+        if (res.name.value() != bench::Reference) {
+            baselines.emplace(res.name.value(), res);
+        }
+    }
+
+    int regressions = 0;
+    for (const auto& res : cur->results) {
+        if (res.name.value() == bench::Reference) {
+            continue;
+        }
+        auto it = baselines.find(res.name.value());
+        if (it == baselines.end()) {
+            std::cout << fmt::format("{:<40} {:>12.1f} {:<3} new", res.name.value(), res.mean.value(), res.unit.value())
+                      << std::endl;
+            continue;
+        }
+
+        auto   bas    = bench::ratio(it->second, *baseRef);
+        auto   now    = bench::ratio(res, *curRef);
+        double change = bas.mean > 0 ? (now.mean / bas.mean - 1) * 100 : 0;
+        double p      = bench::pvalue(bas, now, tol);
+        bool   failed = p < level;
+
+        std::cout << fmt::format("{:<40} {:>10.4f} -> {:>10.4f} x ref {:>+7.1f}%  p {:.4f}  {}", res.name.value(),
+                         bas.mean, now.mean, change, p, failed ? "REGRESSION" : "ok")
+                  << std::endl;
+        if (failed) {
+            regressions++;
+        }
+        baselines.erase(it);
+    }
+    for (const auto& [name, res] : baselines) {
+        std::cout << fmt::format("{:<40} missing in current results", name) << std::endl;
+    }
+
+    if (regressions) {
+        std::cout << std::endl
+                  << regressions << " regressions over " << tolerance << "% at significance " << significance
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,295 @@
+#include "common.h"
+#include "commands.h"
+#include "message-bus.h"
+#include "impairment.h"
+#include "snmp-agent.h"
+#include "src/config.h"
+#include "src/discovery.h"
+#include "src/jobs/impl/snmp.h"
+#include <atomic>
+#include <fstream>
+#include <fty/command-line.h>
+#include <fty/string-utils.h>
+#include <fty_log.h>
+#include <iostream>
+#include <thread>
+
+// =====================================================================================================================
+
+/// End to end load benchmark.
+///
+/// Starts simulated SNMP agent with `--agents` endpoints serving the test devices, runs discovery agent in process and drives
+/// it with `--concurrency` clients sending `--mix` of requests for `--duration` seconds. Writes JSON report with
+/// throughput, client side latencies, stage statistics of the agent and used resources, so runs of two commits can be
+/// compared.
+
+namespace fty::bench {
+
+// =====================================================================================================================
+
+class Report : public pack::Node
+{
+public:
+    class Options : public pack::Node
+    {
+    public:
+        pack::String     mix         = FIELD("mix");
+        pack::UInt32     agents      = FIELD("agents");
+        pack::UInt32     concurrency = FIELD("concurrency");
+        pack::UInt32     duration    = FIELD("duration"); // seconds
+        pack::StringList devices     = FIELD("devices");
+        pack::Bool       force       = FIELD("force");
+        pack::String     impair      = FIELD("impair");
+        pack::StringList impaired    = FIELD("impaired"); // all devices if empty
+        pack::UInt64     dropped     = FIELD("dropped");  // answers lost by impairment
+
+    public:
+        using pack::Node::Node;
+        META(Options, mix, agents, concurrency, duration, devices, force, impair, impaired, dropped);
+    };
+
+public:
+    Options                                  options    = FIELD("options");
+    pack::Double                             throughput = FIELD("throughput"); // requests per second
+    Latency                                  all        = FIELD("latency");
+    Latency                                  protocols  = FIELD("protocols");
+    Latency                                  mibs       = FIELD("mibs");
+    Latency                                  assets     = FIELD("assets");
+    pack::ObjectList<commands::stats::Stage> stages     = FIELD("stages");
+    Usage                                    usage      = FIELD("usage");
+
+public:
+    using pack::Node::Node;
+    META(Report, options, throughput, all, protocols, mibs, assets, stages, usage);
+};
+
+// =====================================================================================================================
+
+} // namespace fty::bench
+
+int main(int argc, char** argv)
+{
+    using namespace fty;
+
+    std::string mix         = "mibs:1,assets:1";
+    std::string agents      = "4";
+    std::string concurrency = "8";
+    std::string duration    = "30";
+    std::string port        = "21161";
+    std::string simThreads  = "2";
+    std::string devices     = "epdu.147,mge.125,mge.191,xups.238,xups.159";
+    std::string data        = "assets";
+    std::string mibs        = "mibs";
+    std::string output      = "load.json";
+    std::string results;
+    std::string impair;
+    std::string impaired;
+    bool        force       = false;
+    bool        help        = false;
+
+    // clang-format off
+    fty::CommandLine cmd("Discovery load benchmark", {
+        {"--mix",         mix,         "Requests with weights, as 'protocols:1,mibs:2,assets:1'"},
+        {"--agents",      agents,      "Count of simulated agent endpoints"},
+        {"--concurrency", concurrency, "Count of parallel clients"},
+        {"--duration",    duration,    "Duration in seconds"},
+        {"--port",        port,        "First simulated agent port"},
+        {"--sim-threads", simThreads,  "Threads of simulated agent"},
+        {"--devices",     devices,     "Simulated devices (snmprec files in data dir), '*' for all"},
+        {"--data",        data,        "Directory with snmprec files"},
+        {"--mibs",        mibs,        "Mib database"},
+        {"--output",      output,      "JSON report file"},
+        {"--results",     results,     "Latencies for the regression gate"},
+        {"--force",       force,       "Ignore agent caches"},
+        {"--impair",      impair,      "Network impairment, as 'latency=50,jitter=10,loss=0.05' or 'blackhole'"},
+        {"--impaired",    impaired,    "Impaired devices, all if not set"},
+        {"--help",        help,        "Show this help"}
+    });
+    // clang-format on
+
+    if (auto res = cmd.parse(argc, argv); !res) {
+        std::cerr << res.error() << std::endl;
+        std::cout << std::endl;
+        std::cout << cmd.help() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (help) {
+        std::cout << cmd.help() << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    auto weighted = bench::parseMix(mix);
+    if (!weighted) {
+        std::cerr << weighted.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint32_t agentCount   = std::max(convert<uint32_t>(agents), 1u);
+    uint32_t clientCount  = std::max(convert<uint32_t>(concurrency), 1u);
+    uint32_t seconds      = std::max(convert<uint32_t>(duration), 1u);
+    uint16_t firstPort    = convert<uint16_t>(port);
+    auto     deviceList   = split(devices, ",");
+    auto     impairedList = impaired.empty() ? std::vector<std::string>{} : split(impaired, ",");
+
+    // Simulated agents, community selects the device
+    sim::SnmpAgent snmpsim;
+    if (auto res = snmpsim.load(data); !res) {
+        std::cerr << res.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+    for (uint32_t i = 0; i < agentCount; ++i) {
+        if (auto res = snmpsim.listen(uint16_t(firstPort + i)); !res) {
+            std::cerr << res.error() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!impair.empty()) {
+        auto imp = sim::Impairment::parse(impair);
+        if (!imp) {
+            std::cerr << imp.error() << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (impairedList.empty()) {
+            snmpsim.impair({}, *imp);
+        }
+        for (const auto& dev : impairedList) {
+            snmpsim.impair(dev, *imp);
+        }
+    }
+    if (auto res = snmpsim.start(std::max(convert<uint32_t>(simThreads), 1u)); !res) {
+        std::cerr << res.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Whole generated fleet
+    if (devices == "*") {
+        deviceList = snmpsim.names();
+    }
+    if (deviceList.empty()) {
+        std::cerr << "No simulated devices in " << data << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Agent in process
+    Config::instance().actorName   = "discovery-ng-load";
+    Config::instance().endpoint    = "inproc://discovery-ng-load";
+    Config::instance().mibDatabase = mibs;
+    impl::Snmp::instance().init(mibs);
+
+    Discovery dis("");
+    if (auto res = dis.init(); !res) {
+        std::cerr << "Cannot init discovery: " << res.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::thread agent([&]() {
+        dis.run();
+    });
+
+    std::vector<std::unique_ptr<bench::MixClient>> clients;
+    for (uint32_t i = 0; i < clientCount; ++i) {
+        clients.emplace_back(
+            std::make_unique<bench::MixClient>(i, *weighted, deviceList, firstPort, agentCount, force));
+        if (auto res = clients.back()->init(); !res) {
+            std::cerr << "Cannot init client: " << res.error() << std::endl;
+            dis.shutdown();
+            agent.join();
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto reference = bench::reference(200);
+
+    stats::reset();
+    auto startUsage = bench::Usage::now();
+    auto start      = std::chrono::steady_clock::now();
+    auto deadline   = start + std::chrono::seconds(seconds);
+
+    std::vector<std::thread> threads;
+    for (auto& client : clients) {
+        threads.emplace_back([&client, deadline]() {
+            client->run(deadline);
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    double wall = double(bench::elapsed(start)) / 1e6;
+
+    bench::Report report;
+    report.options.mix         = mix;
+    report.options.agents      = agentCount;
+    report.options.concurrency = clientCount;
+    report.options.duration    = seconds;
+    report.options.devices.setValue(deviceList);
+    report.options.impaired.setValue(impairedList);
+    report.options.force   = force;
+    report.options.impair  = impair;
+    report.options.dropped = snmpsim.dropped();
+    report.usage         = bench::Usage::now().since(startUsage);
+
+    stats::Histogram all;
+    bench::Results   gate;
+    auto merge = [&](bench::Kind kind, bench::Latency& latency) {
+        stats::Histogram hist;
+        for (const auto& client : clients) {
+            bench::merge(hist, client->histogram(kind));
+        }
+        bench::merge(all, hist);
+        latency.set(hist);
+        if (hist.count) {
+            gate.results.append(bench::result("load " + bench::subject(kind), hist));
+        }
+    };
+    merge(bench::Kind::Protocols, report.protocols);
+    merge(bench::Kind::Mibs, report.mibs);
+    merge(bench::Kind::Assets, report.assets);
+    report.all.set(all);
+    gate.results.append(bench::result("load all", all));
+    gate.results.append(reference);
+    report.throughput = double(all.count) / wall;
+
+    // Stage statistics as the agent reports them
+    {
+        MessageBus bus;
+        if (auto res = bus.init("discovery-ng-load-stats", Config::instance().endpoint); res) {
+            Message msg;
+            msg.meta.to      = Config::instance().actorName;
+            msg.meta.subject = commands::stats::Subject;
+            msg.userData.setString(*pack::json::serialize(commands::stats::In()));
+            if (auto ret = bus.send(Channel, msg)) {
+                if (auto stages = ret->userData.decode<commands::stats::Out>()) {
+                    report.stages = *stages;
+                }
+            }
+        }
+    }
+
+    dis.shutdown();
+    agent.join();
+    snmpsim.stop();
+
+    auto json = pack::json::serialize(report);
+    if (!json) {
+        std::cerr << json.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << *json << std::endl;
+    std::ofstream st(output);
+    st << *json << std::endl;
+    if (!st) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!results.empty()) {
+        if (auto res = bench::save(results, gate); !res) {
+            std::cerr << res.error() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,234 @@
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include "commands.h"
+#include "common.h"
+#include "logger.h"
+#include "message-bus.h"
+#include "src/jobs/assets.h"
+#include "src/jobs/impl/mibs.h"
+#include "src/jobs/impl/neon.h"
+#include "src/jobs/impl/nut/mapper.h"
+#include "src/jobs/impl/uuid.h"
+#include "src/jobs/impl/xml-pdc.h"
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <fstream>
+#include <fty_log.h>
+#include <sstream>
+
+// =====================================================================================================================
+
+/// Microbenchmarks of CPU bound paths on recorded fixtures.
+/// Run as `fty-discovery-ng-micro --benchmark-samples 100`, any Catch2 reporter can be used to save results.
+/// With `FTY_BENCH_RESULTS=<file>` in environment means and deviations are saved for the regression gate.
+
+static std::string fixture(const std::string& name)
+{
+    std::ifstream     st(std::string(FIXTURES_DIR) + "/" + name);
+    std::stringstream ss;
+    ss << st.rdbuf();
+    return ss.str();
+}
+
+static std::vector<std::string> keys(const std::string& dump)
+{
+    std::vector<std::string> out;
+    std::stringstream        ss(dump);
+    for (std::string line; std::getline(ss, line);) {
+        out.push_back(line.substr(0, line.find(':')));
+    }
+    return out;
+}
+
+// =====================================================================================================================
+
+/// Collects results of all benchmarks for the regression gate
+class GateListener : public Catch::TestEventListenerBase
+{
+public:
+    using Catch::TestEventListenerBase::TestEventListenerBase;
+
+    void benchmarkEnded(const Catch::BenchmarkStats<>& stats) override
+    {
+        fty::bench::Result res;
+        res.name    = stats.info.name;
+        res.unit    = "ns";
+        res.mean    = stats.mean.point.count();
+        res.stddev  = stats.standardDeviation.point.count();
+        res.samples = stats.samples.size();
+        m_results.results.append(res);
+    }
+
+    void testRunEnded(const Catch::TestRunStats& stats) override
+    {
+        Catch::TestEventListenerBase::testRunEnded(stats);
+        if (const char* path = std::getenv("FTY_BENCH_RESULTS")) {
+            if (auto res = fty::bench::save(path, m_results); !res) {
+                std::cerr << res.error() << std::endl;
+            }
+        }
+    }
+
+private:
+    fty::bench::Results m_results;
+};
+
+CATCH_REGISTER_LISTENER(GateListener)
+
+// =====================================================================================================================
+
+TEST_CASE("Reference")
+{
+    // Gate compares other benchmarks as multiples of this one
+    BENCHMARK("reference")
+    {
+        return fty::bench::referenceWork();
+    };
+}
+
+TEST_CASE("Parse driver output")
+{
+    fty::MessageBus  bus;
+    fty::job::Assets assets(fty::Message(), bus);
+
+    std::string ups  = fixture("ups.dump");
+    std::string epdu = fixture("epdu-daisychain.dump");
+    REQUIRE(!ups.empty());
+    REQUIRE(!epdu.empty());
+
+    BENCHMARK("Assets::parse ups")
+    {
+        fty::commands::assets::Out out;
+        assets.parse(ups, out);
+        return out.size();
+    };
+
+    BENCHMARK("Assets::parse daisy chain epdu")
+    {
+        fty::commands::assets::Out out;
+        assets.parse(epdu, out);
+        return out.size();
+    };
+}
+
+TEST_CASE("Map nut keys")
+{
+    auto all = keys(fixture("epdu-daisychain.dump"));
+
+    BENCHMARK("Mapper::mapKey")
+    {
+        size_t mapped = 0;
+        for (const auto& key : all) {
+            mapped += fty::impl::nut::Mapper::mapKey(key).size();
+        }
+        return mapped;
+    };
+}
+
+TEST_CASE("Deserialize xml pages")
+{
+    std::string product = fixture("product.xml");
+    std::string summary = fixture("summary.xml");
+
+    BENCHMARK("neon::deserialize product.xml")
+    {
+        fty::impl::ProductInfo info;
+        neon::deserialize(product, info);
+        return info.name.size();
+    };
+
+    BENCHMARK("neon::deserialize summary")
+    {
+        fty::impl::Properties props;
+        neon::deserialize(summary, props);
+        return props.values.size();
+    };
+}
+
+TEST_CASE("Mibs")
+{
+    // clang-format off
+    const std::vector<std::string> mibs = {
+        "EATON-EPDU-MIB", "SNMPv2-MIB", "MG-SNMP-UPS-MIB", "IP-MIB", "XUPS-MIB", "UDP-MIB", "TCP-MIB",
+        "RFC1213-MIB", "EATON-OIDS", "SNMP-FRAMEWORK-MIB", "CPQPOWER-MIB", "DISMAN-EVENT-MIB"
+    };
+    // clang-format on
+
+    BENCHMARK("sortMibs")
+    {
+        auto sorted = mibs;
+        std::sort(sorted.begin(), sorted.end(), fty::impl::sortMibs);
+        return sorted.front().size();
+    };
+
+    BENCHMARK("filterMib")
+    {
+        return std::count_if(mibs.begin(), mibs.end(), fty::impl::filterMib);
+    };
+}
+
+TEST_CASE("Generate uuid")
+{
+    BENCHMARK("generateUUID")
+    {
+        return fty::impl::generateUUID("EATON", "Eaton 5PX 1500", "G202E21234");
+    };
+}
+
+TEST_CASE("Serialize assets")
+{
+    fty::MessageBus  bus;
+    fty::job::Assets assets(fty::Message(), bus);
+
+    // Large daisy chain answer
+    fty::commands::assets::Out out;
+    std::string                epdu = fixture("epdu-daisychain.dump");
+    for (int i = 0; i < 8; ++i) {
+        assets.parse(epdu, out);
+    }
+    REQUIRE(out.size() > 1);
+
+    BENCHMARK("pack::json::serialize assets")
+    {
+        return pack::json::serialize(out)->size();
+    };
+}
+
+TEST_CASE("Request logging")
+{
+    fty::Message msg;
+    msg.meta.subject       = fty::commands::assets::Subject;
+    msg.meta.from          = "bench";
+    msg.meta.correlationId = "bench-correlation-id";
+    msg.userData.setString(fixture("product.xml"));
+
+    Ftylog* log = ManageFtyLog::getInstanceFtylog();
+
+    // Disabled level must not format anything
+    log->setLogLevelInfo();
+    BENCHMARK("log_debug disabled")
+    {
+        log_debug("Discovery: got message %s", msg.dump().c_str());
+    };
+    BENCHMARK("slog_debug disabled")
+    {
+        slog_debug("Discovery: got message",
+            {{"subject", msg.meta.subject.value()}, {"payload", msg.userData.asString()}});
+    };
+
+    log->setLogLevelDebug();
+    BENCHMARK("log_debug enabled")
+    {
+        log_debug("Discovery: got message %s", msg.dump().c_str());
+    };
+
+    fty::logger::start(1 << 16, 0);
+    BENCHMARK("slog_debug enabled, queued")
+    {
+        slog_debug("Discovery: got message",
+            {{"subject", msg.meta.subject.value()}, {"payload", msg.userData.asString()}});
+    };
+    fty::logger::stop();
+    log->setLogLevelInfo();
+}
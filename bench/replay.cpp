@@ -0,0 +1,319 @@
+#include "capture.h"
+#include "commands.h"
+#include "common.h"
+#include "message-bus.h"
+#include "src/config.h"
+#include "src/discovery.h"
+#include "src/jobs/impl/snmp.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <fty/command-line.h>
+#include <fty/string-utils.h>
+#include <fty_log.h>
+#include <iostream>
+#include <map>
+#include <thread>
+
+// =====================================================================================================================
+
+/// Replays captured discovery traffic.
+///
+/// Reads the file recorded with `capture-file` option of the agent, runs discovery agent in process with all device
+/// answers (liveness, SNMP, HTTP and driver outputs) served from the capture and sends captured requests again with
+/// original timing divided by `--speed` (0 sends them as fast as `--concurrency` clients can). Writes JSON report with
+/// latencies per subject, stage statistics and used resources.
+
+namespace fty::bench {
+
+// =====================================================================================================================
+
+class Report : public pack::Node
+{
+public:
+    class Options : public pack::Node
+    {
+    public:
+        pack::String input       = FIELD("input");
+        pack::Double speed       = FIELD("speed");
+        pack::UInt32 concurrency = FIELD("concurrency");
+        pack::Bool   delays      = FIELD("delays");
+
+    public:
+        using pack::Node::Node;
+        META(Options, input, speed, concurrency, delays);
+    };
+
+    class Subject : public pack::Node
+    {
+    public:
+        pack::String subject = FIELD("subject");
+        Latency      latency = FIELD("latency");
+
+    public:
+        using pack::Node::Node;
+        META(Subject, subject, latency);
+    };
+
+public:
+    Options                                  options    = FIELD("options");
+    pack::UInt64                             requests   = FIELD("requests");
+    pack::Double                             duration   = FIELD("duration");   // seconds
+    pack::Double                             throughput = FIELD("throughput"); // requests per second
+    pack::UInt64                             late       = FIELD("late");       // sent after their replay time
+    Latency                                  all        = FIELD("latency");
+    pack::ObjectList<Subject>                subjects   = FIELD("subjects");
+    pack::ObjectList<commands::stats::Stage> stages     = FIELD("stages");
+    Usage                                    usage      = FIELD("usage");
+
+public:
+    using pack::Node::Node;
+    META(Report, options, requests, duration, throughput, late, all, subjects, stages, usage);
+};
+
+// =====================================================================================================================
+
+/// Client sending next due request until all are sent
+class Client
+{
+public:
+    Client(size_t id, const std::vector<capture::Record>& requests, std::atomic<size_t>& next)
+        : m_id(id)
+        , m_requests(requests)
+        , m_next(next)
+    {
+    }
+
+    Expected<void> init()
+    {
+        return m_bus.init("discovery-ng-replay-" + std::to_string(m_id), Config::instance().endpoint);
+    }
+
+    void run(std::chrono::steady_clock::time_point start, double speed)
+    {
+        for (size_t idx = m_next++; idx < m_requests.size(); idx = m_next++) {
+            const auto& rec = m_requests[idx];
+
+            if (speed > 0) {
+                auto due = start + std::chrono::microseconds(uint64_t(double(rec.time.value()) / speed));
+                if (std::chrono::steady_clock::now() > due + std::chrono::milliseconds(10)) {
+                    m_late++;
+                }
+                std::this_thread::sleep_until(due);
+            }
+
+            Message msg;
+            msg.meta.to      = Config::instance().actorName;
+            msg.meta.subject = rec.key;
+            msg.userData.setString(rec.values.empty() ? std::string() : rec.values[0]);
+
+            auto begin = std::chrono::steady_clock::now();
+            auto ret   = m_bus.send(Channel, msg);
+            auto& hist = m_hists[rec.key];
+            hist.add(elapsed(begin));
+            if (!ret) {
+                hist.errors++;
+            }
+        }
+    }
+
+    const std::map<std::string, stats::Histogram>& histograms() const
+    {
+        return m_hists;
+    }
+
+    uint64_t late() const
+    {
+        return m_late;
+    }
+
+private:
+    size_t                                  m_id;
+    const std::vector<capture::Record>&     m_requests;
+    std::atomic<size_t>&                    m_next;
+    MessageBus                              m_bus;
+    std::map<std::string, stats::Histogram> m_hists;
+    uint64_t                                m_late = 0;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::bench
+
+int main(int argc, char** argv)
+{
+    using namespace fty;
+
+    std::string input       = "capture.jsonl";
+    std::string speed       = "1";
+    std::string concurrency = "16";
+    std::string mibs        = "mibs";
+    std::string output      = "replay.json";
+    bool        delays      = false;
+    bool        help        = false;
+
+    // clang-format off
+    fty::CommandLine cmd("Discovery replay of captured traffic", {
+        {"--input",       input,       "Capture file recorded by the agent"},
+        {"--speed",       speed,       "Speed up of the original timing, 0 sends requests without waiting"},
+        {"--concurrency", concurrency, "Count of parallel clients"},
+        {"--delays",      delays,      "Device answers take as long as recorded"},
+        {"--mibs",        mibs,        "Mib database"},
+        {"--output",      output,      "JSON report file"},
+        {"--help",        help,        "Show this help"}
+    });
+    // clang-format on
+
+    if (auto res = cmd.parse(argc, argv); !res) {
+        std::cerr << res.error() << std::endl;
+        std::cout << std::endl;
+        std::cout << cmd.help() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (help) {
+        std::cout << cmd.help() << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    double   factor      = std::max(convert<double>(speed), 0.);
+    uint32_t clientCount = std::max(convert<uint32_t>(concurrency), 1u);
+
+    auto records = capture::read(input);
+    if (!records) {
+        std::cerr << records.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<capture::Record> requests;
+    for (const auto& rec : *records) {
+        if (rec.kind == capture::kind::Request) {
+            requests.push_back(rec);
+        }
+    }
+    std::stable_sort(requests.begin(), requests.end(), [](const auto& l, const auto& r) {
+        return l.time.value() < r.time.value();
+    });
+    if (requests.empty()) {
+        std::cerr << "No requests in " << input << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Replayed requests start at zero
+    uint64_t first = requests.front().time;
+    for (auto& rec : requests) {
+        rec.time = rec.time.value() - first;
+    }
+
+    if (auto res = capture::replay(input, delays); !res) {
+        std::cerr << res.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Agent in process, without any state which would make runs differ
+    Config::instance().actorName   = "discovery-ng-replay";
+    Config::instance().endpoint    = "inproc://discovery-ng-replay";
+    Config::instance().mibDatabase = mibs;
+    impl::Snmp::instance().init(mibs);
+
+    Discovery dis("");
+    if (auto res = dis.init(); !res) {
+        std::cerr << "Cannot init discovery: " << res.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::thread agent([&]() {
+        dis.run();
+    });
+
+    std::atomic<size_t>                         next = 0;
+    std::vector<std::unique_ptr<bench::Client>> clients;
+    for (uint32_t i = 0; i < clientCount; ++i) {
+        clients.emplace_back(std::make_unique<bench::Client>(i, requests, next));
+        if (auto res = clients.back()->init(); !res) {
+            std::cerr << "Cannot init client: " << res.error() << std::endl;
+            dis.shutdown();
+            agent.join();
+            return EXIT_FAILURE;
+        }
+    }
+
+    stats::reset();
+    auto startUsage = bench::Usage::now();
+    auto start      = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (auto& client : clients) {
+        threads.emplace_back([&client, start, factor]() {
+            client->run(start, factor);
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    double wall = double(bench::elapsed(start)) / 1e6;
+
+    bench::Report report;
+    report.options.input       = input;
+    report.options.speed       = factor;
+    report.options.concurrency = clientCount;
+    report.options.delays      = delays;
+    report.requests            = requests.size();
+    report.duration            = wall;
+    report.throughput          = double(requests.size()) / wall;
+    report.usage               = bench::Usage::now().since(startUsage);
+
+    stats::Histogram                        all;
+    std::map<std::string, stats::Histogram> subjects;
+    uint64_t                                late = 0;
+    for (const auto& client : clients) {
+        for (const auto& [subject, hist] : client->histograms()) {
+            bench::merge(subjects[subject], hist);
+            bench::merge(all, hist);
+        }
+        late += client->late();
+    }
+    for (const auto& [subject, hist] : subjects) {
+        bench::Report::Subject item;
+        item.subject = subject;
+        item.latency.set(hist);
+        report.subjects.append(item);
+    }
+    report.all.set(all);
+    report.late = late;
+
+    // Stage statistics as the agent reports them
+    {
+        MessageBus bus;
+        if (auto res = bus.init("discovery-ng-replay-stats", Config::instance().endpoint); res) {
+            Message msg;
+            msg.meta.to      = Config::instance().actorName;
+            msg.meta.subject = commands::stats::Subject;
+            msg.userData.setString(*pack::json::serialize(commands::stats::In()));
+            if (auto ret = bus.send(Channel, msg)) {
+                if (auto stages = ret->userData.decode<commands::stats::Out>()) {
+                    report.stages = *stages;
+                }
+            }
+        }
+    }
+
+    dis.shutdown();
+    agent.join();
+    capture::stop();
+
+    auto json = pack::json::serialize(report);
+    if (!json) {
+        std::cerr << json.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << *json << std::endl;
+    std::ofstream st(output);
+    st << *json << std::endl;
+    if (!st) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+/*  =========================================================================
+    allocator.cpp - Global allocation functions counting per job memory
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "memory.h"
+#include <new>
+
+// =====================================================================================================================
+// Replaces allocation of the whole process, so it is linked only to our executables (agent, tests, benchmarks),
+// never to the common library which ends in the tntnet plugin too. Aligned variants are left to the library and are
+// not counted.
+// =====================================================================================================================
+
+void* operator new(std::size_t size)
+{
+    while (true) {
+        if (void* ptr = fty::memory::detail::allocate(size)) {
+            return ptr;
+        }
+        if (std::new_handler handler = std::get_new_handler()) {
+            handler();
+        } else {
+            throw std::bad_alloc();
+        }
+    }
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return operator new[](size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* ptr) noexcept
+{
+    fty::memory::detail::release(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    fty::memory::detail::release(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    fty::memory::detail::release(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    fty::memory::detail::release(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    fty::memory::detail::release(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    fty::memory::detail::release(ptr);
+}
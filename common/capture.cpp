@@ -0,0 +1,349 @@
+/*  =========================================================================
+    capture.cpp - Recording and replay of discovery traffic
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "capture.h"
+#include "commands.h"
+#include "message.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <fstream>
+#include <fty_log.h>
+#include <map>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace fty::capture {
+
+// =====================================================================================================================
+
+namespace {
+
+    enum class Mode
+    {
+        None,
+        Record,
+        Replay
+    };
+
+    class Capture
+    {
+    public:
+        static Capture& instance()
+        {
+            static Capture inst;
+            return inst;
+        }
+
+        Expected<void> start(const std::string& file)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            reset();
+
+            // Capture shows the whole network, only the owner can read it
+            int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+            if (fd < 0 || fchmod(fd, S_IRUSR | S_IWUSR) != 0) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+                return unexpected("Cannot open capture file {}", file);
+            }
+            close(fd);
+
+            m_file.open(file, std::ios::trunc);
+            if (!m_file) {
+                return unexpected("Cannot open capture file {}", file);
+            }
+            m_start = std::chrono::steady_clock::now();
+            m_mode  = Mode::Record;
+            log_info("Capture: recording to %s", file.c_str());
+            return {};
+        }
+
+        Expected<void> replay(const std::string& file, bool delays)
+        {
+            auto records = read(file);
+            if (!records) {
+                return unexpected(records.error());
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            reset();
+
+            for (auto& rec : *records) {
+                if (rec.kind == kind::Request) {
+                    continue;
+                }
+                m_answers[id(rec.kind.value().c_str(), rec.address, rec.key)].records.push_back(std::move(rec));
+            }
+            m_delays = delays;
+            m_start  = std::chrono::steady_clock::now();
+            m_mode   = Mode::Replay;
+            log_info("Capture: replaying %zu device exchanges from %s", m_answers.size(), file.c_str());
+            return {};
+        }
+
+        void stop()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            reset();
+        }
+
+        Mode mode() const
+        {
+            return m_mode.load(std::memory_order_relaxed);
+        }
+
+        uint64_t now() const
+        {
+            return uint64_t(
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start)
+                    .count());
+        }
+
+        void write(Record& rec)
+        {
+            rec.time = now();
+            if (!rec.correlationId.hasValue()) {
+                rec.correlationId = trace::Context::current();
+            }
+
+            auto json = pack::json::serialize(rec);
+            if (!json) {
+                log_error("Capture: %s", json.error().c_str());
+                return;
+            }
+            // One record per line, line breaks in values are escaped by json
+            std::replace(json->begin(), json->end(), '\n', ' ');
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_file.is_open()) {
+                m_file << *json << '\n';
+            }
+        }
+
+        Expected<std::vector<std::string>> answer(const char* kind, const std::string& address, const std::string& key)
+        {
+            Record rec;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                auto it = m_answers.find(id(kind, address, key));
+                if (it == m_answers.end()) {
+                    return unexpected("Not recorded: {} {} {}", kind, address, key);
+                }
+
+                // Repeated exchanges are answered in recorded order, the last answer repeats
+                auto& answers = it->second;
+                rec           = answers.records[std::min(answers.next, answers.records.size() - 1)];
+                answers.next++;
+            }
+
+            if (m_delays && rec.duration.value()) {
+                std::this_thread::sleep_for(std::chrono::microseconds(rec.duration.value()));
+            }
+            if (rec.error.hasValue()) {
+                return unexpected(rec.error.value());
+            }
+            return rec.values.value();
+        }
+
+    private:
+        struct Answers
+        {
+            std::vector<Record> records;
+            size_t              next = 0;
+        };
+
+        Capture() = default;
+
+        static std::string id(const char* kind, const std::string& address, const std::string& key)
+        {
+            return std::string(kind) + "|" + address + "|" + key;
+        }
+
+        void reset()
+        {
+            if (m_file.is_open()) {
+                m_file.close();
+            }
+            m_answers.clear();
+            m_delays = false;
+            m_mode   = Mode::None;
+        }
+
+    private:
+        std::mutex                            m_mutex;
+        std::atomic<Mode>                     m_mode = Mode::None;
+        std::ofstream                         m_file;
+        std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+        std::map<std::string, Answers>        m_answers;
+        bool                                  m_delays = false;
+    };
+
+} // namespace
+
+// =====================================================================================================================
+
+Expected<void> start(const std::string& file)
+{
+    return Capture::instance().start(file);
+}
+
+Expected<void> replay(const std::string& file, bool delays)
+{
+    return Capture::instance().replay(file, delays);
+}
+
+void stop()
+{
+    Capture::instance().stop();
+}
+
+static void redact(pack::String& secret)
+{
+    if (!secret.empty()) {
+        secret = commands::assets::Redacted;
+    }
+}
+
+/// Decodes the request, redacts it by `func` and encodes it again. Content which cannot be redacted is not written.
+template <typename T, typename Func>
+static std::string redacted(const Message& msg, Func&& func)
+{
+    if (auto in = msg.userData.decode<T>()) {
+        func(*in);
+        if (auto out = pack::json::serialize(*in)) {
+            return *out;
+        }
+    }
+    return {};
+}
+
+/// Request payload without communities and passwords
+static std::string payload(const Message& msg)
+{
+    if (msg.meta.subject == commands::mibs::Subject) {
+        return redacted<commands::mibs::In>(msg, [](commands::mibs::In& in) {
+            redact(in.community);
+        });
+    } else if (msg.meta.subject == commands::assets::Subject || msg.meta.subject == commands::delta::Subject) {
+        return redacted<commands::assets::In>(msg, [](commands::assets::In& in) {
+            commands::assets::redact(in);
+        });
+    } else if (msg.meta.subject == commands::schedule::Subject) {
+        return redacted<commands::schedule::In>(msg, [](commands::schedule::In& in) {
+            commands::assets::redact(in.request);
+        });
+    }
+    return msg.userData.asString();
+}
+
+void request(const Message& msg)
+{
+    if (Capture::instance().mode() != Mode::Record) {
+        return;
+    }
+
+    Record rec;
+    rec.kind    = kind::Request;
+    rec.address = msg.meta.from;
+    rec.key     = msg.meta.subject;
+    rec.values.append(payload(msg));
+
+    // Request is not processed yet, correlation id is taken from the message
+    rec.correlationId = msg.meta.correlationId;
+
+    Capture::instance().write(rec);
+}
+
+Expected<std::vector<Record>> read(const std::string& file)
+{
+    std::ifstream st(file);
+    if (!st) {
+        return unexpected("Cannot open capture file {}", file);
+    }
+
+    std::vector<Record> records;
+    size_t              num = 0;
+    for (std::string line; std::getline(st, line);) {
+        ++num;
+        if (line.empty()) {
+            continue;
+        }
+        Record rec;
+        if (auto res = pack::json::deserialize(line, rec); !res) {
+            return unexpected("{}:{}: {}", file, num, res.error());
+        }
+        records.push_back(std::move(rec));
+    }
+    return records;
+}
+
+// =====================================================================================================================
+
+namespace detail {
+
+    bool recording()
+    {
+        return Capture::instance().mode() == Mode::Record;
+    }
+
+    bool replaying()
+    {
+        return Capture::instance().mode() == Mode::Replay;
+    }
+
+    uint64_t now()
+    {
+        return Capture::instance().now();
+    }
+
+    Expected<std::vector<std::string>> answer(const char* kind, const std::string& address, const std::string& key)
+    {
+        return Capture::instance().answer(kind, address, key);
+    }
+
+    void record(const char* kind, const std::string& address, const std::string& key,
+        const Expected<std::vector<std::string>>& result, uint64_t duration)
+    {
+        Record rec;
+        rec.kind     = kind;
+        rec.address  = address;
+        rec.key      = key;
+        rec.duration = duration;
+        if (result) {
+            rec.values.setValue(*result);
+        } else {
+            rec.error = result.error().empty() ? "failed" : result.error();
+        }
+        Capture::instance().write(rec);
+    }
+
+} // namespace detail
+
+// =====================================================================================================================
+
+} // namespace fty::capture
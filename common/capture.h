@@ -0,0 +1,135 @@
+/*  =========================================================================
+    capture.h - Recording and replay of discovery traffic
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <fty/expected.h>
+#include <pack/pack.h>
+#include <string>
+#include <vector>
+
+namespace fty {
+class Message;
+}
+
+namespace fty::capture {
+
+// =====================================================================================================================
+
+/// Kind of recorded exchange
+namespace kind {
+    static constexpr const char* Request = "request"; // incoming message, key is subject, value is payload
+    static constexpr const char* Host    = "host";    // liveness check of the address
+    static constexpr const char* Snmp    = "snmp";    // snmp get (key is oid or oids separated by space) or walk
+    static constexpr const char* Http    = "http";    // http get, key is `port/path`
+    static constexpr const char* Driver  = "driver";  // nut driver run, key is `protocol:port`
+} // namespace kind
+
+/// One line of the capture file
+class Record : public pack::Node
+{
+public:
+    pack::String     kind          = FIELD("kind");
+    pack::UInt64     time          = FIELD("time");     // microseconds since capture start
+    pack::UInt64     duration      = FIELD("duration"); // microseconds
+    pack::String     address       = FIELD("address");  // device address, requester for requests
+    pack::String     key           = FIELD("key");
+    pack::StringList values        = FIELD("values");
+    pack::String     error         = FIELD("error");
+    pack::String     correlationId = FIELD("correlation_id");
+
+public:
+    using pack::Node::Node;
+    META(Record, kind, time, duration, address, key, values, error, correlationId);
+};
+
+// =====================================================================================================================
+
+/// Starts recording of requests and device answers to the file (JSON record per line)
+Expected<void> start(const std::string& file);
+
+/// Loads recorded device answers, all device exchanges are then answered from them and never reach the network.
+/// If `delays` is set, answers take as long as they took when recorded.
+Expected<void> replay(const std::string& file, bool delays = false);
+
+/// Stops recording or replay
+void stop();
+
+/// Records incoming request
+void request(const Message& msg);
+
+/// Reads all records of the file
+Expected<std::vector<Record>> read(const std::string& file);
+
+// =====================================================================================================================
+
+namespace detail {
+    bool     recording();
+    bool     replaying();
+    uint64_t now();
+
+    Expected<std::vector<std::string>> answer(const char* kind, const std::string& address, const std::string& key);
+
+    void record(const char* kind, const std::string& address, const std::string& key,
+        const Expected<std::vector<std::string>>& result, uint64_t duration);
+} // namespace detail
+
+/// Runs device exchange `func` (returning list of values) through capture: answers it from the replay, or runs it
+/// and records the result
+template <typename Func>
+Expected<std::vector<std::string>> exchange(
+    const char* kind, const std::string& address, const std::string& key, Func&& func)
+{
+    if (detail::replaying()) {
+        return detail::answer(kind, address, key);
+    }
+    if (!detail::recording()) {
+        return func();
+    }
+
+    uint64_t                           start  = detail::now();
+    Expected<std::vector<std::string>> result = func();
+    detail::record(kind, address, key, result, detail::now() - start);
+    return result;
+}
+
+/// Same as @ref exchange for exchanges with one value
+template <typename Func>
+Expected<std::string> exchangeOne(const char* kind, const std::string& address, const std::string& key, Func&& func)
+{
+    auto res = exchange(kind, address, key, [&]() -> Expected<std::vector<std::string>> {
+        if (auto val = func()) {
+            return std::vector<std::string>{*val};
+        } else {
+            return unexpected(val.error());
+        }
+    });
+    if (!res) {
+        return unexpected(res.error());
+    }
+    if (res->size() != 1) {
+        return unexpected("Wrong count of recorded values");
+    }
+    return res->front();
+}
+
+// =====================================================================================================================
+
+} // namespace fty::capture
@@ -16,10 +16,11 @@ namespace commands::protocols {
     {
     public:
         pack::String address = FIELD("address");
+        pack::Bool   force   = FIELD("force", false); // ignore cached fingerprints and failures
 
     public:
         using pack::Node::Node;
-        META(In, address);
+        META(In, address, force);
     };
 
     using Out = pack::StringList;
@@ -39,10 +40,11 @@ namespace commands::mibs {
         pack::String credentialId = FIELD("secw_credential_id");
         pack::String community    = FIELD("community");
         pack::UInt32 timeout      = FIELD("timeout", 1000); // timeout in milliseconds
+        pack::Bool   force        = FIELD("force", false);  // ignore cached fingerprints and failures
 
     public:
         using pack::Node::Node;
-        META(In, address, port, credentialId, community, timeout);
+        META(In, address, port, credentialId, community, timeout, force);
     };
 
     using Out = pack::StringList;
@@ -75,10 +77,11 @@ namespace commands::assets {
         pack::String protocol = FIELD("protocol");
         pack::UInt32 port     = FIELD("port");
         Settings     settings = FIELD("protocol_settings");
+        pack::Bool   force    = FIELD("force", false); // ignore cached fingerprints and failures
 
     public:
         using pack::Node::Node;
-        META(In, address, protocol, port, settings);
+        META(In, address, protocol, port, settings, force);
     };
 
     class Return : public pack::Node
@@ -107,8 +110,385 @@ namespace commands::assets {
     };
 
     using Out = pack::ObjectList<Return>;
+
+    /// Placeholder of secrets in captured and persisted requests, replaced, not removed, so the request takes the
+    /// same path
+    static constexpr const char* Redacted = "redacted";
+
+    /// Replaces community, username and password of the request by @ref Redacted
+    inline void redact(In& in)
+    {
+        for (pack::String* secret : {&in.settings.community, &in.settings.username, &in.settings.password}) {
+            if (!secret->empty()) {
+                *secret = Redacted;
+            }
+        }
+    }
+
+    /// Checks if some secret of the request was redacted
+    inline bool redacted(const In& in)
+    {
+        return in.settings.community.value() == Redacted || in.settings.username.value() == Redacted ||
+               in.settings.password.value() == Redacted;
+    }
 } // namespace commands::assets
 
 // =====================================================================================================================
 
+namespace commands::delta {
+    static constexpr const char* Subject = "assets-delta";
+
+    /// Same request as @ref commands::assets
+    using In = assets::In;
+
+    /// Changed ext value of the unit
+    class Change : public pack::Node
+    {
+    public:
+        pack::String subAddress = FIELD("sub_address");
+        pack::String key        = FIELD("key");
+        pack::String before     = FIELD("old"); // empty if value was added
+        pack::String after      = FIELD("new"); // empty if value was removed
+
+    public:
+        using pack::Node::Node;
+        META(Change, subAddress, key, before, after);
+    };
+
+    /// Difference against the previous discovery of the same device
+    class Out : public pack::Node
+    {
+    public:
+        pack::Bool                       unchanged = FIELD("unchanged", false);
+        pack::ObjectList<assets::Return> added     = FIELD("added");   // new units with all values
+        pack::StringList                 removed   = FIELD("removed"); // sub addresses of removed units
+        pack::ObjectList<Change>         changed   = FIELD("changed");
+
+    public:
+        using pack::Node::Node;
+        META(Out, unchanged, added, removed, changed);
+    };
+} // namespace commands::delta
+
+// =====================================================================================================================
+
+namespace commands::hosts {
+    static constexpr const char* Subject = "hosts";
+
+    /// Saved device fingerprint, loaded to the fingerprint cache on start
+    class Fingerprint : public pack::Node
+    {
+    public:
+        pack::String     key       = FIELD("key"); // cache key, credentials are hashed
+        pack::String     objectId  = FIELD("object_id");
+        pack::String     descr     = FIELD("descr");
+        pack::UInt64     upTime    = FIELD("up_time");
+        pack::String     product   = FIELD("product");
+        pack::String     version   = FIELD("version");
+        pack::StringList protocols = FIELD("protocols");
+        pack::StringList mibs      = FIELD("mibs");
+        pack::UInt32     rtt       = FIELD("rtt");     // milliseconds
+        pack::UInt64     updated   = FIELD("updated"); // unix time in seconds
+
+    public:
+        using pack::Node::Node;
+        META(Fingerprint, key, objectId, descr, upTime, product, version, protocols, mibs, rtt, updated);
+    };
+
+    /// Known host, persistent result of previous discoveries
+    class Host : public pack::Node
+    {
+    public:
+        pack::String                  address      = FIELD("address");
+        pack::StringList              protocols    = FIELD("protocols");
+        pack::StringList              mibs         = FIELD("mibs");
+        pack::String                  credentialId = FIELD("secw_credential_id");
+        pack::String                  driver       = FIELD("driver");
+        pack::StringList              uuids        = FIELD("uuids");
+        pack::UInt64                  firstSeen    = FIELD("first_seen"); // unix time in seconds
+        pack::UInt64                  lastSeen     = FIELD("last_seen");  // unix time in seconds
+        pack::ObjectList<Fingerprint> fingerprints = FIELD("fingerprints");
+
+    public:
+        using pack::Node::Node;
+        META(Host, address, protocols, mibs, credentialId, driver, uuids, firstSeen, lastSeen, fingerprints);
+    };
+
+    class In : public pack::Node
+    {
+    public:
+        pack::String address = FIELD("address"); // empty address returns all known hosts
+
+    public:
+        using pack::Node::Node;
+        META(In, address);
+    };
+
+    using Out = pack::ObjectList<Host>;
+} // namespace commands::hosts
+
+// =====================================================================================================================
+
+namespace commands::forget {
+    static constexpr const char* Subject = "forget";
+
+    class In : public pack::Node
+    {
+    public:
+        pack::String address = FIELD("address");
+
+    public:
+        using pack::Node::Node;
+        META(In, address);
+    };
+
+    /// Forgotten failures as `address/protocol`
+    using Out = pack::StringList;
+} // namespace commands::forget
+
+// =====================================================================================================================
+
+namespace commands::schedule {
+    static constexpr const char* Subject = "schedule";
+
+    /// Periodic rediscovery of the device
+    class Target : public pack::Node
+    {
+    public:
+        assets::In   request   = FIELD("request");
+        pack::UInt32 interval  = FIELD("interval", 3600); // seconds
+        pack::UInt64 nextRun   = FIELD("next_run");       // unix time in seconds
+        pack::UInt64 lastRun   = FIELD("last_run");       // unix time in seconds
+        pack::String lastError = FIELD("last_error");
+
+    public:
+        using pack::Node::Node;
+        META(Target, request, interval, nextRun, lastRun, lastError);
+    };
+
+    /// Registers (updates) target, request with empty address just lists targets
+    using In = Target;
+
+    /// All registered targets
+    using Out = pack::ObjectList<Target>;
+} // namespace commands::schedule
+
+// =====================================================================================================================
+
+namespace commands::unschedule {
+    static constexpr const char* Subject = "unschedule";
+
+    class In : public pack::Node
+    {
+    public:
+        pack::String address  = FIELD("address");
+        pack::UInt32 port     = FIELD("port");     // any port if not set
+        pack::String protocol = FIELD("protocol"); // any protocol if not set
+
+    public:
+        using pack::Node::Node;
+        META(In, address, port, protocol);
+    };
+
+    /// Removed targets
+    using Out = pack::ObjectList<schedule::Target>;
+} // namespace commands::unschedule
+
+// =====================================================================================================================
+
+namespace commands::watch {
+    static constexpr const char* Subject      = "watch";
+    static constexpr const char* EventSubject = "watch-event";
+
+    /// Registers watches of the requester, events are sent to requester mailbox as @ref Event
+    class In : public pack::Node
+    {
+    public:
+        pack::StringList hosts  = FIELD("hosts");         // addresses or ranges as `10.0.0.0/24`, `*` for any host
+        pack::Bool       remove = FIELD("remove", false); // removes listed hosts (all if empty) instead of adding
+
+    public:
+        using pack::Node::Node;
+        META(In, hosts, remove);
+    };
+
+    /// All watched hosts of the requester
+    using Out = pack::StringList;
+
+    /// Change of the watched device found by any rediscovery
+    class Event : public pack::Node
+    {
+    public:
+        pack::String address  = FIELD("address");
+        pack::UInt32 port     = FIELD("port");
+        pack::String protocol = FIELD("protocol");
+        delta::Out   delta    = FIELD("delta");
+
+    public:
+        using pack::Node::Node;
+        META(Event, address, port, protocol, delta);
+    };
+} // namespace commands::watch
+
+// =====================================================================================================================
+
+namespace commands::stats {
+    static constexpr const char* Subject = "stats";
+
+    class In : public pack::Node
+    {
+    public:
+        pack::Bool reset = FIELD("reset", false); // clears statistics after they are returned
+
+    public:
+        using pack::Node::Node;
+        META(In, reset);
+    };
+
+    /// Latency statistics of one stage, all durations are in microseconds
+    class Stage : public pack::Node
+    {
+    public:
+        pack::String name   = FIELD("name");
+        pack::UInt64 count  = FIELD("count");
+        pack::UInt64 errors = FIELD("errors");
+        pack::UInt64 mean   = FIELD("mean");
+        pack::UInt64 p50    = FIELD("p50");
+        pack::UInt64 p90    = FIELD("p90");
+        pack::UInt64 p99    = FIELD("p99");
+        pack::UInt64 p999   = FIELD("p999");
+        pack::UInt64 max    = FIELD("max");
+
+    public:
+        using pack::Node::Node;
+        META(Stage, name, count, errors, mean, p50, p90, p99, p999, max);
+    };
+
+    /// Stages measured at least once
+    using Out = pack::ObjectList<Stage>;
+} // namespace commands::stats
+
+// =====================================================================================================================
+
+namespace commands::trace {
+    static constexpr const char* Subject = "trace";
+
+    class In : public pack::Node
+    {
+    public:
+        pack::String correlationId = FIELD("correlation_id"); // spans of one request, all if empty
+        pack::Bool   clear         = FIELD("clear", false);   // clears recorded spans after they are returned
+
+    public:
+        using pack::Node::Node;
+        META(In, correlationId, clear);
+    };
+
+    /// Chrome trace complete event
+    class Event : public pack::Node
+    {
+    public:
+        pack::String    name = FIELD("name");
+        pack::String    cat  = FIELD("cat", "discovery");
+        pack::String    ph   = FIELD("ph", "X");
+        pack::UInt64    ts   = FIELD("ts");  // microseconds
+        pack::UInt64    dur  = FIELD("dur"); // microseconds
+        pack::UInt32    pid  = FIELD("pid");
+        pack::UInt32    tid  = FIELD("tid");
+        pack::StringMap args = FIELD("args");
+
+    public:
+        using pack::Node::Node;
+        META(Event, name, cat, ph, ts, dur, pid, tid, args);
+    };
+
+    /// Chrome trace event format, can be opened in Perfetto or chrome://tracing
+    class Out : public pack::Node
+    {
+    public:
+        pack::ObjectList<Event> traceEvents     = FIELD("traceEvents");
+        pack::String            displayTimeUnit = FIELD("displayTimeUnit", "ms");
+
+    public:
+        using pack::Node::Node;
+        META(Out, traceEvents, displayTimeUnit);
+    };
+} // namespace commands::trace
+
+// =====================================================================================================================
+
+namespace commands::memory {
+    static constexpr const char* Subject = "memory";
+
+    class In : public pack::Node
+    {
+    public:
+        pack::UInt32 top   = FIELD("top", 10);      // count of returned consumers
+        pack::Bool   reset = FIELD("reset", false); // clears consumers after they are returned
+
+    public:
+        using pack::Node::Node;
+        META(In, top, reset);
+    };
+
+    /// Allocations of all jobs of one subject and target (address of the device), sizes are in bytes
+    class Consumer : public pack::Node
+    {
+    public:
+        pack::String subject     = FIELD("subject");
+        pack::String target      = FIELD("target");
+        pack::UInt64 jobs        = FIELD("jobs");
+        pack::UInt64 allocated   = FIELD("allocated");
+        pack::UInt64 allocations = FIELD("allocations");
+        pack::UInt64 peak        = FIELD("peak");     // highest live bytes of one job
+        pack::UInt64 retained    = FIELD("retained"); // bytes left allocated by the jobs (caches or leaks)
+
+    public:
+        using pack::Node::Node;
+        META(Consumer, subject, target, jobs, allocated, allocations, peak, retained);
+    };
+
+    /// Consumers with the most allocated bytes
+    using Out = pack::ObjectList<Consumer>;
+} // namespace commands::memory
+
+// =====================================================================================================================
+
+namespace commands::inspect {
+    static constexpr const char* Subject = "inspect";
+
+    class In : public pack::Node
+    {
+    public:
+        pack::String subject = FIELD("subject"); // jobs of one subject, all if empty
+
+    public:
+        using pack::Node::Node;
+        META(In, subject);
+    };
+
+    /// One queued or running job, durations are in milliseconds
+    class Job : public pack::Node
+    {
+    public:
+        pack::String subject       = FIELD("subject");
+        pack::String target        = FIELD("target");
+        pack::String correlationId = FIELD("correlation_id");
+        pack::String state         = FIELD("state");  // queued or running
+        pack::String stage         = FIELD("stage");  // what the running job is doing now
+        pack::UInt64 age           = FIELD("age");    // since queued
+        pack::UInt64 busy          = FIELD("busy");   // since started
+        pack::UInt32 thread        = FIELD("thread"); // thread id of the worker
+
+    public:
+        using pack::Node::Node;
+        META(Job, subject, target, correlationId, state, stage, age, busy, thread);
+    };
+
+    /// Queued and running jobs, oldest first
+    using Out = pack::ObjectList<Job>;
+} // namespace commands::inspect
+
+// =====================================================================================================================
+
 } // namespace fty
@@ -1,7 +1,14 @@
 #pragma once
 #include "commands.h"
+#include "inspect.h"
+#include "logger.h"
+#include "memory.h"
 #include "message-bus.h"
 #include "message.h"
+#include "metrics.h"
+#include "probes.h"
+#include "stats.h"
+#include "trace.h"
 #include <fty/expected.h>
 #include <fty/thread-pool.h>
 #include <fty_log.h>
@@ -10,6 +17,75 @@ namespace fty::job {
 
 // =====================================================================================================================
 
+template <typename T, typename = void>
+struct HasAddress : std::false_type
+{
+};
+
+template <typename T>
+struct HasAddress<T, std::void_t<decltype(std::declval<T>().address)>> : std::true_type
+{
+};
+
+/// Device the request is about, memory of jobs is accounted by it
+template <typename InputT>
+std::string target(const InputT& in)
+{
+    if constexpr (HasAddress<InputT>::value) {
+        return in.address.value();
+    } else {
+        return {};
+    }
+}
+
+template <typename T, typename = void>
+struct HasSettings : std::false_type
+{
+};
+
+template <typename T>
+struct HasSettings<T, std::void_t<decltype(std::declval<T>().settings)>> : std::true_type
+{
+};
+
+template <typename T, typename = void>
+struct HasCredential : std::false_type
+{
+};
+
+template <typename T>
+struct HasCredential<T, std::void_t<decltype(std::declval<T>().credentialId)>> : std::true_type
+{
+};
+
+/// Kind of credentials the request uses: `wallet`, `user`, `community`, `default` or empty if it has none
+template <typename InputT>
+std::string credential(const InputT& in)
+{
+    if constexpr (HasSettings<InputT>::value) {
+        if (!in.settings.username.empty()) {
+            return "user";
+        }
+        return credential(in.settings);
+    } else if constexpr (HasCredential<InputT>::value) {
+        if (!in.credentialId.empty()) {
+            return "wallet";
+        }
+        return in.community.empty() ? "default" : "community";
+    } else {
+        return {};
+    }
+}
+
+/// Requests waiting for a worker of the dispatcher
+inline metrics::Gauge& queuedJobs()
+{
+    static auto& gauge = metrics::gauge("fty_discovery_jobs_queued", "Requests waiting for a worker");
+    return gauge;
+}
+
+// =====================================================================================================================
+
 template <typename... Args>
 [[maybe_unused]] static std::string formatString(const std::string& msg, const Args&... args)
 {
@@ -55,6 +131,8 @@ public:
 
     operator Message()
     {
+        stats::Timer timer(stats::Stage::Serialize);
+
         Message msg;
         msg.meta.status = status;
         if (status == Message::Status::Ok) {
@@ -85,12 +163,28 @@ public:
     Task(const Message& in, MessageBus& bus)
         : m_in(in)
         , m_bus(&bus)
+        , m_job(in.meta.subject, in.meta.correlationId)
     {
     }
 
     void operator()() override
     {
+        trace::Context  context(m_in.meta.correlationId);
+        trace::Span     span("request");
+        memory::Scope   scope;
+        stats::Scope    stages;
+        probes::Timer   timer(fty_probe_enabled(job_end));
+        inspect::Active active(m_job);
+
+        queuedJobs().dec();
+        metrics::Track running(metrics::gauge(
+            "fty_discovery_jobs_running", "Requests being processed", {{"subject", m_in.meta.subject.value()}}));
+
+        fty_probe(job_start, m_in.meta.subject.value().c_str(), m_in.meta.correlationId.value().c_str());
+
         Response<ResponseT> response;
+        std::string         device;
+        std::string         cred;
         try {
             if (m_in.userData.empty()) {
                 throw Error("Wrong input data: payload is empty");
@@ -102,29 +196,55 @@ public:
             } else {
                 throw Error("Wrong input data: format of payload is incorrect");
             }
+            device = target(cmd);
+            cred   = credential(cmd);
+            m_job.setTarget(device);
 
             if (auto it = dynamic_cast<T*>(this)){
+                inspect::Stage stage("running");
                 it->run(cmd, response.out);
             } else {
                 throw Error("Not a correct task");
             }
 
             response.status = Message::Status::Ok;
+            inspect::Stage stage("replying");
             if (auto res = m_bus->reply(fty::Channel, m_in, response); !res) {
                 log_error(res.error().c_str());
             }
         } catch (const Error& err) {
             log_error("Error: %s", err.what());
             response.setError(err.what());
+            inspect::Stage stage("replying");
             if (auto res = m_bus->reply(fty::Channel, m_in, response); !res) {
                 log_error(res.error().c_str());
             }
         }
+
+        fty_probe(job_end, m_in.meta.subject.value().c_str(), m_in.meta.correlationId.value().c_str(), device.c_str(),
+            timer.micros(), int(response.status == Message::Status::Ok));
+
+        const char* status = response.status == Message::Status::Ok ? "ok" : "error";
+        metrics::counter("fty_discovery_jobs_total", "Processed requests",
+            {{"subject", m_in.meta.subject.value()}, {"status", status}})
+            .inc();
+
+        stats::logSlow(stages, m_in.meta.subject, device, m_in.meta.correlationId, cred,
+            response.status == Message::Status::Ok);
+
+        if (memory::enabled()) {
+            const auto& usage = scope.finish();
+            memory::account(m_in.meta.subject, device, usage);
+            slog_debug("Job: memory", {{"subject", m_in.meta.subject.value()}, {"target", device},
+                {"allocated", usage.allocated}, {"allocations", usage.allocations}, {"peak", usage.peak},
+                {"retained", usage.live()}});
+        }
     }
 
 protected:
-    Message     m_in;
-    MessageBus* m_bus;
+    Message      m_in;
+    MessageBus*  m_bus;
+    inspect::Job m_job;
 };
 
 } // namespace fty::job
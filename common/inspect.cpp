@@ -0,0 +1,193 @@
+/*  =========================================================================
+    inspect.cpp - Live introspection of queued and running jobs
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "inspect.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fty::inspect {
+
+// =====================================================================================================================
+
+using Clock = std::chrono::steady_clock;
+
+/// Immutable fields are set before registration, the rest is accessed atomically
+struct Job::State
+{
+    uint64_t                           id      = 0; // 0 if not registered
+    std::string                        subject;
+    std::string                        correlationId;
+    Clock::time_point                  queued;
+    std::atomic<int64_t>               started = 0; // steady clock ticks, 0 if queued
+    std::atomic<uint32_t>              thread  = 0;
+    std::shared_ptr<const std::string> target;      // std::atomic_load/store only
+    std::shared_ptr<const std::string> stage;       // std::atomic_load/store only
+};
+
+namespace {
+
+    class Registry
+    {
+    public:
+        static Registry& instance()
+        {
+            static Registry inst;
+            return inst;
+        }
+
+        uint64_t add(std::shared_ptr<Job::State> state)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            uint64_t                    id = ++m_last;
+            m_jobs.emplace(id, std::move(state));
+            return id;
+        }
+
+        void remove(uint64_t id)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.erase(id);
+        }
+
+        std::vector<std::shared_ptr<Job::State>> all() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            std::vector<std::shared_ptr<Job::State>> out;
+            out.reserve(m_jobs.size());
+            for (const auto& [id, state] : m_jobs) {
+                out.push_back(state);
+            }
+            return out;
+        }
+
+    private:
+        mutable std::mutex                              m_mutex;
+        std::map<uint64_t, std::shared_ptr<Job::State>> m_jobs;
+        uint64_t                                        m_last = 0;
+    };
+
+    uint32_t threadId()
+    {
+        thread_local uint32_t id = uint32_t(syscall(SYS_gettid));
+        return id;
+    }
+
+    uint64_t millis(Clock::duration duration)
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+    }
+
+} // namespace
+
+/// Job running on the thread
+static thread_local Job::State* t_current = nullptr;
+
+// =====================================================================================================================
+
+std::vector<Info> jobs()
+{
+    auto now = Clock::now();
+
+    std::vector<Info> out;
+    for (const auto& state : Registry::instance().all()) {
+        Info info;
+        info.subject       = state->subject;
+        info.correlationId = state->correlationId;
+        info.age           = millis(now - state->queued);
+        if (auto target = std::atomic_load(&state->target)) {
+            info.target = *target;
+        }
+        if (auto stage = std::atomic_load(&state->stage)) {
+            info.stage = *stage;
+        }
+        if (int64_t started = state->started.load(std::memory_order_acquire)) {
+            info.running = true;
+            info.busy    = millis(now - Clock::time_point(Clock::duration(started)));
+            info.thread  = state->thread.load(std::memory_order_relaxed);
+        }
+        out.push_back(std::move(info));
+    }
+    return out;
+}
+
+// =====================================================================================================================
+
+Job::Job(const std::string& subject, const std::string& correlationId)
+    : m_state(std::make_shared<State>())
+{
+    m_state->subject       = subject;
+    m_state->correlationId = correlationId;
+    m_state->queued        = Clock::now();
+    m_state->id            = subject.empty() ? 0 : Registry::instance().add(m_state);
+}
+
+Job::~Job()
+{
+    if (m_state->id) {
+        Registry::instance().remove(m_state->id);
+    }
+}
+
+void Job::setTarget(const std::string& target)
+{
+    std::atomic_store(&m_state->target, std::make_shared<const std::string>(target));
+}
+
+// =====================================================================================================================
+
+Active::Active(Job& job)
+    : m_outer(t_current)
+{
+    if (!job.m_state->id) {
+        return;
+    }
+    job.m_state->thread.store(threadId(), std::memory_order_relaxed);
+    job.m_state->started.store(Clock::now().time_since_epoch().count(), std::memory_order_release);
+    t_current = job.m_state.get();
+}
+
+Active::~Active()
+{
+    t_current = m_outer;
+}
+
+// =====================================================================================================================
+
+bool active()
+{
+    return t_current != nullptr;
+}
+
+std::shared_ptr<const std::string> setStage(std::shared_ptr<const std::string> stage)
+{
+    if (!t_current) {
+        return {};
+    }
+    return std::atomic_exchange(&t_current->stage, std::move(stage));
+}
+
+// =====================================================================================================================
+
+} // namespace fty::inspect
@@ -0,0 +1,129 @@
+/*  =========================================================================
+    inspect.h - Live introspection of queued and running jobs
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <fmt/format.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fty::inspect {
+
+// =====================================================================================================================
+
+/// Snapshot of one job
+struct Info
+{
+    std::string subject;
+    std::string target;
+    std::string correlationId;
+    std::string stage;
+    bool        running = false;
+    uint64_t    age     = 0; // milliseconds since queued
+    uint64_t    busy    = 0; // milliseconds since started
+    uint32_t    thread  = 0; // thread id of the worker, 0 if queued
+};
+
+/// All registered jobs, oldest first.
+/// Only the registry lock is taken (held by jobs just to register and unregister), everything the jobs change
+/// while running is read atomically.
+std::vector<Info> jobs();
+
+// =====================================================================================================================
+
+/// Job registered for introspection from creation (queued) to destruction.
+/// Job without subject (run directly by another job) is not registered, its stages are reported on the outer job.
+class Job
+{
+public:
+    Job(const std::string& subject, const std::string& correlationId);
+    ~Job();
+
+    Job(const Job&) = delete;
+    Job& operator=(const Job&) = delete;
+
+    /// Sets the device the job is about
+    void setTarget(const std::string& target);
+
+public:
+    struct State;
+
+private:
+    friend class Active;
+    std::shared_ptr<State> m_state;
+};
+
+/// Marks the job running on the current thread, stages of the thread are reported on it while in scope
+class Active
+{
+public:
+    explicit Active(Job& job);
+    ~Active();
+
+    Active(const Active&) = delete;
+    Active& operator=(const Active&) = delete;
+
+private:
+    Job::State* m_outer;
+};
+
+// =====================================================================================================================
+
+/// Checks if the current thread runs a registered job
+bool active();
+
+/// Sets stage of the job running on the current thread, returns previous one
+std::shared_ptr<const std::string> setStage(std::shared_ptr<const std::string> stage);
+
+/// Current stage of the job running on the thread while in scope, the previous stage is restored after.
+/// Text is formatted only when the thread runs a registered job.
+class Stage
+{
+public:
+    template <typename... Args>
+    explicit Stage(const char* format, const Args&... args)
+    {
+        if (active()) {
+            m_previous = setStage(std::make_shared<const std::string>(fmt::format(format, args...)));
+            m_set      = true;
+        }
+    }
+
+    ~Stage()
+    {
+        if (m_set) {
+            setStage(std::move(m_previous));
+        }
+    }
+
+    Stage(const Stage&) = delete;
+    Stage& operator=(const Stage&) = delete;
+
+private:
+    std::shared_ptr<const std::string> m_previous;
+    bool                               m_set = false;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::inspect
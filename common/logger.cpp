@@ -0,0 +1,380 @@
+/*  =========================================================================
+    logger.cpp - Asynchronous structured logging
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "logger.h"
+#include <chrono>
+#include <condition_variable>
+#include <fty_log.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fty::logger {
+
+// =====================================================================================================================
+
+bool enabled(Level level)
+{
+    Ftylog* log = ManageFtyLog::getInstanceFtylog();
+    switch (level) {
+        case Level::Trace:
+            return log->isLogTrace();
+        case Level::Debug:
+            return log->isLogDebug();
+        case Level::Info:
+            return log->isLogInfo();
+        case Level::Warning:
+            return log->isLogWarning();
+        case Level::Error:
+            return log->isLogError();
+        case Level::Fatal:
+            return log->isLogFatal();
+    }
+    return false;
+}
+
+std::string format(const char* message, std::initializer_list<Field> fields)
+{
+    std::string out = message;
+    for (const auto& field : fields) {
+        out += ' ';
+        out += field.key;
+        out += '=';
+        if (field.value.empty() || field.value.find_first_of(" \t\n\"=") != std::string::npos) {
+            // Quote values which would break key=value parsing
+            out += '"';
+            for (char ch : field.value) {
+                if (ch == '"' || ch == '\\') {
+                    out += '\\';
+                    out += ch;
+                } else if (ch == '\n') {
+                    out += "\\n";
+                } else {
+                    out += ch;
+                }
+            }
+            out += '"';
+        } else {
+            out += field.value;
+        }
+    }
+    return out;
+}
+
+// =====================================================================================================================
+
+static std::atomic<uint32_t> rateLimit = 0;
+
+bool Site::allow()
+{
+    return allow(rateLimit.load(std::memory_order_relaxed));
+}
+
+bool Site::allow(uint32_t limit)
+{
+    if (!limit) {
+        return true;
+    }
+
+    auto now = uint64_t(
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+
+    uint64_t window = m_window.load(std::memory_order_relaxed);
+    if (window != now && m_window.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+        m_count.store(0, std::memory_order_relaxed);
+    }
+
+    if (m_count.fetch_add(1, std::memory_order_relaxed) < limit) {
+        return true;
+    }
+    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+uint32_t Site::takeSuppressed()
+{
+    return m_suppressed.exchange(0, std::memory_order_relaxed);
+}
+
+// =====================================================================================================================
+// Queue
+// =====================================================================================================================
+
+namespace {
+
+    struct Record
+    {
+        Site*       site = nullptr;
+        std::string text;
+    };
+
+    /// Bounded lock free multi producer, single consumer ring
+    class Ring
+    {
+    public:
+        explicit Ring(size_t capacity)
+            : m_mask(capacity - 1)
+            , m_slots(new Slot[capacity])
+        {
+            for (size_t i = 0; i < capacity; ++i) {
+                m_slots[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool push(Record&& record)
+        {
+            size_t pos = m_tail.load(std::memory_order_relaxed);
+            Slot*  slot;
+            for (;;) {
+                slot        = &m_slots[pos & m_mask];
+                size_t seq  = slot->seq.load(std::memory_order_acquire);
+                auto   diff = intptr_t(seq) - intptr_t(pos);
+                if (diff == 0) {
+                    if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+            slot->record = std::move(record);
+            slot->seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t capacity() const
+        {
+            return m_mask + 1;
+        }
+
+        bool pop(Record& record)
+        {
+            Slot* slot = &m_slots[m_head & m_mask];
+            if (slot->seq.load(std::memory_order_acquire) != m_head + 1) {
+                return false;
+            }
+            record = std::move(slot->record);
+            slot->seq.store(m_head + m_mask + 1, std::memory_order_release);
+            ++m_head;
+            return true;
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> seq;
+            Record              record;
+        };
+
+        size_t                  m_mask;
+        std::unique_ptr<Slot[]> m_slots;
+        alignas(64) std::atomic<size_t> m_tail = 0;
+        alignas(64) size_t m_head              = 0;
+    };
+
+    class Writer
+    {
+    public:
+        static Writer& instance()
+        {
+            static Writer inst;
+            return inst;
+        }
+
+        void start(size_t capacity)
+        {
+            stop();
+
+            size_t size = 1;
+            while (size < capacity) {
+                size <<= 1;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            Ring* ring = nullptr;
+            for (const auto& it : m_rings) {
+                if (it->capacity() == size) {
+                    ring = it.get();
+                }
+            }
+            if (!ring) {
+                ring = m_rings.emplace_back(std::make_unique<Ring>(size)).get();
+            }
+
+            m_stop = false;
+            m_ring.store(ring, std::memory_order_release);
+            m_thread  = std::thread(&Writer::loop, this);
+            m_running = true;
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_running) {
+                    return;
+                }
+                m_running = false;
+                m_stop    = true;
+            }
+            // Following records are written synchronously, the ring stays for producers which already got it
+            m_ring.store(nullptr, std::memory_order_release);
+            m_cv.notify_all();
+            m_thread.join();
+            drain();
+        }
+
+        bool push(Record&& record)
+        {
+            Ring* ring = m_ring.load(std::memory_order_acquire);
+            if (!ring) {
+                emit(record);
+                return true;
+            }
+            if (!ring->push(std::move(record))) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                m_droppedTotal.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        uint64_t dropped() const
+        {
+            return m_droppedTotal.load(std::memory_order_relaxed);
+        }
+
+    private:
+        void loop()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_stop) {
+                lock.unlock();
+                bool any = drain();
+                lock.lock();
+                if (!any) {
+                    // Producers never wait for the writer, so it polls
+                    m_cv.wait_for(lock, std::chrono::milliseconds(20));
+                }
+            }
+        }
+
+        bool drain()
+        {
+            // Rings are drained only by the writer thread or by stop after the thread is joined
+            bool   any = false;
+            Record record;
+            for (const auto& ring : m_rings) {
+                while (ring->pop(record)) {
+                    emit(record);
+                    any = true;
+                }
+            }
+
+            if (uint64_t lost = m_dropped.exchange(0, std::memory_order_relaxed)) {
+                log_warning("Logger: %llu records dropped, queue is full", static_cast<unsigned long long>(lost));
+            }
+            return any;
+        }
+
+        static void emit(Record& record)
+        {
+            Site& site = *record.site;
+            if (uint32_t suppressed = site.takeSuppressed()) {
+                record.text += " suppressed=" + std::to_string(suppressed);
+            }
+
+            int level = log4cplus::TRACE_LOG_LEVEL;
+            switch (site.level()) {
+                case Level::Trace:
+                    level = log4cplus::TRACE_LOG_LEVEL;
+                    break;
+                case Level::Debug:
+                    level = log4cplus::DEBUG_LOG_LEVEL;
+                    break;
+                case Level::Info:
+                    level = log4cplus::INFO_LOG_LEVEL;
+                    break;
+                case Level::Warning:
+                    level = log4cplus::WARN_LOG_LEVEL;
+                    break;
+                case Level::Error:
+                    level = log4cplus::ERROR_LOG_LEVEL;
+                    break;
+                case Level::Fatal:
+                    level = log4cplus::FATAL_LOG_LEVEL;
+                    break;
+            }
+            ManageFtyLog::getInstanceFtylog()->insertLog(
+                level, site.file(), site.line(), site.func(), "%s", record.text.c_str());
+        }
+
+    private:
+        std::mutex                         m_mutex;
+        std::condition_variable            m_cv;
+        std::thread                        m_thread;
+        std::atomic<Ring*>                 m_ring         = nullptr; // current ring, null if writing synchronously
+        std::vector<std::unique_ptr<Ring>> m_rings;                  // never freed, producers may still hold old one
+        bool                               m_stop         = true;
+        bool                               m_running      = false;
+        std::atomic<uint64_t>              m_dropped      = 0;       // since the last warning
+        std::atomic<uint64_t>              m_droppedTotal = 0;       // since start, exported as counter
+    };
+
+} // namespace
+
+// =====================================================================================================================
+
+void start(size_t capacity, uint32_t rate)
+{
+    rateLimit = rate;
+    if (capacity) {
+        Writer::instance().start(capacity);
+    } else {
+        Writer::instance().stop();
+    }
+}
+
+void stop()
+{
+    Writer::instance().stop();
+}
+
+void write(Site& site, std::string&& text)
+{
+    Record record;
+    record.site = &site;
+    record.text = std::move(text);
+    Writer::instance().push(std::move(record));
+}
+
+uint64_t dropped()
+{
+    return Writer::instance().dropped();
+}
+
+// =====================================================================================================================
+
+} // namespace fty::logger
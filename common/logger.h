@@ -0,0 +1,149 @@
+/*  =========================================================================
+    logger.h - Asynchronous structured logging
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <atomic>
+#include <initializer_list>
+#include <string>
+#include <type_traits>
+
+namespace fty::logger {
+
+// =====================================================================================================================
+
+enum class Level
+{
+    Trace,
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Fatal
+};
+
+/// Checks if level is enabled in ftylog configuration
+bool enabled(Level level);
+
+// =====================================================================================================================
+
+/// Structured field of the record, rendered as `key=value`
+struct Field
+{
+    Field(const char* k, const std::string& v)
+        : key(k)
+        , value(v)
+    {
+    }
+
+    Field(const char* k, const char* v)
+        : key(k)
+        , value(v ? v : "")
+    {
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    Field(const char* k, T v)
+        : key(k)
+        , value(std::to_string(v))
+    {
+    }
+
+    const char* key;
+    std::string value;
+};
+
+/// Renders message with fields
+std::string format(const char* message, std::initializer_list<Field> fields = {});
+
+// =====================================================================================================================
+
+/// Place in the code which logs, keeps rate limit state of the place
+class Site
+{
+public:
+    constexpr Site(Level level, const char* file, int line, const char* func)
+        : m_level(level)
+        , m_file(file)
+        , m_line(line)
+        , m_func(func)
+    {
+    }
+
+    /// Checks rate limit, returns false if record should be dropped
+    bool allow();
+
+    /// Checks limit of `limit` records per second (0 is unlimited)
+    bool allow(uint32_t limit);
+
+    /// Count of records dropped since the last allowed one
+    uint32_t takeSuppressed();
+
+    Level       level() const { return m_level; }
+    const char* file() const { return m_file; }
+    int         line() const { return m_line; }
+    const char* func() const { return m_func; }
+
+private:
+    Level                 m_level;
+    const char*           m_file;
+    int                   m_line;
+    const char*           m_func;
+    std::atomic<uint64_t> m_window     = 0;
+    std::atomic<uint32_t> m_count      = 0;
+    std::atomic<uint32_t> m_suppressed = 0;
+};
+
+// =====================================================================================================================
+
+/// Starts background writer with the queue of `capacity` records (rounded up to power of two), `rate` is the limit
+/// of records per second from one site (0 is unlimited). Without writer records are written synchronously.
+void start(size_t capacity, uint32_t rate);
+
+/// Writes queued records and stops background writer
+void stop();
+
+/// Queues the record (or writes it if writer is not started)
+void write(Site& site, std::string&& text);
+
+/// Count of records dropped because queue was full since start, never decreases
+uint64_t dropped();
+
+// =====================================================================================================================
+
+} // namespace fty::logger
+
+/// Structured logging, `slog_debug("Got message", {{"subject", subject}, {"size", size}})`.
+/// Arguments are evaluated and formatted only if the level is enabled, record is written by background thread.
+// clang-format off
+#define slog_at(lvl, ...)                                                                                              \
+    do {                                                                                                               \
+        static fty::logger::Site slogSite_(lvl, __FILE__, __LINE__, __func__);                                         \
+        if (fty::logger::enabled(lvl) && slogSite_.allow()) {                                                          \
+            fty::logger::write(slogSite_, fty::logger::format(__VA_ARGS__));                                           \
+        }                                                                                                              \
+    } while (false)
+
+#define slog_trace(...)   slog_at(fty::logger::Level::Trace, __VA_ARGS__)
+#define slog_debug(...)   slog_at(fty::logger::Level::Debug, __VA_ARGS__)
+#define slog_info(...)    slog_at(fty::logger::Level::Info, __VA_ARGS__)
+#define slog_warning(...) slog_at(fty::logger::Level::Warning, __VA_ARGS__)
+#define slog_error(...)   slog_at(fty::logger::Level::Error, __VA_ARGS__)
+// clang-format on
@@ -0,0 +1,172 @@
+/*  =========================================================================
+    memory.cpp - Per job memory accounting
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "memory.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <map>
+#include <mutex>
+
+namespace fty::memory {
+
+// =====================================================================================================================
+
+/// Consumers beyond this count are summed as target `*`
+static constexpr size_t MaxConsumers = 1024;
+
+static std::atomic<bool> g_enabled = true;
+
+/// Usage of the current thread scope, constant initialized, so it is usable by operator new at any time
+static thread_local Usage* t_usage = nullptr;
+
+struct Consumers
+{
+    std::mutex                                               mutex;
+    std::map<std::pair<std::string, std::string>, Consumer> list;
+};
+
+static Consumers& consumers()
+{
+    static Consumers inst;
+    return inst;
+}
+
+// =====================================================================================================================
+
+uint64_t Usage::live() const
+{
+    return allocated > freed ? allocated - freed : 0;
+}
+
+void enable(bool enabled)
+{
+    g_enabled = enabled;
+}
+
+bool enabled()
+{
+    return g_enabled;
+}
+
+void account(const std::string& subject, const std::string& target, const Usage& usage)
+{
+    auto&                       cons = consumers();
+    std::lock_guard<std::mutex> lock(cons.mutex);
+
+    auto key = std::make_pair(subject, target);
+    auto it  = cons.list.find(key);
+    if (it == cons.list.end()) {
+        if (cons.list.size() >= MaxConsumers) {
+            key.second = "*";
+        }
+        it                 = cons.list.try_emplace(key).first;
+        it->second.subject = key.first;
+        it->second.target  = key.second;
+    }
+
+    auto& con = it->second;
+    con.jobs++;
+    con.allocated += usage.allocated;
+    con.allocations += usage.allocations;
+    con.peak = std::max(con.peak, usage.peak);
+    con.retained += usage.live();
+}
+
+std::vector<Consumer> top(size_t count)
+{
+    std::vector<Consumer> list;
+    {
+        auto&                       cons = consumers();
+        std::lock_guard<std::mutex> lock(cons.mutex);
+        for (const auto& [key, con] : cons.list) {
+            list.push_back(con);
+        }
+    }
+
+    std::sort(list.begin(), list.end(), [](const Consumer& l, const Consumer& r) {
+        return l.allocated > r.allocated;
+    });
+    list.resize(std::min(list.size(), count));
+    return list;
+}
+
+void reset()
+{
+    auto&                       cons = consumers();
+    std::lock_guard<std::mutex> lock(cons.mutex);
+    cons.list.clear();
+}
+
+// =====================================================================================================================
+
+Scope::Scope()
+{
+    if (g_enabled) {
+        m_previous = t_usage;
+        t_usage    = &m_usage;
+        m_active   = true;
+    }
+}
+
+Scope::~Scope()
+{
+    finish();
+}
+
+const Usage& Scope::finish()
+{
+    if (m_active) {
+        t_usage  = m_previous;
+        m_active = false;
+    }
+    return m_usage;
+}
+
+// =====================================================================================================================
+
+namespace detail {
+
+    void* allocate(std::size_t size) noexcept
+    {
+        void* ptr = std::malloc(size ? size : 1);
+        if (ptr && t_usage) {
+            t_usage->allocated += malloc_usable_size(ptr);
+            t_usage->allocations++;
+            t_usage->peak = std::max(t_usage->peak, t_usage->live());
+        }
+        return ptr;
+    }
+
+    void release(void* ptr) noexcept
+    {
+        if (ptr && t_usage) {
+            t_usage->freed += malloc_usable_size(ptr);
+        }
+        std::free(ptr);
+    }
+
+} // namespace detail
+
+// =====================================================================================================================
+
+} // namespace fty::memory
@@ -0,0 +1,107 @@
+/*  =========================================================================
+    memory.h - Per job memory accounting
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fty::memory {
+
+// =====================================================================================================================
+
+/// Allocations made by one thread in @ref Scope, sizes are usable sizes of the blocks in bytes
+struct Usage
+{
+    uint64_t allocated   = 0;
+    uint64_t freed       = 0; // blocks allocated before the scope count as well
+    uint64_t allocations = 0;
+    uint64_t peak        = 0; // highest allocated minus freed
+
+    /// Bytes allocated in the scope and still alive
+    uint64_t live() const;
+};
+
+/// Aggregated usage of all jobs of one subject and target
+struct Consumer
+{
+    std::string subject;
+    std::string target;
+    uint64_t    jobs        = 0;
+    uint64_t    allocated   = 0;
+    uint64_t    allocations = 0;
+    uint64_t    peak        = 0; // highest peak of one job
+    uint64_t    retained    = 0; // sum of bytes left alive by the jobs
+};
+
+// =====================================================================================================================
+
+/// Enables accounting of new scopes. Allocations of the thread in scope are counted by global operator new of
+/// executables linked with `allocator.cpp`, elsewhere scopes stay empty.
+void enable(bool enabled);
+
+/// Checks if accounting is enabled
+bool enabled();
+
+/// Adds usage of one job
+void account(const std::string& subject, const std::string& target, const Usage& usage);
+
+/// Consumers with the most allocated bytes, at most `count`
+std::vector<Consumer> top(size_t count);
+
+/// Clears all consumers
+void reset();
+
+// =====================================================================================================================
+
+/// Counts allocations of the current thread until finished. Nested scope suspends the outer one.
+class Scope
+{
+public:
+    Scope();
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    /// Stops counting, following allocations of the thread go to the outer scope
+    const Usage& finish();
+
+private:
+    Usage  m_usage;
+    Usage* m_previous = nullptr;
+    bool   m_active   = false;
+};
+
+// =====================================================================================================================
+
+namespace detail {
+    /// Allocates and counts the block in the scope of the thread, null if out of memory
+    void* allocate(std::size_t size) noexcept;
+
+    /// Counts and frees the block
+    void release(void* ptr) noexcept;
+} // namespace detail
+
+// =====================================================================================================================
+
+} // namespace fty::memory
@@ -21,8 +21,10 @@
 
 #include "message-bus.h"
 #include "message.h"
+#include "probes.h"
+#include "stats.h"
+#include "transport.h"
 #include <fty_log.h>
-#include <fty_common_messagebus_exception.h>
 #include <fty_common_messagebus_interface.h>
 #include <fty_common_messagebus_message.h>
 
@@ -30,17 +32,15 @@ namespace fty {
 
 MessageBus::MessageBus() = default;
 
-Expected<void> MessageBus::init(const std::string& actorName)
+Expected<void> MessageBus::init(const std::string& actorName, const std::string& endpoint)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
-    try {
-        m_bus = std::unique_ptr<messagebus::MessageBus>(messagebus::MlmMessageBus(endpoint, actorName));
-        m_bus->connect();
-        m_actorName = actorName;
-        return {};
-    } catch (std::exception& ex) {
-        return unexpected(ex.what());
+    m_bus = Transport::create(endpoint, actorName);
+    if (auto res = m_bus->connect(); !res) {
+        return unexpected(res.error());
     }
+    m_actorName = actorName;
+    return {};
 }
 
 MessageBus::~MessageBus()
@@ -54,15 +54,27 @@ Expected<Message> MessageBus::send(const std::string& queue, const Message& msg)
         msg.meta.correlationId = messagebus::generateUuid();
     }
     msg.meta.from = m_actorName;
-    try {
-        Message m(m_bus->request(queue, msg.toMessageBus(), 10000));
-        if (m.meta.status == Message::Status::Error) {
-            return unexpected(*m.userData.decode<std::string>());
+
+    stats::Timer timer(stats::Stage::BusRequest);
+    if (auto m = m_bus->request(queue, msg, 10000)) {
+        if (m->meta.status == Message::Status::Error) {
+            return unexpected(*m->userData.decode<std::string>());
         }
-        return Expected<Message>(m);
-    } catch (messagebus::MessageBusException& ex) {
-        return unexpected(ex.what());
+        return m;
+    } else {
+        timer.fail();
+        return unexpected(m.error());
+    }
+}
+
+Expected<void> MessageBus::notify(const std::string& queue, const Message& msg)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (msg.meta.correlationId.empty()) {
+        msg.meta.correlationId = messagebus::generateUuid();
     }
+    msg.meta.from = m_actorName;
+    return m_bus->sendRequest(queue, msg);
 }
 
 Expected<void> MessageBus::reply(const std::string& queue, const Message& req, const Message& answ)
@@ -73,37 +85,39 @@ Expected<void> MessageBus::reply(const std::string& queue, const Message& req, c
     answ.meta.to            = req.meta.from;
     answ.meta.from          = req.meta.to;
 
-    try {
-        m_bus->sendReply(queue, answ.toMessageBus());
-        return {};
-    } catch (messagebus::MessageBusException& ex) {
-        return unexpected(ex.what());
-    }
+    probes::Timer timer(fty_probe_enabled(bus_reply));
+    auto          res = stats::measure(stats::Stage::BusReply, [&]() {
+        return m_bus->sendReply(queue, answ);
+    });
+
+    fty_probe(bus_reply, req.meta.subject.value().c_str(), answ.meta.to.value().c_str(),
+        answ.meta.correlationId.value().c_str(), timer.micros(), int(bool(res)));
+    return res;
 }
 
 Expected<Message> MessageBus::recieve(const std::string& queue)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     Message                     ret;
-    try {
-        m_bus->receive(queue, [&ret](const messagebus::Message& msg) {
-            ret = Message(msg);
+    if (auto res = m_bus->receive(queue, [&ret](const Message& msg) {
+            ret = msg;
         });
-        return Expected<Message>(ret);
-    } catch (messagebus::MessageBusException& ex) {
-        return unexpected(ex.what());
+        !res) {
+        return unexpected(res.error());
     }
+    return Expected<Message>(ret);
 }
 
-Expected<void> MessageBus::subsribe(const std::string& queue, std::function<void(const messagebus::Message&)>&& func)
+Expected<void> MessageBus::recieve(const std::string& queue, std::function<void(const Message&)>&& func)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
-    try {
-        m_bus->subscribe(queue, func);
-        return {};
-    } catch (messagebus::MessageBusException& ex) {
-        return unexpected(ex.what());
-    }
+    return m_bus->receive(queue, std::move(func));
+}
+
+Expected<void> MessageBus::subsribe(const std::string& queue, std::function<void(const Message&)>&& func)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bus->subscribe(queue, std::move(func));
 }
 
 } // namespace fty
@@ -27,15 +27,10 @@
 
 // =====================================================================================================================
 
-namespace messagebus {
-class MessageBus;
-class Message;
-} // namespace messagebus
-
-// =====================================================================================================================
-
 namespace fty {
 
+class Transport;
+
 /// Common message bus temporary wrapper
 class MessageBus
 {
@@ -46,27 +41,38 @@ public:
     MessageBus();
     ~MessageBus();
 
-    [[nodiscard]] Expected<void> init(const std::string& actorName);
+    /// Connects to the bus, transport is choosen by endpoint scheme (see @ref Transport)
+    [[nodiscard]] Expected<void> init(const std::string& actorName, const std::string& endpoint = MessageBus::endpoint);
 
     [[nodiscard]] Expected<Message> send(const std::string& queue, const Message& msg);
+    [[nodiscard]] Expected<void>    notify(const std::string& queue, const Message& msg);
     [[nodiscard]] Expected<void>    reply(const std::string& queue, const Message& req, const Message& answ);
     [[nodiscard]] Expected<Message> recieve(const std::string& queue);
 
+    template <typename Func, typename Cls>
+    [[nodiscard]] Expected<void> recieve(const std::string& queue, Func&& fnc, Cls* cls)
+    {
+        return recieve(queue, [f = std::move(fnc), c = cls](const Message& msg) -> void {
+            std::invoke(f, *c, msg);
+        });
+    }
+
     template <typename Func, typename Cls>
     [[nodiscard]] Expected<void> subsribe(const std::string& queue, Func&& fnc, Cls* cls)
     {
-        return subsribe(queue, [f = std::move(fnc), c = cls](const messagebus::Message& msg) -> void {
-            std::invoke(f, *c, Message(msg));
+        return subsribe(queue, [f = std::move(fnc), c = cls](const Message& msg) -> void {
+            std::invoke(f, *c, msg);
         });
     }
 
 private:
-    Expected<void> subsribe(const std::string& queue, std::function<void(const messagebus::Message&)>&& func);
+    Expected<void> subsribe(const std::string& queue, std::function<void(const Message&)>&& func);
+    Expected<void> recieve(const std::string& queue, std::function<void(const Message&)>&& func);
 
 private:
-    std::unique_ptr<messagebus::MessageBus> m_bus;
-    std::mutex                              m_mutex;
-    std::string                             m_actorName;
+    std::unique_ptr<Transport> m_bus;
+    std::mutex                 m_mutex;
+    std::string                m_actorName;
 };
 
 } // namespace fty
@@ -0,0 +1,214 @@
+/*  =========================================================================
+    metrics.cpp - Counters and gauges exported in Prometheus text format
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "metrics.h"
+#include "stats.h"
+#include <fmt/format.h>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace fty::metrics {
+
+// =====================================================================================================================
+
+namespace {
+
+    enum class Type
+    {
+        Counter,
+        Gauge
+    };
+
+    struct Family
+    {
+        std::string                                     help;
+        Type                                            type;
+        std::map<std::string, std::unique_ptr<Counter>> counters; // by rendered labels
+        std::map<std::string, std::unique_ptr<Gauge>>   gauges;
+        std::function<double()>                         read;
+    };
+
+    struct Registry
+    {
+        std::mutex                    mutex;
+        std::map<std::string, Family> families;
+
+        static Registry& instance()
+        {
+            static Registry inst;
+            return inst;
+        }
+    };
+
+} // namespace
+
+static std::string escape(const std::string& value)
+{
+    std::string out;
+    out.reserve(value.size());
+    for (char ch : value) {
+        if (ch == '\\' || ch == '"') {
+            out += '\\';
+            out += ch;
+        } else if (ch == '\n') {
+            out += "\\n";
+        } else {
+            out += ch;
+        }
+    }
+    return out;
+}
+
+static std::string format(const Labels& labels)
+{
+    if (labels.empty()) {
+        return {};
+    }
+
+    std::string out = "{";
+    for (const auto& [name, value] : labels) {
+        if (out.size() > 1) {
+            out += ',';
+        }
+        out += name + "=\"" + escape(value) + "\"";
+    }
+    return out + "}";
+}
+
+template <typename T>
+static T& series(Type type, const std::string& name, const std::string& help, const Labels& labels,
+    std::map<std::string, std::unique_ptr<T>> Family::*member)
+{
+    auto&                       reg = Registry::instance();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    auto& family = reg.families[name];
+    if (family.help.empty()) {
+        family.help = help;
+        family.type = type;
+    }
+
+    auto& ptr = (family.*member)[format(labels)];
+    if (!ptr) {
+        ptr = std::make_unique<T>();
+    }
+    return *ptr;
+}
+
+// =====================================================================================================================
+
+Counter& counter(const std::string& name, const std::string& help, const Labels& labels)
+{
+    return series(Type::Counter, name, help, labels, &Family::counters);
+}
+
+Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels)
+{
+    return series(Type::Gauge, name, help, labels, &Family::gauges);
+}
+
+Counter& cacheLookups(const std::string& cache, bool hit)
+{
+    return counter("fty_discovery_cache_lookups_total", "Lookups of discovery caches",
+        {{"cache", cache}, {"result", hit ? "hit" : "miss"}});
+}
+
+void collect(const std::string& name, const std::string& help, bool isCounter, std::function<double()>&& read)
+{
+    auto&                       reg = Registry::instance();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    auto& family = reg.families[name];
+    family.help  = help;
+    family.type  = isCounter ? Type::Counter : Type::Gauge;
+    family.read  = std::move(read);
+}
+
+// =====================================================================================================================
+
+/// Upper bounds of exported histogram buckets in microseconds
+static constexpr uint64_t Bounds[] = {100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000, 10000000,
+    30000000, 60000000};
+
+static void histograms(std::string& out)
+{
+    auto hists = stats::snapshot();
+
+    out += "# HELP fty_discovery_stage_duration_seconds Duration of discovery stages\n";
+    out += "# TYPE fty_discovery_stage_duration_seconds histogram\n";
+    for (size_t stage = 0; stage < hists.size(); ++stage) {
+        const auto& hist = hists[stage];
+        const char* name = stats::name(stats::Stage(stage));
+
+        // Bucket counts up to the bound, exact as long as the bound is the highest value of some bucket
+        uint64_t count = 0;
+        size_t   idx   = 0;
+        for (uint64_t bound : Bounds) {
+            for (; idx < hist.buckets.size() && stats::Histogram::highest(idx) <= bound; ++idx) {
+                count += hist.buckets[idx];
+            }
+            out += fmt::format("fty_discovery_stage_duration_seconds_bucket{{stage=\"{}\",le=\"{}\"}} {}\n", name,
+                double(bound) / 1e6, count);
+        }
+        out += fmt::format("fty_discovery_stage_duration_seconds_bucket{{stage=\"{}\",le=\"+Inf\"}} {}\n", name,
+            hist.count);
+        out += fmt::format("fty_discovery_stage_duration_seconds_sum{{stage=\"{}\"}} {}\n", name,
+            double(hist.sum) / 1e6);
+        out += fmt::format("fty_discovery_stage_duration_seconds_count{{stage=\"{}\"}} {}\n", name, hist.count);
+    }
+
+    out += "# HELP fty_discovery_stage_errors_total Failed discovery stages\n";
+    out += "# TYPE fty_discovery_stage_errors_total counter\n";
+    for (size_t stage = 0; stage < hists.size(); ++stage) {
+        out += fmt::format("fty_discovery_stage_errors_total{{stage=\"{}\"}} {}\n", stats::name(stats::Stage(stage)),
+            hists[stage].errors);
+    }
+}
+
+std::string render()
+{
+    std::string out;
+    {
+        auto&                       reg = Registry::instance();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        for (const auto& [name, family] : reg.families) {
+            out += fmt::format("# HELP {} {}\n", name, family.help);
+            out += fmt::format("# TYPE {} {}\n", name, family.type == Type::Counter ? "counter" : "gauge");
+            for (const auto& [labels, value] : family.counters) {
+                out += fmt::format("{}{} {}\n", name, labels, value->value());
+            }
+            for (const auto& [labels, value] : family.gauges) {
+                out += fmt::format("{}{} {}\n", name, labels, value->value());
+            }
+            if (family.read) {
+                out += fmt::format("{} {}\n", name, family.read());
+            }
+        }
+    }
+    histograms(out);
+    return out;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::metrics
@@ -0,0 +1,120 @@
+/*  =========================================================================
+    metrics.h - Counters and gauges exported in Prometheus text format
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fty::metrics {
+
+// =====================================================================================================================
+
+/// Label names and values of one series
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+/// Monotonic counter, updated with one relaxed atomic add
+class Counter
+{
+public:
+    void inc(uint64_t value = 1)
+    {
+        m_value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const
+    {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> m_value = 0;
+};
+
+/// Current value going up and down
+class Gauge
+{
+public:
+    void inc(int64_t value = 1)
+    {
+        m_value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void dec(int64_t value = 1)
+    {
+        m_value.fetch_sub(value, std::memory_order_relaxed);
+    }
+
+    int64_t value() const
+    {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> m_value = 0;
+};
+
+/// Increments the gauge for the scope
+class Track
+{
+public:
+    explicit Track(Gauge& gauge)
+        : m_gauge(gauge)
+    {
+        m_gauge.inc();
+    }
+
+    ~Track()
+    {
+        m_gauge.dec();
+    }
+
+    Track(const Track&) = delete;
+    Track& operator=(const Track&) = delete;
+
+private:
+    Gauge& m_gauge;
+};
+
+// =====================================================================================================================
+
+/// Counter of the series, created on the first use. The reference is valid until the process exits, sites with
+/// constant labels keep it in a static variable and do not look it up again.
+Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+
+/// Gauge of the series, created on the first use, see @ref counter
+Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+
+/// Lookups of the cache (`fingerprint`, `negative`) by result, hit ratio is hits over all lookups
+Counter& cacheLookups(const std::string& cache, bool hit);
+
+/// Value owned by other component (queue size, dropped records), `read` is called on every scrape
+void collect(const std::string& name, const std::string& help, bool isCounter, std::function<double()>&& read);
+
+/// All metrics and latency histograms of @ref stats stages in Prometheus text exposition format 0.0.4
+std::string render();
+
+// =====================================================================================================================
+
+} // namespace fty::metrics
@@ -0,0 +1,42 @@
+/*  =========================================================================
+    probes.cpp - USDT probes of discovery hot paths
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "probes.h"
+
+#if FTY_PROBES
+
+// Semaphores live in `.probes` section where the tracer finds them by the address recorded in probe notes
+#define fty_probe_define(name) volatile unsigned short fty_probe_semaphore(name) __attribute__((section(".probes"))) = 0
+
+extern "C" {
+fty_probe_define(job_start);
+fty_probe_define(job_end);
+fty_probe_define(snmp_request);
+fty_probe_define(snmp_response);
+fty_probe_define(neon_request);
+fty_probe_define(neon_response);
+fty_probe_define(driver_spawn);
+fty_probe_define(driver_exit);
+fty_probe_define(bus_receive);
+fty_probe_define(bus_reply);
+}
+
+#endif
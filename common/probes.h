@@ -0,0 +1,126 @@
+/*  =========================================================================
+    probes.h - USDT probes of discovery hot paths
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+/// USDT probes of provider `fty_discovery`, for bpftrace or perf on running agent:
+///
+///     bpftrace -e 'usdt:/usr/bin/fty-discovery-ng:fty_discovery:snmp_response { @[str(arg0)] = hist(arg3); }'
+///
+/// | Probe            | Arguments                                                       |
+/// |------------------|-----------------------------------------------------------------|
+/// | `job_start`      | subject, correlation id                                         |
+/// | `job_end`        | subject, correlation id, target, duration (us), ok              |
+/// | `snmp_request`   | address, first oid, oid count                                   |
+/// | `snmp_response`  | address, first oid, oid count, duration (us), ok                |
+/// | `neon_request`   | address, port, path                                             |
+/// | `neon_response`  | address, port, path, duration (us), ok                          |
+/// | `driver_spawn`   | protocol, address, pid                                          |
+/// | `driver_exit`    | protocol, address, pid, exit status, duration (us)              |
+/// | `bus_receive`    | subject, from, correlation id                                   |
+/// | `bus_reply`      | subject, to, correlation id, duration (us), ok                  |
+///
+/// Strings are `const char*`. Probes are built with semaphores: the tracer raises the semaphore of the probe it
+/// attaches to, until then a probe site is a load and a branch not taken, its arguments are not evaluated. Use
+/// `fty_probe_enabled(name)` to guard any work done only for a probe. Without `sys/sdt.h` at build time probes are
+/// compiled out.
+
+#if defined(HAVE_SYS_SDT_H)
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+#define FTY_PROBES 1
+
+#define fty_probe_semaphore(name) fty_discovery_##name##_semaphore
+
+extern "C" {
+extern volatile unsigned short fty_probe_semaphore(job_start);
+extern volatile unsigned short fty_probe_semaphore(job_end);
+extern volatile unsigned short fty_probe_semaphore(snmp_request);
+extern volatile unsigned short fty_probe_semaphore(snmp_response);
+extern volatile unsigned short fty_probe_semaphore(neon_request);
+extern volatile unsigned short fty_probe_semaphore(neon_response);
+extern volatile unsigned short fty_probe_semaphore(driver_spawn);
+extern volatile unsigned short fty_probe_semaphore(driver_exit);
+extern volatile unsigned short fty_probe_semaphore(bus_receive);
+extern volatile unsigned short fty_probe_semaphore(bus_reply);
+}
+
+#define fty_probe_enabled(name) __builtin_expect(fty_probe_semaphore(name) != 0, 0)
+#define fty_probe(name, ...)                                                                                           \
+    do {                                                                                                               \
+        if (fty_probe_enabled(name)) {                                                                                 \
+            STAP_PROBEV(fty_discovery, name, __VA_ARGS__);                                                             \
+        }                                                                                                              \
+    } while (0)
+#else
+#define FTY_PROBES 0
+#define fty_probe_enabled(name) false
+#define fty_probe(...)                                                                                                 \
+    do {                                                                                                               \
+    } while (0)
+#endif
+
+namespace fty::probes {
+
+// =====================================================================================================================
+
+/// Start of the probed operation, the clock is read only if the probe reporting the duration is enabled:
+///
+///     probes::Timer timer(fty_probe_enabled(snmp_response));
+class [[maybe_unused]] Timer
+{
+public:
+#if FTY_PROBES
+    explicit Timer(bool enabled)
+    {
+        if (enabled) {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    uint64_t micros() const
+    {
+        if (m_start == std::chrono::steady_clock::time_point{}) {
+            return 0;
+        }
+        return uint64_t(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start).count());
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+#else
+    explicit Timer(bool)
+    {
+    }
+
+    uint64_t micros() const
+    {
+        return 0;
+    }
+#endif
+};
+
+// =====================================================================================================================
+
+} // namespace fty::probes
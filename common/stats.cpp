@@ -0,0 +1,353 @@
+/*  =========================================================================
+    stats.cpp - Latency statistics of discovery stages
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "stats.h"
+#include "logger.h"
+#include "trace.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <fmt/format.h>
+#include <mutex>
+
+namespace fty::stats {
+
+// =====================================================================================================================
+
+static constexpr size_t StageCount = size_t(Stage::Count);
+
+const char* name(Stage stage)
+{
+    static constexpr std::array<const char*, StageCount> names = {"protocols", "mibs", "assets", "dns", "liveness",
+        "probe-xml", "probe-snmp", "probe-powercom", "snmp-get", "driver-spawn", "driver-run", "parse", "enrich",
+        "serialize", "bus-request", "bus-reply"};
+    return stage < Stage::Count ? names[size_t(stage)] : "unknown";
+}
+
+// =====================================================================================================================
+
+size_t Histogram::bucket(uint64_t value)
+{
+    value = std::min<uint64_t>(value, (uint64_t(1) << MaxBits) - 1);
+    if (value < (1u << SubBits)) {
+        return size_t(value);
+    }
+
+    uint32_t magnitude = 63 - uint32_t(__builtin_clzll(value));
+    uint32_t shift     = magnitude - SubBits;
+    return ((magnitude - SubBits + 1) << SubBits) + ((value >> shift) & ((1u << SubBits) - 1));
+}
+
+uint64_t Histogram::highest(size_t bucket)
+{
+    if (bucket < (1u << SubBits)) {
+        return bucket;
+    }
+
+    uint32_t shift = uint32_t(bucket >> SubBits) - 1;
+    uint64_t sub   = bucket & ((1u << SubBits) - 1);
+    return (((uint64_t(1) << SubBits) + sub + 1) << shift) - 1;
+}
+
+Histogram::Histogram()
+    : buckets(BucketCount, 0)
+{
+}
+
+void Histogram::add(uint64_t value, uint64_t cnt)
+{
+    buckets[bucket(value)] += cnt;
+    count += cnt;
+    sum += value * cnt;
+    max = std::max(max, value);
+}
+
+uint64_t Histogram::percentile(double quantile) const
+{
+    if (!count) {
+        return 0;
+    }
+
+    uint64_t rank = std::max<uint64_t>(1, uint64_t(quantile * double(count) + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(highest(i), max);
+        }
+    }
+    return max;
+}
+
+// =====================================================================================================================
+// Per thread shards
+// =====================================================================================================================
+
+namespace {
+
+    struct Shard
+    {
+        using Counter = std::atomic<uint64_t>;
+
+        std::array<std::array<Counter, Histogram::BucketCount>, StageCount> buckets{};
+        std::array<Counter, StageCount>                                     sums{};
+        std::array<Counter, StageCount>                                     errors{};
+        std::array<Counter, StageCount>                                     maxes{};
+    };
+
+    /// All shards ever created. Shard of finished thread is kept (with its values) and reused by the next thread.
+    class Shards
+    {
+    public:
+        static Shards& instance()
+        {
+            static Shards inst;
+            return inst;
+        }
+
+        Shard* acquire()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_free.empty()) {
+                Shard* shard = m_free.back();
+                m_free.pop_back();
+                return shard;
+            }
+            m_shards.push_back(std::make_unique<Shard>());
+            return m_shards.back().get();
+        }
+
+        void release(Shard* shard)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_free.push_back(shard);
+        }
+
+        template <typename Func>
+        void each(Func&& func)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& shard : m_shards) {
+                func(*shard);
+            }
+        }
+
+    private:
+        std::mutex                          m_mutex;
+        std::vector<std::unique_ptr<Shard>> m_shards;
+        std::vector<Shard*>                 m_free;
+    };
+
+    struct ThreadShard
+    {
+        ThreadShard()
+            : shard(Shards::instance().acquire())
+        {
+        }
+
+        ~ThreadShard()
+        {
+            Shards::instance().release(shard);
+        }
+
+        Shard* shard;
+    };
+
+} // namespace
+
+/// Breakdown of the request processed by the thread
+static thread_local Breakdown* t_breakdown = nullptr;
+
+static std::atomic<uint64_t> g_slowMicros = 0;
+
+void record(Stage stage, uint64_t micros, bool ok)
+{
+    if (stage >= Stage::Count) {
+        return;
+    }
+
+    size_t index = size_t(stage);
+    if (Breakdown* breakdown = t_breakdown) {
+        breakdown->micros[index] += micros;
+        breakdown->count[index]++;
+        if (!ok) {
+            breakdown->errors[index]++;
+        }
+    }
+
+    thread_local ThreadShard local;
+
+    Shard& shard = *local.shard;
+
+    shard.buckets[index][Histogram::bucket(micros)].fetch_add(1, std::memory_order_relaxed);
+    shard.sums[index].fetch_add(micros, std::memory_order_relaxed);
+    if (!ok) {
+        shard.errors[index].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Only the owner thread raises max, so plain compare is enough
+    if (shard.maxes[index].load(std::memory_order_relaxed) < micros) {
+        shard.maxes[index].store(micros, std::memory_order_relaxed);
+    }
+}
+
+std::vector<Histogram> snapshot()
+{
+    std::vector<Histogram> result(StageCount);
+
+    Shards::instance().each([&](Shard& shard) {
+        for (size_t stage = 0; stage < StageCount; ++stage) {
+            Histogram& hist = result[stage];
+            for (size_t i = 0; i < Histogram::BucketCount; ++i) {
+                if (uint64_t cnt = shard.buckets[stage][i].load(std::memory_order_relaxed)) {
+                    hist.buckets[i] += cnt;
+                    hist.count += cnt;
+                }
+            }
+            hist.sum += shard.sums[stage].load(std::memory_order_relaxed);
+            hist.errors += shard.errors[stage].load(std::memory_order_relaxed);
+            hist.max = std::max(hist.max, shard.maxes[stage].load(std::memory_order_relaxed));
+        }
+    });
+
+    return result;
+}
+
+void reset()
+{
+    Shards::instance().each([](Shard& shard) {
+        for (size_t stage = 0; stage < StageCount; ++stage) {
+            for (auto& bucket : shard.buckets[stage]) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            shard.sums[stage].store(0, std::memory_order_relaxed);
+            shard.errors[stage].store(0, std::memory_order_relaxed);
+            shard.maxes[stage].store(0, std::memory_order_relaxed);
+        }
+    });
+}
+
+// =====================================================================================================================
+
+Timer::Timer(Stage stage)
+    : m_stage(stage)
+    , m_start(std::chrono::steady_clock::now())
+    , m_exceptions(std::uncaught_exceptions())
+{
+}
+
+Timer::~Timer()
+{
+    auto end     = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - m_start);
+    bool failed  = m_failed || std::uncaught_exceptions() > m_exceptions;
+    record(m_stage, uint64_t(elapsed.count()), !failed);
+
+    // Every measured stage is a span of the request as well
+    trace::record(name(m_stage), m_start, end);
+}
+
+void Timer::fail()
+{
+    m_failed = true;
+}
+
+// =====================================================================================================================
+
+std::string Breakdown::format() const
+{
+    std::string out;
+    for (size_t stage = 0; stage < StageCount; ++stage) {
+        if (!count[stage]) {
+            continue;
+        }
+        if (!out.empty()) {
+            out += ' ';
+        }
+        out += fmt::format("{}={:.1f}ms", name(Stage(stage)), double(micros[stage]) / 1000.);
+        if (count[stage] > 1 && errors[stage]) {
+            out += fmt::format("({}x, {} failed)", count[stage], errors[stage]);
+        } else if (count[stage] > 1) {
+            out += fmt::format("({}x)", count[stage]);
+        } else if (errors[stage]) {
+            out += "(failed)";
+        }
+    }
+    return out;
+}
+
+Scope::Scope()
+    : m_outer(t_breakdown)
+    , m_start(std::chrono::steady_clock::now())
+{
+    t_breakdown = &m_breakdown;
+}
+
+Scope::~Scope()
+{
+    t_breakdown = m_outer;
+}
+
+const Breakdown& Scope::breakdown() const
+{
+    return m_breakdown;
+}
+
+uint64_t Scope::elapsed() const
+{
+    return uint64_t(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start).count());
+}
+
+void setSlowThreshold(uint32_t millis)
+{
+    g_slowMicros = uint64_t(millis) * 1000;
+}
+
+uint64_t slowThreshold()
+{
+    return g_slowMicros;
+}
+
+void logSlow(const Scope& scope, const std::string& subject, const std::string& host, const std::string& correlationId,
+    const std::string& credential, bool ok)
+{
+    // Timing of stages is collected for every request, but only outliers are worth a record
+    uint64_t elapsed = scope.elapsed();
+    if (!slowThreshold() || elapsed < slowThreshold()) {
+        return;
+    }
+
+    const char* status = ok ? "ok" : "error";
+    if (correlationId.empty()) {
+        slog_warning("Slow request", {{"subject", subject}, {"host", host}, {"credential", credential},
+            {"status", status}, {"total_ms", elapsed / 1000}, {"stages", scope.breakdown().format()}});
+    } else {
+        slog_warning("Slow request", {{"subject", subject}, {"host", host}, {"correlation_id", correlationId},
+            {"credential", credential}, {"status", status}, {"total_ms", elapsed / 1000},
+            {"stages", scope.breakdown().format()}});
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::stats
@@ -0,0 +1,189 @@
+/*  =========================================================================
+    stats.h - Latency statistics of discovery stages
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace fty::stats {
+
+// =====================================================================================================================
+
+/// Measured stages of the discovery
+enum class Stage
+{
+    Protocols,     // whole protocols request
+    Mibs,          // whole mibs request
+    Assets,        // whole assets request
+    Dns,           // address resolution
+    Liveness,      // host availability check
+    ProbeXml,      // xml_pdc protocol probe
+    ProbeSnmp,     // snmp protocol probe
+    ProbePowercom, // powercom protocol probe
+    SnmpGet,       // one SNMP get request
+    DriverSpawn,   // start of the nut driver process
+    DriverRun,     // nut driver run until exit
+    Parse,         // parsing of the driver output, enrichment included
+    Enrich,        // enrichment of the parsed assets
+    Serialize,     // serialization of the response
+    BusRequest,    // bus request until answer
+    BusReply,      // sending of the bus reply
+    Count
+};
+
+/// Name of the stage
+const char* name(Stage stage);
+
+// =====================================================================================================================
+
+/// Log-linear (HDR like) histogram of durations in microseconds.
+/// Values are split by power of two, every power is split by 16 linear sub buckets, so the relative error of
+/// percentiles is below 1/16. Values above ~12 days are counted in the last bucket.
+class Histogram
+{
+public:
+    static constexpr uint32_t SubBits     = 4;
+    static constexpr uint32_t MaxBits     = 40;
+    static constexpr size_t   BucketCount = (MaxBits - SubBits + 1) << SubBits;
+
+    /// Bucket of the value
+    static size_t bucket(uint64_t value);
+
+    /// Highest value counted in the bucket
+    static uint64_t highest(size_t bucket);
+
+public:
+    Histogram();
+
+    void     add(uint64_t value, uint64_t count = 1);
+    uint64_t percentile(double quantile) const;
+
+public:
+    std::vector<uint64_t> buckets;
+    uint64_t              count  = 0;
+    uint64_t              errors = 0;
+    uint64_t              sum    = 0;
+    uint64_t              max    = 0;
+};
+
+// =====================================================================================================================
+
+/// Records duration of the stage.
+/// Recording is lock free, every thread writes to its own shard, shards are summed only by @ref snapshot.
+void record(Stage stage, uint64_t micros, bool ok = true);
+
+/// Sums all shards, histogram per stage (indexed by stage)
+std::vector<Histogram> snapshot();
+
+/// Clears all recorded values
+void reset();
+
+// =====================================================================================================================
+
+/// Stages recorded by one request, totals per stage
+struct Breakdown
+{
+    std::array<uint64_t, size_t(Stage::Count)> micros{}; // summed duration
+    std::array<uint32_t, size_t(Stage::Count)> count{};  // recorded times
+    std::array<uint32_t, size_t(Stage::Count)> errors{}; // failed times, timeouts included
+
+    /// Recorded stages as `name=12.3ms` items, repeated stage with count, failed with error count, e.g.
+    /// `snmp-get=840.2ms(12x, 2 failed)`
+    std::string format() const;
+};
+
+/// Collects everything recorded by the current thread into breakdown in addition to the shared histograms.
+/// Cost is one thread local pointer check per record. Nested scope suspends the outer one.
+class Scope
+{
+public:
+    Scope();
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    /// Stages recorded so far
+    const Breakdown& breakdown() const;
+
+    /// Microseconds since the scope start
+    uint64_t elapsed() const;
+
+private:
+    Breakdown                             m_breakdown;
+    Breakdown*                            m_outer;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/// Sets duration in milliseconds from which requests are logged with their breakdown, 0 disables
+void setSlowThreshold(uint32_t millis);
+
+/// Duration in microseconds from which requests are logged, 0 if disabled
+uint64_t slowThreshold();
+
+/// Logs "Slow request" warning with the breakdown of the request scope if it took `slowThreshold()` or longer.
+/// Empty correlation id is left out (scheduled runs).
+void logSlow(const Scope& scope, const std::string& subject, const std::string& host, const std::string& correlationId,
+    const std::string& credential, bool ok);
+
+// =====================================================================================================================
+
+/// Measures the scope, scope left by exception is counted as error. Scope is recorded as trace span too.
+class Timer
+{
+public:
+    explicit Timer(Stage stage);
+    ~Timer();
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    /// Marks the stage as failed
+    void fail();
+
+private:
+    Stage                                 m_stage;
+    std::chrono::steady_clock::time_point m_start;
+    int                                   m_exceptions;
+    bool                                  m_failed = false;
+};
+
+// =====================================================================================================================
+
+/// Measures the call of function returning @ref Expected, unexpected result is counted as error
+template <typename Func>
+auto measure(Stage stage, Func&& func)
+{
+    Timer timer(stage);
+    auto  res = func();
+    if (!res) {
+        timer.fail();
+    }
+    return res;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::stats
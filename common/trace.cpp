@@ -0,0 +1,283 @@
+/*  =========================================================================
+    trace.cpp - Request spans in Chrome trace format
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace fty::trace {
+
+// =====================================================================================================================
+
+namespace {
+
+    class Tracer
+    {
+    public:
+        static Tracer& instance()
+        {
+            static Tracer inst;
+            return inst;
+        }
+
+        ~Tracer()
+        {
+            stop();
+        }
+
+        void configure(size_t capacity, const std::string& path)
+        {
+            stop();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_ring.assign(capacity, Event{});
+            m_next = 0;
+            m_size = 0;
+
+            if (!path.empty()) {
+                m_file.open(path, std::ios::trunc);
+                if (m_file) {
+                    // Chrome accepts unterminated array, so file is valid at any moment
+                    m_file << "[\n";
+                    m_stop   = false;
+                    m_writer = std::thread(&Tracer::writer, this);
+                }
+            }
+            m_enabled = capacity || m_file.is_open();
+        }
+
+        void stop()
+        {
+            m_enabled = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_cv.notify_all();
+            if (m_writer.joinable()) {
+                m_writer.join();
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_file.is_open()) {
+                write(m_pending);
+                m_pending.clear();
+                m_file.close();
+            }
+        }
+
+        bool enabled() const
+        {
+            return m_enabled.load(std::memory_order_relaxed);
+        }
+
+        void record(Event&& event)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_file.is_open()) {
+                m_pending.push_back(event);
+            }
+            if (!m_ring.empty()) {
+                m_ring[m_next] = std::move(event);
+                m_next         = (m_next + 1) % m_ring.size();
+                m_size         = std::min(m_size + 1, m_ring.size());
+            }
+        }
+
+        std::vector<Event> events(const std::string& correlationId)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            std::vector<Event> out;
+            size_t             first = (m_next + m_ring.size() - m_size) % std::max<size_t>(m_ring.size(), 1);
+            for (size_t i = 0; i < m_size; ++i) {
+                const Event& event = m_ring[(first + i) % m_ring.size()];
+                if (correlationId.empty() || event.correlationId == correlationId) {
+                    out.push_back(event);
+                }
+            }
+            return out;
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_next = 0;
+            m_size = 0;
+        }
+
+        uint64_t since(Clock::time_point point) const
+        {
+            return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(point - m_epoch).count());
+        }
+
+    private:
+        Tracer() = default;
+
+        void writer()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_stop) {
+                m_cv.wait_for(lock, std::chrono::seconds(1));
+
+                std::vector<Event> pending;
+                pending.swap(m_pending);
+
+                lock.unlock();
+                write(pending);
+                lock.lock();
+            }
+        }
+
+        /// Writes events as Chrome complete events, one per line
+        void write(const std::vector<Event>& events)
+        {
+            for (const auto& event : events) {
+                m_file << R"({"name":")" << event.name << R"(","cat":"discovery","ph":"X","ts":)" << event.start
+                       << R"(,"dur":)" << event.duration << R"(,"pid":)" << getpid() << R"(,"tid":)" << event.thread
+                       << R"(,"args":{"correlation_id":")" << escape(event.correlationId) << "\"}},\n";
+            }
+            m_file.flush();
+        }
+
+        static std::string escape(const std::string& str)
+        {
+            std::string out;
+            for (char ch : str) {
+                if (ch == '"' || ch == '\\') {
+                    out += '\\';
+                    out += ch;
+                } else if (uint8_t(ch) >= 0x20) {
+                    out += ch;
+                }
+            }
+            return out;
+        }
+
+    private:
+        std::mutex              m_mutex;
+        std::condition_variable m_cv;
+        std::atomic<bool>       m_enabled = false;
+        std::vector<Event>      m_ring;
+        size_t                  m_next = 0;
+        size_t                  m_size = 0;
+        std::ofstream           m_file;
+        std::vector<Event>      m_pending;
+        std::thread             m_writer;
+        bool                    m_stop  = true;
+        Clock::time_point       m_epoch = Clock::now();
+    };
+
+    uint32_t threadId()
+    {
+        thread_local uint32_t id = uint32_t(syscall(SYS_gettid));
+        return id;
+    }
+
+    thread_local std::string currentRequest;
+
+} // namespace
+
+// =====================================================================================================================
+
+void configure(size_t capacity, const std::string& file)
+{
+    Tracer::instance().configure(capacity, file);
+}
+
+void stop()
+{
+    Tracer::instance().stop();
+}
+
+bool enabled()
+{
+    return Tracer::instance().enabled();
+}
+
+void record(const char* name, Clock::time_point start, Clock::time_point end)
+{
+    auto& tracer = Tracer::instance();
+    if (!tracer.enabled()) {
+        return;
+    }
+
+    Event event;
+    event.name          = name;
+    event.correlationId = currentRequest;
+    event.start         = tracer.since(start);
+    event.duration      = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+    event.thread        = threadId();
+    tracer.record(std::move(event));
+}
+
+std::vector<Event> events(const std::string& correlationId)
+{
+    return Tracer::instance().events(correlationId);
+}
+
+void clear()
+{
+    Tracer::instance().clear();
+}
+
+// =====================================================================================================================
+
+Context::Context(const std::string& correlationId)
+    : m_previous(currentRequest)
+{
+    currentRequest = correlationId;
+}
+
+Context::~Context()
+{
+    currentRequest = m_previous;
+}
+
+const std::string& Context::current()
+{
+    return currentRequest;
+}
+
+// =====================================================================================================================
+
+Span::Span(const char* name)
+    : m_name(name)
+    , m_start(enabled() ? Clock::now() : Clock::time_point())
+{
+}
+
+Span::~Span()
+{
+    if (m_start != Clock::time_point()) {
+        record(m_name, m_start, Clock::now());
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::trace
@@ -0,0 +1,103 @@
+/*  =========================================================================
+    trace.h - Request spans in Chrome trace format
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fty::trace {
+
+// =====================================================================================================================
+
+/// Finished span
+struct Event
+{
+    const char* name = nullptr; // static string
+    std::string correlationId;
+    uint64_t    start    = 0; // microseconds since trace start
+    uint64_t    duration = 0; // microseconds
+    uint32_t    thread   = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+// =====================================================================================================================
+
+/// Enables tracing. Spans are kept in the ring of `capacity` events (oldest are overwritten) and if `file` is not
+/// empty also appended to it as Chrome trace events. Zero capacity and empty file disables tracing.
+void configure(size_t capacity, const std::string& file = {});
+
+/// Disables tracing, flushes and closes the file
+void stop();
+
+/// Checks if tracing is enabled
+bool enabled();
+
+/// Records finished span
+void record(const char* name, Clock::time_point start, Clock::time_point end);
+
+/// Events in the ring, only events of the request if `correlationId` is set
+std::vector<Event> events(const std::string& correlationId = {});
+
+/// Clears the ring
+void clear();
+
+// =====================================================================================================================
+
+/// Request processed by the current thread, spans recorded meanwhile are keyed by its correlation id
+class Context
+{
+public:
+    explicit Context(const std::string& correlationId);
+    ~Context();
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+    /// Correlation id of the current request, empty outside of request
+    static const std::string& current();
+
+private:
+    std::string m_previous;
+};
+
+// =====================================================================================================================
+
+/// Records the scope as span, does nothing if tracing is disabled
+class Span
+{
+public:
+    explicit Span(const char* name);
+    ~Span();
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char*       m_name;
+    Clock::time_point m_start;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::trace
@@ -0,0 +1,238 @@
+/*  =========================================================================
+    transport-inproc.cpp - In-process message bus transport
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "transport.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace fty {
+
+// =====================================================================================================================
+
+class InprocTransport;
+
+/// Routes messages between in-process transports connected to the same name
+class InprocBroker
+{
+public:
+    static std::shared_ptr<InprocBroker> get(const std::string& name)
+    {
+        static std::mutex                                         mutex;
+        static std::map<std::string, std::weak_ptr<InprocBroker>> brokers;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (auto broker = brokers[name].lock()) {
+            return broker;
+        }
+        auto broker   = std::make_shared<InprocBroker>();
+        brokers[name] = broker;
+        return broker;
+    }
+
+    Expected<void> attach(const std::string& actorName, InprocTransport* transport)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_actors.count(actorName)) {
+            return unexpected("Actor {} is already connected", actorName);
+        }
+        m_actors.emplace(actorName, transport);
+        return {};
+    }
+
+    void detach(const std::string& actorName)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_actors.erase(actorName);
+    }
+
+    Expected<void> deliver(const std::string& queue, const Message& msg);
+
+private:
+    std::mutex                              m_mutex;
+    std::map<std::string, InprocTransport*> m_actors;
+};
+
+// =====================================================================================================================
+
+/// In-process transport. Incoming messages are queued and dispatched from own thread, the same way as malamute client
+/// does, so handlers never run in the sender thread.
+class InprocTransport : public Transport
+{
+public:
+    InprocTransport(const std::string& name, const std::string& actorName)
+        : m_broker(InprocBroker::get(name))
+        , m_actorName(actorName)
+    {
+    }
+
+    ~InprocTransport() override
+    {
+        if (m_connected) {
+            m_broker->detach(m_actorName);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    Expected<void> connect() override
+    {
+        if (auto res = m_broker->attach(m_actorName, this); !res) {
+            return unexpected(res.error());
+        }
+        m_connected = true;
+        m_thread    = std::thread(&InprocTransport::dispatch, this);
+        return {};
+    }
+
+    Expected<Message> request(const std::string& queue, const Message& msg, int timeout) override
+    {
+        std::future<Message> answer;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            answer = m_pending[msg.meta.correlationId].get_future();
+        }
+
+        auto forget = [&]() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.erase(msg.meta.correlationId);
+        };
+
+        if (auto res = m_broker->deliver(queue, msg); !res) {
+            forget();
+            return unexpected(res.error());
+        }
+
+        if (answer.wait_for(std::chrono::seconds(timeout)) != std::future_status::ready) {
+            forget();
+            return unexpected("Request timeout");
+        }
+        return answer.get();
+    }
+
+    Expected<void> sendReply(const std::string& queue, const Message& msg) override
+    {
+        return m_broker->deliver(queue, msg);
+    }
+
+    Expected<void> sendRequest(const std::string& queue, const Message& msg) override
+    {
+        return m_broker->deliver(queue, msg);
+    }
+
+    Expected<void> receive(const std::string& queue, Callback&& func) override
+    {
+        return subscribe(queue, std::move(func));
+    }
+
+    Expected<void> subscribe(const std::string& queue, Callback&& func) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_handlers[queue] = std::move(func);
+        return {};
+    }
+
+    /// Called by broker from the sender thread
+    void push(const std::string& queue, const Message& msg)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto it = m_pending.find(msg.meta.correlationId); it != m_pending.end()) {
+            it->second.set_value(msg);
+            m_pending.erase(it);
+            return;
+        }
+        m_inbox.emplace_back(queue, msg);
+        m_cv.notify_one();
+    }
+
+private:
+    void dispatch()
+    {
+        while (true) {
+            std::pair<std::string, Message> item;
+            Callback                        handler;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [&]() {
+                    return m_stop || !m_inbox.empty();
+                });
+                if (m_stop) {
+                    return;
+                }
+                item = std::move(m_inbox.front());
+                m_inbox.pop_front();
+
+                if (auto it = m_handlers.find(item.first); it != m_handlers.end()) {
+                    handler = it->second;
+                }
+            }
+            if (handler) {
+                handler(item.second);
+            }
+        }
+    }
+
+private:
+    std::shared_ptr<InprocBroker>                m_broker;
+    std::string                                  m_actorName;
+    bool                                         m_connected = false;
+    bool                                         m_stop      = false;
+    std::mutex                                   m_mutex;
+    std::condition_variable                      m_cv;
+    std::thread                                  m_thread;
+    std::map<std::string, Callback>              m_handlers;
+    std::deque<std::pair<std::string, Message>>  m_inbox;
+    std::map<std::string, std::promise<Message>> m_pending;
+};
+
+// =====================================================================================================================
+
+Expected<void> InprocBroker::deliver(const std::string& queue, const Message& msg)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto                        it = m_actors.find(msg.meta.to);
+    if (it == m_actors.end()) {
+        return unexpected("Actor {} is not connected", msg.meta.to.value());
+    }
+    it->second->push(queue, msg);
+    return {};
+}
+
+// =====================================================================================================================
+
+std::unique_ptr<Transport> createInprocTransport(const std::string& name, const std::string& actorName)
+{
+    return std::make_unique<InprocTransport>(name, actorName);
+}
+
+// =====================================================================================================================
+
+} // namespace fty
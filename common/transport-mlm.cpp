@@ -0,0 +1,128 @@
+/*  =========================================================================
+    transport-mlm.cpp - Malamute message bus transport
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "transport.h"
+#include <fty_common_messagebus_exception.h>
+#include <fty_common_messagebus_interface.h>
+#include <fty_common_messagebus_message.h>
+#include <cstring>
+
+namespace fty {
+
+// =====================================================================================================================
+
+class MlmTransport : public Transport
+{
+public:
+    MlmTransport(const std::string& endpoint, const std::string& actorName)
+        : m_endpoint(endpoint)
+        , m_actorName(actorName)
+    {
+    }
+
+    Expected<void> connect() override
+    {
+        try {
+            m_bus = std::unique_ptr<messagebus::MessageBus>(messagebus::MlmMessageBus(m_endpoint, m_actorName));
+            m_bus->connect();
+            return {};
+        } catch (std::exception& ex) {
+            return unexpected(ex.what());
+        }
+    }
+
+    Expected<Message> request(const std::string& queue, const Message& msg, int timeout) override
+    {
+        try {
+            return Message(m_bus->request(queue, msg.toMessageBus(), timeout));
+        } catch (messagebus::MessageBusException& ex) {
+            return unexpected(ex.what());
+        }
+    }
+
+    Expected<void> sendReply(const std::string& queue, const Message& msg) override
+    {
+        try {
+            m_bus->sendReply(queue, msg.toMessageBus());
+            return {};
+        } catch (messagebus::MessageBusException& ex) {
+            return unexpected(ex.what());
+        }
+    }
+
+    Expected<void> sendRequest(const std::string& queue, const Message& msg) override
+    {
+        try {
+            m_bus->sendRequest(queue, msg.toMessageBus());
+            return {};
+        } catch (messagebus::MessageBusException& ex) {
+            return unexpected(ex.what());
+        }
+    }
+
+    Expected<void> receive(const std::string& queue, Callback&& func) override
+    {
+        try {
+            m_bus->receive(queue, [f = std::move(func)](const messagebus::Message& msg) {
+                f(Message(msg));
+            });
+            return {};
+        } catch (messagebus::MessageBusException& ex) {
+            return unexpected(ex.what());
+        }
+    }
+
+    Expected<void> subscribe(const std::string& queue, Callback&& func) override
+    {
+        try {
+            m_bus->subscribe(queue, [f = std::move(func)](const messagebus::Message& msg) {
+                f(Message(msg));
+            });
+            return {};
+        } catch (messagebus::MessageBusException& ex) {
+            return unexpected(ex.what());
+        }
+    }
+
+private:
+    std::string                             m_endpoint;
+    std::string                             m_actorName;
+    std::unique_ptr<messagebus::MessageBus> m_bus;
+};
+
+// =====================================================================================================================
+
+std::unique_ptr<Transport> createMlmTransport(const std::string& endpoint, const std::string& actorName)
+{
+    return std::make_unique<MlmTransport>(endpoint, actorName);
+}
+
+std::unique_ptr<Transport> Transport::create(const std::string& endpoint, const std::string& actorName)
+{
+    if (endpoint.find(InprocScheme) == 0) {
+        return createInprocTransport(endpoint.substr(strlen(InprocScheme)), actorName);
+    }
+    return createMlmTransport(endpoint, actorName);
+}
+
+// =====================================================================================================================
+
+} // namespace fty
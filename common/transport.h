@@ -0,0 +1,76 @@
+/*  =========================================================================
+    transport.h - Message bus transport interface
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include "message.h"
+#include <fty/expected.h>
+#include <functional>
+#include <memory>
+
+namespace fty {
+
+// =====================================================================================================================
+
+/// Message bus transport. Delivers messages between actors, @ref MessageBus is a thin wrapper on top of it.
+/// Implementations are selected by endpoint scheme:
+///  * `ipc://...`, `tcp://...` - malamute broker
+///  * `inproc://<name>`        - in-process queues, every bus with the same name sees each other
+class Transport
+{
+public:
+    using Callback = std::function<void(const Message&)>;
+
+    static constexpr const char* InprocScheme = "inproc://";
+
+public:
+    virtual ~Transport() = default;
+
+    /// Connects actor to the bus
+    [[nodiscard]] virtual Expected<void> connect() = 0;
+
+    /// Sends request to `msg.meta.to` and waits for the answer with the same correlation id
+    [[nodiscard]] virtual Expected<Message> request(const std::string& queue, const Message& msg, int timeout) = 0;
+
+    /// Sends answer to `msg.meta.to`
+    [[nodiscard]] virtual Expected<void> sendReply(const std::string& queue, const Message& msg) = 0;
+
+    /// Sends message to `msg.meta.to` without waiting for the answer
+    [[nodiscard]] virtual Expected<void> sendRequest(const std::string& queue, const Message& msg) = 0;
+
+    /// Registers handler for mailbox messages in the queue
+    [[nodiscard]] virtual Expected<void> receive(const std::string& queue, Callback&& func) = 0;
+
+    /// Registers handler for requests in the queue
+    [[nodiscard]] virtual Expected<void> subscribe(const std::string& queue, Callback&& func) = 0;
+
+public:
+    /// Creates transport for endpoint
+    static std::unique_ptr<Transport> create(const std::string& endpoint, const std::string& actorName);
+};
+
+// =====================================================================================================================
+
+std::unique_ptr<Transport> createMlmTransport(const std::string& endpoint, const std::string& actorName);
+std::unique_ptr<Transport> createInprocTransport(const std::string& name, const std::string& actorName);
+
+// =====================================================================================================================
+
+} // namespace fty
@@ -0,0 +1,178 @@
+/*  =========================================================================
+    bench.cpp - Built-in capacity benchmark
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "bench.h"
+#include "config.h"
+#include "discovery.h"
+#include "jobs/impl/snmp.h"
+#include "snmp-agent.h"
+#include "workload.h"
+#include <fmt/format.h>
+#include <iostream>
+#include <thread>
+
+namespace fty::bench {
+
+// =====================================================================================================================
+
+static std::string row(const std::string& name, const stats::Histogram& hist, double wall)
+{
+    auto ms = [](uint64_t micros) {
+        return double(micros) / 1000.;
+    };
+
+    return fmt::format("{:<12}{:>10}{:>8}{:>10.1f}{:>10.2f}{:>10.2f}{:>10.2f}{:>10.2f}", name, hist.count, hist.errors,
+        double(hist.count) / wall, ms(hist.percentile(0.5)), ms(hist.percentile(0.9)), ms(hist.percentile(0.99)),
+        ms(hist.max));
+}
+
+static void report(const Options& options, const std::vector<std::string>& devices,
+    const std::vector<std::unique_ptr<MixClient>>& clients, const Resources& usage, double wall)
+{
+    std::cout << fmt::format("Capacity: {} clients, {} s, mix {}, {} simulated devices on {} endpoints",
+                     options.concurrency, options.duration, options.mix, devices.size(), options.agents)
+              << std::endl
+              << std::endl;
+
+    std::cout << fmt::format("{:<12}{:>10}{:>8}{:>10}{:>10}{:>10}{:>10}{:>10}", "subject", "requests", "errors",
+                     "req/s", "p50 ms", "p90 ms", "p99 ms", "max ms")
+              << std::endl;
+
+    stats::Histogram all;
+    for (size_t kind = 0; kind < size_t(Kind::Count); ++kind) {
+        stats::Histogram hist;
+        for (const auto& client : clients) {
+            merge(hist, client->histogram(Kind(kind)));
+        }
+        if (hist.count) {
+            std::cout << row(subject(Kind(kind)), hist, wall) << std::endl;
+        }
+        merge(all, hist);
+    }
+    std::cout << row("total", all, wall) << std::endl << std::endl;
+
+    double cpu = usage.cpuUser + usage.cpuSystem;
+    std::cout << fmt::format("CPU: user {:.2f} s, system {:.2f} s, {:.1f}% of one core ({} cores), "
+                             "{:.2f} ms per request",
+                     usage.cpuUser, usage.cpuSystem, cpu / wall * 100, std::thread::hardware_concurrency(),
+                     all.count ? cpu * 1000 / double(all.count) : 0.)
+              << std::endl;
+    std::cout << fmt::format("RSS: {} kB, peak {} kB", usage.rss, usage.maxRss) << std::endl;
+}
+
+// =====================================================================================================================
+
+int run(const Options& options)
+{
+    auto weighted = parseMix(options.mix);
+    if (!weighted) {
+        std::cerr << weighted.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint32_t agents = std::max(options.agents, 1u);
+
+    // Simulated devices, community selects the device
+    sim::SnmpAgent snmpsim;
+    if (auto res = snmpsim.load(options.data); !res) {
+        std::cerr << res.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+    auto devices = snmpsim.names();
+    if (devices.empty()) {
+        std::cerr << "No simulated devices in " << options.data << std::endl;
+        return EXIT_FAILURE;
+    }
+    for (uint32_t i = 0; i < agents; ++i) {
+        if (auto res = snmpsim.listen(uint16_t(options.port + i)); !res) {
+            std::cerr << res.error() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (auto res = snmpsim.start(2); !res) {
+        std::cerr << res.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Agent on in-process bus, nothing is persisted or exposed
+    auto& config         = Config::instance();
+    config.actorName     = "discovery-ng-bench";
+    config.endpoint      = "inproc://discovery-ng-bench";
+    config.store         = "";
+    config.scheduleState = "";
+    config.captureFile   = "";
+    config.traceFile     = "";
+    config.metricsSocket = "";
+    config.metricsPort   = 0;
+    config.warmupHosts   = 0;
+    impl::Snmp::instance().init(config.mibDatabase);
+
+    Discovery dis("");
+    if (auto res = dis.init(); !res) {
+        std::cerr << "Cannot init discovery: " << res.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::thread agent([&]() {
+        dis.run();
+    });
+
+    auto finish = [&]() {
+        dis.shutdown();
+        agent.join();
+        snmpsim.stop();
+    };
+
+    std::vector<std::unique_ptr<MixClient>> clients;
+    for (uint32_t i = 0; i < std::max(options.concurrency, 1u); ++i) {
+        clients.emplace_back(std::make_unique<MixClient>(i, *weighted, devices, options.port, agents, false));
+        if (auto res = clients.back()->init(); !res) {
+            std::cerr << "Cannot init client: " << res.error() << std::endl;
+            finish();
+            return EXIT_FAILURE;
+        }
+    }
+
+    stats::reset();
+    auto startUsage = Resources::now();
+    auto start      = std::chrono::steady_clock::now();
+    auto deadline   = start + std::chrono::seconds(std::max(options.duration, 1u));
+
+    std::vector<std::thread> threads;
+    for (auto& client : clients) {
+        threads.emplace_back([&client, deadline]() {
+            client->run(deadline);
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    double wall  = double(elapsed(start)) / 1e6;
+    auto   usage = Resources::now().since(startUsage);
+
+    finish();
+    report(options, devices, clients, usage, wall);
+    return EXIT_SUCCESS;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::bench
@@ -0,0 +1,50 @@
+/*  =========================================================================
+    bench.h - Built-in capacity benchmark
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace fty::bench {
+
+// =====================================================================================================================
+
+/// Capacity benchmark of the agent (`--bench`).
+///
+/// Starts simulated SNMP agent serving snmprec files of `data` directory and the discovery agent on in-process bus,
+/// then `concurrency` clients send weighted `mix` of requests through the real `Discovery` dispatcher for `duration`
+/// seconds. Prints requests per second and client side latency percentiles per subject, CPU time and resident memory.
+struct Options
+{
+    std::string mix         = "protocols:1,mibs:2,assets:2";
+    std::string data        = "assets"; // directory with snmprec files
+    uint32_t    duration    = 30;       // seconds
+    uint32_t    concurrency = 8;        // parallel clients
+    uint32_t    agents      = 4;        // simulated agent endpoints
+    uint16_t    port        = 21161;    // first endpoint port
+};
+
+/// Runs the benchmark, returns exit code of the process
+int run(const Options& options);
+
+// =====================================================================================================================
+
+} // namespace fty::bench
@@ -27,14 +27,38 @@ namespace fty {
 class Config : public pack::Node
 {
 public:
-    pack::String actorName   = FIELD("actor-name", "conf/discovery-ng");
-    pack::String logConfig   = FIELD("log-config", "conf/logger.conf");
-    pack::String mibDatabase = FIELD("mib-database", "mibs");
-    pack::Bool   tryAll      = FIELD("try-all", false);
+    pack::String actorName           = FIELD("actor-name", "conf/discovery-ng");
+    pack::String endpoint            = FIELD("endpoint", "ipc://@/malamute");
+    pack::String logConfig           = FIELD("log-config", "conf/logger.conf");
+    pack::String mibDatabase         = FIELD("mib-database", "mibs");
+    pack::Bool   tryAll              = FIELD("try-all", false);
+    pack::String store               = FIELD("store");                      // results store directory, empty to disable
+    pack::UInt32 fingerprintTtl      = FIELD("fingerprint-ttl", 604800);    // seconds, 0 disables fingerprint cache
+    pack::UInt32 negativeBackoff     = FIELD("negative-backoff", 60);       // seconds, 0 disables negative cache
+    pack::UInt32 negativeBackoffMax  = FIELD("negative-backoff-max", 3600); // seconds
+    pack::String scheduleState       = FIELD("schedule-state");             // scheduled targets file, empty to not save
+    pack::UInt32 scheduleConcurrency = FIELD("schedule-concurrency", 4);    // parallel scheduled runs
+    pack::UInt32 scheduleRate        = FIELD("schedule-rate", 60);          // scheduled runs per minute, 0 is unlimited
+    pack::UInt32 scheduleJitter      = FIELD("schedule-jitter", 10);        // percents of the interval
+    pack::UInt32 warmupHosts         = FIELD("warmup-hosts", 0);            // recent hosts revalidated on start
+    pack::UInt32 warmupRate          = FIELD("warmup-rate", 30);            // revalidations per minute, 0 is unlimited
+    pack::UInt32 traceBuffer         = FIELD("trace-buffer", 0);            // spans kept in memory, 0 disables
+    pack::String traceFile           = FIELD("trace-file");                 // file to write all spans to
+    pack::UInt32 logQueue            = FIELD("log-queue", 4096);            // queued log records, 0 is synchronous
+    pack::UInt32 logRate             = FIELD("log-rate", 20);               // per second from one site, 0 is unlimited
+    pack::UInt32 httpPort            = FIELD("http-port", 80);              // port of xml_pdc and powercom probes
+    pack::String captureFile         = FIELD("capture-file");               // records requests and device answers
+    pack::Bool   memoryAccounting    = FIELD("memory-accounting", true);    // allocations of jobs by subject and target
+    pack::String metricsSocket       = FIELD("metrics-socket");             // unix socket of metrics endpoint
+    pack::UInt32 metricsPort         = FIELD("metrics-port", 0);            // local port of metrics endpoint, 0 disables
+    pack::UInt32 slowRequest         = FIELD("slow-request", 10000);        // ms to log request stages, 0 disables
 
 public:
     using pack::Node::Node;
-    META(Config, actorName, logConfig, mibDatabase, tryAll);
+    META(Config, actorName, endpoint, logConfig, mibDatabase, tryAll, store, fingerprintTtl, negativeBackoff,
+        negativeBackoffMax, scheduleState, scheduleConcurrency, scheduleRate, scheduleJitter, warmupHosts, warmupRate,
+        traceBuffer, traceFile, logQueue, logRate, httpPort, captureFile, memoryAccounting, metricsSocket,
+        metricsPort, slowRequest);
 
 public:
     static Config& instance();
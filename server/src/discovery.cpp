@@ -20,12 +20,30 @@
  */
 
 #include "discovery.h"
+#include "capture.h"
 #include "commands.h"
 #include "config.h"
 #include "daemon.h"
+#include "exporter.h"
 #include "jobs/assets.h"
+#include "jobs/forget.h"
+#include "jobs/hosts.h"
 #include "jobs/mibs.h"
 #include "jobs/protocols.h"
+#include "jobs/schedule.h"
+#include "jobs/statistics.h"
+#include "jobs/tracing.h"
+#include "jobs/watch.h"
+#include "logger.h"
+#include "memory.h"
+#include "metrics.h"
+#include "probes.h"
+#include "scheduler.h"
+#include "stats.h"
+#include "store.h"
+#include "trace.h"
+#include "warmup.h"
+#include "watchers.h"
 #include <fty/thread-pool.h>
 #include <fty_log.h>
 
@@ -54,9 +72,39 @@ bool Discovery::loadConfig()
 
 Expected<void> Discovery::init()
 {
-    if (auto res = m_bus.init(Config::instance().actorName)) {
+    logger::start(Config::instance().logQueue, Config::instance().logRate);
+    memory::enable(Config::instance().memoryAccounting);
+    stats::setSlowThreshold(Config::instance().slowRequest);
+    trace::configure(Config::instance().traceBuffer, Config::instance().traceFile);
+
+    if (Config::instance().captureFile.hasValue()) {
+        if (auto res = capture::start(Config::instance().captureFile); !res) {
+            log_error(res.error().c_str());
+        }
+    }
+
+    if (Config::instance().metricsSocket.hasValue() || Config::instance().metricsPort.value()) {
+        metrics::collect("fty_discovery_log_dropped_total", "Log records dropped on full queue", true, []() {
+            return double(logger::dropped());
+        });
+        if (auto res = Exporter::instance().start(
+                Config::instance().metricsSocket, uint16_t(Config::instance().metricsPort.value()));
+            !res) {
+            log_error(res.error().c_str());
+        }
+    }
+
+    if (Config::instance().store.hasValue()) {
+        if (auto res = Store::instance().open(Config::instance().store); !res) {
+            log_error("Cannot open store %s: %s", Config::instance().store.value().c_str(), res.error().c_str());
+        }
+    }
+
+    if (auto res = m_bus.init(Config::instance().actorName, Config::instance().endpoint)) {
         if (auto sub = m_bus.subsribe(fty::Channel, &Discovery::discover, this)) {
-            return {};
+            Watchers::instance().init(m_bus);
+            Warmup::instance().start(m_bus);
+            return Scheduler::instance().start(m_bus);
         } else {
             return unexpected(sub.error());
         }
@@ -68,7 +116,15 @@ Expected<void> Discovery::init()
 void Discovery::shutdown()
 {
     stop();
+    Scheduler::instance().stop();
+    Warmup::instance().stop();
     m_pool.stop();
+    Watchers::instance().stop();
+    Store::instance().close();
+    Exporter::instance().stop();
+    capture::stop();
+    trace::stop();
+    logger::stop();
 }
 
 int Discovery::run()
@@ -77,16 +133,48 @@ int Discovery::run()
     return 0;
 }
 
+template <typename T>
+void Discovery::push(const Message& msg)
+{
+    job::queuedJobs().inc();
+    m_pool.pushWorker<T>(msg, m_bus);
+}
+
 void Discovery::discover(const Message& msg)
 {
-    log_debug("Discovery: got message %s", msg.dump().c_str());
-    log_debug("Payload: %s", msg.userData.asString().c_str());
+    slog_debug("Discovery: got message", {{"subject", msg.meta.subject.value()}, {"from", msg.meta.from.value()},
+        {"correlation_id", msg.meta.correlationId.value()}, {"payload", msg.userData.asString()}});
+    fty_probe(bus_receive, msg.meta.subject.value().c_str(), msg.meta.from.value().c_str(),
+        msg.meta.correlationId.value().c_str());
+    capture::request(msg);
     if (msg.meta.subject == commands::protocols::Subject) {
-        m_pool.pushWorker<job::Protocols>(msg, m_bus);
+        push<job::Protocols>(msg);
     } else if (msg.meta.subject == commands::mibs::Subject) {
-        m_pool.pushWorker<job::Mibs>(msg, m_bus);
+        push<job::Mibs>(msg);
     } else if (msg.meta.subject == commands::assets::Subject) {
-        m_pool.pushWorker<job::Assets>(msg, m_bus);
+        push<job::Assets>(msg);
+    } else if (msg.meta.subject == commands::delta::Subject) {
+        push<job::AssetsDelta>(msg);
+    } else if (msg.meta.subject == commands::hosts::Subject) {
+        push<job::Hosts>(msg);
+    } else if (msg.meta.subject == commands::forget::Subject) {
+        push<job::Forget>(msg);
+    } else if (msg.meta.subject == commands::schedule::Subject) {
+        push<job::Schedule>(msg);
+    } else if (msg.meta.subject == commands::unschedule::Subject) {
+        push<job::Unschedule>(msg);
+    } else if (msg.meta.subject == commands::watch::Subject) {
+        push<job::Watch>(msg);
+    } else if (msg.meta.subject == commands::stats::Subject) {
+        push<job::Stats>(msg);
+    } else if (msg.meta.subject == commands::trace::Subject) {
+        push<job::Tracing>(msg);
+    } else if (msg.meta.subject == commands::memory::Subject) {
+        push<job::Memory>(msg);
+    } else if (msg.meta.subject == commands::inspect::Subject) {
+        // Not queued, busy or stuck workers must not delay the answer
+        job::queuedJobs().inc();
+        job::Inspect(msg, m_bus)();
     }
 }
 
@@ -52,6 +52,10 @@ private:
     void discover(const Message& msg);
     void doStop();
 
+    /// Queues the job to the worker pool
+    template <typename T>
+    void push(const Message& msg);
+
 private:
     std::string m_configPath;
     MessageBus  m_bus;
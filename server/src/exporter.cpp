@@ -0,0 +1,235 @@
+/*  =========================================================================
+    exporter.cpp - Metrics endpoint for Prometheus scrapes
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "exporter.h"
+#include "metrics.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fty_log.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace fty {
+
+// =====================================================================================================================
+
+Exporter& Exporter::instance()
+{
+    static Exporter inst;
+    return inst;
+}
+
+Exporter::~Exporter()
+{
+    stop();
+}
+
+Expected<void> Exporter::start(const std::string& socket, uint16_t port)
+{
+    if (!m_stop) {
+        return unexpected("Exporter is already started");
+    }
+
+    if (!socket.empty()) {
+        if (auto res = listenUnix(socket); !res) {
+            stop();
+            return unexpected(res.error());
+        }
+    }
+    if (port) {
+        if (auto res = listenTcp(port); !res) {
+            stop();
+            return unexpected(res.error());
+        }
+    }
+    if (m_fds.empty()) {
+        return {};
+    }
+
+    m_stop   = false;
+    m_thread = std::thread(&Exporter::loop, this);
+    return {};
+}
+
+void Exporter::stop()
+{
+    m_stop = true;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    for (int fd : m_fds) {
+        ::close(fd);
+    }
+    m_fds.clear();
+
+    // Only our own socket, the path could be taken over since
+    if (struct stat st; !m_path.empty() && stat(m_path.c_str(), &st) == 0 && st.st_dev == m_dev &&
+                        st.st_ino == m_inode) {
+        unlink(m_path.c_str());
+    }
+    m_path.clear();
+}
+
+Expected<void> Exporter::listenUnix(const std::string& path)
+{
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return unexpected("Metrics socket path {} is too long", path);
+    }
+
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    // Socket left by a crashed run refuses connections and is replaced, a live one belongs to another process
+    if (struct stat st; lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (probe < 0) {
+            return unexpected("Cannot create socket: {}", strerror(errno));
+        }
+        int ret = ::connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        int err = errno;
+        ::close(probe);
+        if (ret == 0) {
+            return unexpected("Metrics socket {} is used by another process", path);
+        }
+        if (err == ECONNREFUSED) {
+            unlink(path.c_str());
+        }
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return unexpected("Cannot create socket: {}", strerror(errno));
+    }
+
+    struct stat st;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 16) != 0 ||
+        stat(path.c_str(), &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        return unexpected("Cannot listen on {}: {}", path, strerror(err));
+    }
+
+    m_fds.push_back(fd);
+    m_path  = path;
+    m_dev   = st.st_dev;
+    m_inode = st.st_ino;
+    return {};
+}
+
+Expected<void> Exporter::listenTcp(uint16_t port)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return unexpected("Cannot create socket: {}", strerror(errno));
+    }
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 16) != 0) {
+        int err = errno;
+        ::close(fd);
+        return unexpected("Cannot listen on 127.0.0.1:{}: {}", port, strerror(err));
+    }
+
+    m_fds.push_back(fd);
+    return {};
+}
+
+void Exporter::loop()
+{
+    std::vector<pollfd> pfds;
+    for (int fd : m_fds) {
+        pfds.push_back(pollfd{fd, POLLIN, 0});
+    }
+
+    while (!m_stop) {
+        if (poll(pfds.data(), pfds.size(), 200) <= 0) {
+            continue;
+        }
+        for (auto& pfd : pfds) {
+            if (!(pfd.revents & POLLIN)) {
+                continue;
+            }
+            if (int fd = accept4(pfd.fd, nullptr, nullptr, SOCK_CLOEXEC); fd >= 0) {
+                serve(fd);
+                ::close(fd);
+            }
+        }
+    }
+}
+
+void Exporter::serve(int fd) const
+{
+    // Slow scraper must not block the next ones
+    timeval timeout{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Request line and headers, the body of GET is empty
+    std::string request;
+    char        buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, 1000) <= 0) {
+            return;
+        }
+        ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+        if (got <= 0) {
+            return;
+        }
+        request.append(buffer, size_t(got));
+    }
+
+    std::string status = "200 OK";
+    std::string body;
+    if (request.rfind("GET /metrics ", 0) == 0 || request.rfind("GET / ", 0) == 0) {
+        body = metrics::render();
+    } else {
+        status = "404 Not Found";
+    }
+
+    std::string answer = "HTTP/1.0 " + status + "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                         std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+    for (size_t sent = 0; sent < answer.size();) {
+        ssize_t cnt = send(fd, answer.data() + sent, answer.size() - sent, MSG_NOSIGNAL);
+        if (cnt <= 0) {
+            log_debug("Exporter: cannot send metrics: %s", strerror(errno));
+            return;
+        }
+        sent += size_t(cnt);
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty
@@ -0,0 +1,67 @@
+/*  =========================================================================
+    exporter.h - Metrics endpoint for Prometheus scrapes
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <atomic>
+#include <fty/expected.h>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+#include <vector>
+
+namespace fty {
+
+// =====================================================================================================================
+
+/// Serves `metrics::render()` to Prometheus scrapes (`GET /metrics` over HTTP/1.0) on unix socket `metrics-socket`
+/// and/or `127.0.0.1:metrics-port`. One thread answers scrapes one by one, metrics are only read while rendering.
+class Exporter
+{
+public:
+    static Exporter& instance();
+    ~Exporter();
+
+    /// Listens on the socket path and on the local port, empty path or zero port is not used
+    Expected<void> start(const std::string& socket, uint16_t port);
+
+    /// Stops serving and removes the socket file it created
+    void stop();
+
+private:
+    Exporter() = default;
+
+    Expected<void> listenUnix(const std::string& path);
+    Expected<void> listenTcp(uint16_t port);
+    void           loop();
+    void           serve(int fd) const;
+
+private:
+    std::vector<int>  m_fds;
+    std::string       m_path;
+    dev_t             m_dev   = 0;
+    ino_t             m_inode = 0;
+    std::thread       m_thread;
+    std::atomic<bool> m_stop = true;
+};
+
+// =====================================================================================================================
+
+} // namespace fty
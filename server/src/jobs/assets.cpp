@@ -15,19 +15,27 @@
 */
 
 #include "assets.h"
+#include "capture.h"
+#include "impl/delta.h"
 #include "impl/mibs.h"
 #include "impl/nut/mapper.h"
+#include "impl/negative-cache.h"
 #include "impl/nut/process.h"
-#include "impl/ping.h"
 #include "impl/uuid.h"
+#include "inspect.h"
+#include "logger.h"
+#include "store.h"
+#include "watchers.h"
 #include <fty/string-utils.h>
 
 namespace fty::job {
 
 void Assets::run(const commands::assets::In& in, commands::assets::Out& out)
 {
-    if (!available(in.address)) {
-        throw Error("Host is not available: {}", in.address.value());
+    stats::Timer timer(stats::Stage::Assets);
+
+    if (auto res = impl::checkHost(in.address, in.force); !res) {
+        throw Error(res.error());
     }
 
     m_params = in;
@@ -38,6 +46,7 @@ void Assets::run(const commands::assets::In& in, commands::assets::Out& out)
         }
 
         impl::MibsReader reader(m_params.address, uint16_t(m_params.port.value()));
+        reader.setForce(m_params.force);
 
         if (m_params.settings.credentialId.hasValue()) {
             if (auto res = reader.setCredentialId(m_params.settings.credentialId); !res) {
@@ -51,7 +60,13 @@ void Assets::run(const commands::assets::In& in, commands::assets::Out& out)
             throw Error("Credential or community must be set");
         }
 
-        if (auto mibs = reader.read(); !mibs) {
+        std::string key = impl::FingerprintCache::key(m_params.address, uint16_t(m_params.port.value()),
+            m_params.settings.credentialId, m_params.settings.community);
+
+        auto mibs = impl::NegativeCache::instance().guard(key, "snmp", m_params.force, [&]() {
+            return reader.read();
+        });
+        if (!mibs) {
             throw Error(mibs.error());
         } else {
             if (!m_params.settings.mib.hasValue()) {
@@ -60,47 +75,63 @@ void Assets::run(const commands::assets::In& in, commands::assets::Out& out)
         }
     }
 
-    // Runs nut process
+    // Runs nut process, or takes its output from the replayed capture
+    std::string driverKey = m_params.protocol.value() + ":" + std::to_string(m_params.port.value());
+    if (auto cnt = capture::exchangeOne(capture::kind::Driver, m_params.address, driverKey, [&]() {
+            return runDriver();
+        })) {
+        parse(*cnt, out);
+        store(out);
+
+        auto key = impl::AssetsHistory::key(m_params.address, m_params.port, m_params.protocol);
+        m_delta  = impl::AssetsHistory::instance().update(key, out);
+        Watchers::instance().notify(m_params.address, m_params.port, m_params.protocol, m_delta);
+    } else {
+        throw Error(cnt.error());
+    }
+}
+
+Expected<std::string> Assets::runDriver() const
+{
     impl::nut::Process proc(m_params.protocol);
-    if (auto res = proc.init(m_params.address, uint16_t(m_params.port.value()))) {
-        if (m_params.settings.credentialId.hasValue()) {
-            if (auto set = proc.setCredentialId(m_params.settings.credentialId); !set) {
-                throw Error(set.error());
-            }
-        } else if (m_params.settings.community.hasValue()) {
-            if (auto set = proc.setCommunity(m_params.settings.community); !set) {
-                throw Error(set.error());
-            }
-        }
-        if (m_params.settings.username.hasValue() && m_params.settings.password.hasValue()) {
-            proc.setCredential(m_params.settings.username, m_params.settings.password);
-        }
+    if (auto res = proc.init(m_params.address, uint16_t(m_params.port.value())); !res) {
+        return unexpected(res.error());
+    }
 
-        if (m_params.settings.timeout.hasValue()) {
-            proc.setTimeout(m_params.settings.timeout);
+    if (m_params.settings.credentialId.hasValue()) {
+        if (auto set = proc.setCredentialId(m_params.settings.credentialId); !set) {
+            return unexpected(set.error());
         }
-
-        if (m_params.settings.mib.hasValue()) {
-            proc.setMib(m_params.settings.mib);
+    } else if (m_params.settings.community.hasValue()) {
+        if (auto set = proc.setCommunity(m_params.settings.community); !set) {
+            return unexpected(set.error());
         }
+    }
+    if (m_params.settings.username.hasValue() && m_params.settings.password.hasValue()) {
+        proc.setCredential(m_params.settings.username, m_params.settings.password);
+    }
 
-        if (auto cnt = proc.run()) {
-            parse(*cnt, out);
-        } else {
-            throw Error(cnt.error());
-        }
-    } else {
-        throw Error(res.error());
+    if (m_params.settings.timeout.hasValue()) {
+        proc.setTimeout(m_params.settings.timeout);
+    }
+
+    if (m_params.settings.mib.hasValue()) {
+        proc.setMib(m_params.settings.mib);
     }
+
+    return proc.run();
 }
 
 void Assets::parse(const std::string& cnt, commands::assets::Out& out)
 {
+    stats::Timer   timer(stats::Stage::Parse);
+    inspect::Stage stage("parsing driver output");
+
     static std::regex rex("([a-z0-9\\.]+)\\s*:\\s+(.*)");
 
     std::map<std::string, std::string> tmpMap;
 
-    log_debug(cnt.c_str());
+    slog_debug("Assets: driver output", {{"output", cnt}});
 
     std::stringstream ss(cnt);
     for (std::string line; std::getline(ss, line);) {
@@ -151,6 +182,39 @@ void Assets::parse(const std::string& cnt, commands::assets::Out& out)
     }
 }
 
+const commands::delta::Out& Assets::delta() const
+{
+    return m_delta;
+}
+
+void Assets::store(const commands::assets::Out& out)
+{
+    if (!Store::instance().isOpen()) {
+        return;
+    }
+
+    auto res = Store::instance().update(m_params.address, [&](Store::Host& host) {
+        host.driver = m_params.protocol.value();
+        if (m_params.settings.credentialId.hasValue()) {
+            host.credentialId = m_params.settings.credentialId.value();
+        }
+
+        host.uuids.clear();
+        for (const auto& asset : out) {
+            auto uuid = asset.asset.ext.find([](const pack::StringMap& info) {
+                return info.contains("uuid");
+            });
+            if (uuid != std::nullopt && !(*uuid)["uuid"].empty()) {
+                host.uuids.append((*uuid)["uuid"]);
+            }
+        }
+    });
+
+    if (!res) {
+        log_error("Cannot store assets of %s: %s", m_params.address.value().c_str(), res.error().c_str());
+    }
+}
+
 void Assets::addAssetVal(commands::assets::Return::Asset& asset, const std::string& key, const std::string& val, bool readOnly)
 {
     auto& ext = asset.ext.append();
@@ -160,6 +224,8 @@ void Assets::addAssetVal(commands::assets::Return::Asset& asset, const std::stri
 
 void Assets::enrichAsset(commands::assets::Return& asset)
 {
+    stats::Timer timer(stats::Stage::Enrich);
+
     if(asset.asset.subtype.empty()) {
         auto type = asset.asset.ext.find([](const pack::StringMap& info) {
             return info.contains("device.type");
@@ -245,4 +311,19 @@ void Assets::enrichAsset(commands::assets::Return& asset)
 }
 
 
+// =====================================================================================================================
+
+void AssetsDelta::run(const commands::delta::In& in, commands::delta::Out& out)
+{
+    // Runs inside this job, without subject it is not listed as another one (see inspect::Job)
+    Assets assets(Message(), *m_bus);
+
+    commands::assets::Out full;
+    assets.run(in, full);
+
+    out = assets.delta();
+}
+
+// =====================================================================================================================
+
 } // namespace fty::job
@@ -30,13 +30,35 @@ public:
 
     /// Runs discover job.
     void run(const commands::assets::In& in, commands::assets::Out& out);
-private:
+
+    /// Difference against the previous discovery of the device, valid after run
+    const commands::delta::Out& delta() const;
+
+    /// Parses output of nut driver dump
     void parse(const std::string& cnt, commands::assets::Out& out);
+
+private:
     void addAssetVal(commands::assets::Return::Asset& asset, const std::string& key, const std::string& val, bool readOnly = true);
     void enrichAsset(commands::assets::Return& asset);
+    void store(const commands::assets::Out& out);
+
+    /// Runs nut driver dump of the device
+    Expected<std::string> runDriver() const;
 
 private:
     commands::assets::In m_params;
+    commands::delta::Out m_delta;
+};
+
+/// Discover Assets from enpoint and compares them with the previous discovery of the same device
+/// Returns @ref commands::delta::Out (only changes or `unchanged` flag)
+class AssetsDelta : public Task<AssetsDelta, commands::delta::In, commands::delta::Out>
+{
+public:
+    using Task::Task;
+
+    /// Runs discover job.
+    void run(const commands::delta::In& in, commands::delta::Out& out);
 };
 
 } // namespace fty::job
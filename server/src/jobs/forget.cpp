@@ -0,0 +1,39 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "forget.h"
+#include "impl/delta.h"
+#include "impl/fingerprint.h"
+#include "impl/negative-cache.h"
+
+namespace fty::job {
+
+// =====================================================================================================================
+
+void Forget::run(const commands::forget::In& in, commands::forget::Out& out)
+{
+    if (in.address.empty()) {
+        throw Error("Address is empty");
+    }
+
+    impl::FingerprintCache::instance().forget(in.address);
+    impl::AssetsHistory::instance().forget(in.address);
+    out.setValue(impl::NegativeCache::instance().forget(in.address));
+}
+
+// =====================================================================================================================
+
+} // namespace fty::job
@@ -0,0 +1,47 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "hosts.h"
+#include "store.h"
+
+namespace fty::job {
+
+// =====================================================================================================================
+
+void Hosts::run(const commands::hosts::In& in, commands::hosts::Out& out)
+{
+    auto& store = Store::instance();
+    if (!store.isOpen()) {
+        throw Error("Store is not configured");
+    }
+
+    if (in.address.hasValue()) {
+        if (auto host = store.find(in.address)) {
+            out.append(*host);
+        } else {
+            throw Error("Host is not known: {}", in.address.value());
+        }
+        return;
+    }
+
+    for (const auto& host : store.all()) {
+        out.append(host);
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::job
@@ -0,0 +1,37 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "discovery-task.h"
+
+// =====================================================================================================================
+
+namespace fty::job {
+
+/// Returns known hosts from the persistent store
+/// Returns @ref commands::hosts::Out (list of hosts, one host if address was requested)
+class Hosts : public Task<Hosts, commands::hosts::In, commands::hosts::Out>
+{
+public:
+    using Task::Task;
+
+    /// Runs query job.
+    void run(const commands::hosts::In& in, commands::hosts::Out& out);
+};
+
+} // namespace fty::job
+
+// =====================================================================================================================
@@ -0,0 +1,174 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "delta.h"
+#include <algorithm>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+using Values = std::map<std::string, std::string>;
+
+/// Flattens unit into `key -> value`, read only flags are not part of the value
+static Values flatten(const commands::assets::Return& unit)
+{
+    Values values;
+    values["type"]     = unit.asset.type;
+    values["sub_type"] = unit.asset.subtype;
+    for (const auto& ext : unit.asset.ext) {
+        for (const auto& [key, value] : ext.value()) {
+            if (key != "read_only") {
+                values[key] = value;
+            }
+        }
+    }
+    return values;
+}
+
+static std::map<std::string, const commands::assets::Return*> bySubAddress(const commands::assets::Out& assets)
+{
+    std::map<std::string, const commands::assets::Return*> units;
+    for (const auto& unit : assets) {
+        units[unit.subAddress] = &unit;
+    }
+    return units;
+}
+
+// =====================================================================================================================
+
+AssetsHistory& AssetsHistory::instance()
+{
+    static AssetsHistory inst;
+    return inst;
+}
+
+/// Host part of the key, IPv6 address is bracketed, so address could be found in the key again
+static std::string host(const std::string& address)
+{
+    return address.find(':') != std::string::npos ? "[" + address + "]" : address;
+}
+
+std::string AssetsHistory::key(const std::string& address, uint32_t port, const std::string& protocol)
+{
+    return host(address) + ":" + std::to_string(port) + "/" + protocol;
+}
+
+commands::delta::Out AssetsHistory::update(const std::string& key, const commands::assets::Out& assets)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto found = m_last.find(key);
+    if (found == m_last.end() && m_last.size() >= MaxDevices) {
+        // Devices discovered once and never again should not stay forever
+        auto oldest = std::min_element(m_last.begin(), m_last.end(), [](const auto& l, const auto& r) {
+            return l.second.updated < r.second.updated;
+        });
+        m_last.erase(oldest);
+    }
+
+    auto&                last  = m_last[key];
+    commands::delta::Out delta = diff(last.assets, assets);
+    last.assets.clear();
+    for (const auto& unit : assets) {
+        last.assets.append(unit);
+    }
+    last.updated = std::chrono::steady_clock::now();
+    return delta;
+}
+
+void AssetsHistory::forget(const std::string& address, uint32_t port, const std::string& protocol)
+{
+    // Host is bracketed or has no colon, so the prefix never matches another address
+    std::string prefix = host(address) + ":" + (port ? std::to_string(port) + "/" : "");
+    std::string suffix = "/" + protocol;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_last.begin(); it != m_last.end();) {
+        const std::string& key = it->first;
+        if (key.compare(0, prefix.size(), prefix) == 0 &&
+            (protocol.empty() || key.substr(key.find('/', prefix.size() - 1)) == suffix)) {
+            it = m_last.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t AssetsHistory::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_last.size();
+}
+
+void AssetsHistory::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_last.clear();
+}
+
+commands::delta::Out AssetsHistory::diff(const commands::assets::Out& before, const commands::assets::Out& after)
+{
+    commands::delta::Out delta;
+
+    auto prev = bySubAddress(before);
+    auto curr = bySubAddress(after);
+
+    for (const auto& [subAddress, unit] : prev) {
+        if (!curr.count(subAddress)) {
+            delta.removed.append(subAddress);
+        }
+    }
+
+    for (const auto& [subAddress, unit] : curr) {
+        auto it = prev.find(subAddress);
+        if (it == prev.end()) {
+            delta.added.append(*unit);
+            continue;
+        }
+
+        Values oldValues = flatten(*it->second);
+        Values newValues = flatten(*unit);
+
+        auto change = [&, sub = subAddress](const std::string& key, const std::string& from, const std::string& to) {
+            auto& chg      = delta.changed.append();
+            chg.subAddress = sub;
+            chg.key        = key;
+            chg.before     = from;
+            chg.after      = to;
+        };
+
+        for (const auto& [key, value] : oldValues) {
+            if (auto found = newValues.find(key); found == newValues.end()) {
+                change(key, value, "");
+            } else if (found->second != value) {
+                change(key, value, found->second);
+            }
+        }
+        for (const auto& [key, value] : newValues) {
+            if (!oldValues.count(key)) {
+                change(key, "", value);
+            }
+        }
+    }
+
+    delta.unchanged = delta.added.empty() && delta.removed.empty() && delta.changed.empty();
+    return delta;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl
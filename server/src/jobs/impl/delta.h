@@ -0,0 +1,72 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "commands.h"
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Last discovered assets per device, used to compute what changed since previous discovery.
+/// Keeps at most @ref MaxDevices devices, the least recently discovered one is dropped first.
+class AssetsHistory
+{
+public:
+    static constexpr size_t MaxDevices = 4096;
+
+public:
+    static AssetsHistory& instance();
+
+    /// Builds device key, IPv6 address is bracketed
+    static std::string key(const std::string& address, uint32_t port, const std::string& protocol);
+
+    /// Compares assets with the previous result of the device and remembers them as the last result
+    commands::delta::Out update(const std::string& key, const commands::assets::Out& assets);
+
+    /// Forgets devices of the address, all ports and protocols if not set
+    void forget(const std::string& address, uint32_t port = 0, const std::string& protocol = {});
+
+    /// Number of remembered devices
+    size_t size() const;
+
+    /// Forgets all devices
+    void clear();
+
+    /// Computes field level difference between two discoveries
+    static commands::delta::Out diff(const commands::assets::Out& before, const commands::assets::Out& after);
+
+private:
+    struct Entry
+    {
+        commands::assets::Out                 assets;
+        std::chrono::steady_clock::time_point updated;
+    };
+
+    AssetsHistory() = default;
+
+private:
+    mutable std::mutex           m_mutex;
+    std::map<std::string, Entry> m_last;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -0,0 +1,236 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "fingerprint.h"
+#include "metrics.h"
+#include "src/config.h"
+#include "src/store.h"
+#include <algorithm>
+#include <fty_log.h>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+bool Fingerprint::matchSnmp(const Fingerprint& current) const
+{
+    return objectId == current.objectId && descr == current.descr && upTime <= current.upTime;
+}
+
+bool Fingerprint::matchXml(const Fingerprint& current) const
+{
+    return !product.empty() && product == current.product && version == current.version;
+}
+
+// =====================================================================================================================
+
+FingerprintCache& FingerprintCache::instance()
+{
+    static FingerprintCache inst;
+    return inst;
+}
+
+/// Separates hashed community in the key
+static constexpr char CommunityMark = '#';
+
+/// Checks if detection results or identity differ, sysUpTime going back means restart
+static bool changed(const Fingerprint& before, const Fingerprint& after)
+{
+    return before.objectId != after.objectId || before.descr != after.descr || before.product != after.product ||
+           before.version != after.version || before.protocols != after.protocols || before.mibs != after.mibs ||
+           after.upTime < before.upTime;
+}
+
+std::string FingerprintCache::key(
+    const std::string& address, uint16_t port, const std::string& credentialId, const std::string& community)
+{
+    if (!port) {
+        return address;
+    }
+
+    // IPv6 address is bracketed, so address could be found in the key again
+    std::string key = (address.find(':') != std::string::npos ? "[" + address + "]" : address) + ":" +
+                      std::to_string(port);
+    if (!credentialId.empty()) {
+        key += "/" + credentialId;
+    } else if (!community.empty()) {
+        // Do not keep community in memory as is, the hash is not salted so it never goes to the store
+        key += CommunityMark + std::to_string(std::hash<std::string>{}(community));
+    }
+    return key;
+}
+
+bool FingerprintCache::persistent(const std::string& key)
+{
+    return key.find(CommunityMark) == std::string::npos;
+}
+
+std::string FingerprintCache::addressOf(const std::string& key)
+{
+    if (key.size() && key[0] == '[') {
+        return key.substr(1, key.find(']') - 1);
+    }
+    if (std::count(key.begin(), key.end(), ':') > 1) {
+        // Bare IPv6 address
+        return key;
+    }
+    return key.substr(0, key.find(':'));
+}
+
+static uint64_t unixTime(std::chrono::steady_clock::time_point point)
+{
+    using namespace std::chrono;
+
+    auto age = duration_cast<system_clock::duration>(steady_clock::now() - point);
+    return uint64_t(duration_cast<seconds>((system_clock::now() - age).time_since_epoch()).count());
+}
+
+size_t FingerprintCache::preload()
+{
+    auto ttl = std::chrono::seconds(Config::instance().fingerprintTtl.value());
+    if (ttl.count() == 0 || !Store::instance().isOpen()) {
+        return 0;
+    }
+
+    auto   now    = std::chrono::system_clock::now();
+    size_t loaded = 0;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& host : Store::instance().all()) {
+        for (const auto& saved : host.fingerprints) {
+            auto age = now - std::chrono::system_clock::time_point(std::chrono::seconds(saved.updated.value()));
+            if (age >= ttl || m_cache.count(saved.key) || !persistent(saved.key)) {
+                continue;
+            }
+            if (age.count() < 0) {
+                // Clock was moved back
+                age = {};
+            }
+
+            Fingerprint& print = m_cache[saved.key];
+            print.objectId     = saved.objectId;
+            print.descr        = saved.descr;
+            print.upTime       = saved.upTime;
+            print.product      = saved.product;
+            print.version      = saved.version;
+            print.protocols    = saved.protocols.value();
+            print.mibs         = saved.mibs.value();
+            print.rtt          = saved.rtt;
+            print.updated      = std::chrono::steady_clock::now() -
+                            std::chrono::duration_cast<std::chrono::steady_clock::duration>(age);
+            print.saved        = print.updated;
+            ++loaded;
+        }
+    }
+    return loaded;
+}
+
+std::optional<Fingerprint> FingerprintCache::find(const std::string& key) const
+{
+    auto ttl = std::chrono::seconds(Config::instance().fingerprintTtl.value());
+    if (ttl.count() == 0) {
+        return std::nullopt;
+    }
+
+    static auto& hits   = metrics::cacheLookups("fingerprint", true);
+    static auto& misses = metrics::cacheLookups("fingerprint", false);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_cache.find(key);
+    if (it != m_cache.end() && it->second.updated + ttl > std::chrono::steady_clock::now()) {
+        hits.inc();
+        return it->second;
+    }
+    misses.inc();
+    return std::nullopt;
+}
+
+void FingerprintCache::update(const std::string& key, const std::function<void(Fingerprint&)>& func)
+{
+    // Store update is synced to disk, refresh of a matched fingerprint (uptime, rtt) is only worth it before the
+    // stored one would expire on the next start
+    auto verify = std::chrono::seconds(Config::instance().fingerprintTtl.value()) / 2;
+    bool save   = persistent(key) && Store::instance().isOpen();
+
+    Fingerprint print;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto [it, created] = m_cache.try_emplace(key);
+        Fingerprint before = it->second;
+
+        func(it->second);
+        it->second.updated = std::chrono::steady_clock::now();
+        save = save && (created || changed(before, it->second) ||
+                          (verify.count() && it->second.updated - before.saved >= verify));
+        if (save) {
+            it->second.saved = it->second.updated;
+        }
+        print = it->second;
+    }
+
+    if (!save) {
+        return;
+    }
+
+    commands::hosts::Fingerprint saved;
+    saved.key      = key;
+    saved.objectId = print.objectId;
+    saved.descr    = print.descr;
+    saved.upTime   = print.upTime;
+    saved.product  = print.product;
+    saved.version  = print.version;
+    saved.protocols.setValue(print.protocols);
+    saved.mibs.setValue(print.mibs);
+    saved.rtt     = print.rtt;
+    saved.updated = unixTime(print.updated);
+
+    std::string address = addressOf(key);
+    auto        res     = Store::instance().update(address, [&](Store::Host& host) {
+        auto prints = host.fingerprints;
+        host.fingerprints.clear();
+        for (const auto& it : prints) {
+            if (it.key.value() != key) {
+                host.fingerprints.append(it);
+            }
+        }
+        host.fingerprints.append(saved);
+    });
+    if (!res) {
+        log_error("Cannot store fingerprint of %s: %s", address.c_str(), res.error().c_str());
+    }
+}
+
+void FingerprintCache::forget(const std::string& address)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        if (addressOf(it->first) == address) {
+            it = m_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FingerprintCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cache.clear();
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl
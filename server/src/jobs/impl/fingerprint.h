@@ -0,0 +1,102 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Cheap identity of the device and results of the full detection made for it.
+/// If identity read from the device still matches, detection results are reused instead of probing everything again.
+struct Fingerprint
+{
+    std::string              objectId;   // SNMP sysObjectID.0, empty if agent does not provide it
+    std::string              descr;      // SNMP sysDescr.0
+    uint64_t                 upTime = 0; // SNMP sysUpTime.0 in timeticks, decreases if device was restarted
+    std::string              product;    // XML product.xml name
+    std::string              version;    // XML product.xml firmware version
+    std::vector<std::string> protocols;  // detected protocols
+    std::vector<std::string> mibs;       // detected mibs
+    uint32_t                 rtt = 0;    // milliseconds, round trip of the last identity request
+
+    std::chrono::steady_clock::time_point updated; // last detection or match
+    std::chrono::steady_clock::time_point saved;   // last write to the store
+
+    /// Checks if SNMP identity read now belongs to the same, not restarted device
+    bool matchSnmp(const Fingerprint& current) const;
+
+    /// Checks if XML identity read now belongs to the same device with the same firmware
+    bool matchXml(const Fingerprint& current) const;
+};
+
+// =====================================================================================================================
+
+/// In memory cache of device fingerprints.
+/// Protocols fingerprints are keyed by address, SNMP ones by address, port and credentials (see @ref key).
+/// Entries older than `fingerprint-ttl` from config are ignored.
+/// Updates changing detection results are saved to the store (if opened), refreshes of matched fingerprints only once
+/// per half of the ttl, so the stored time of a stable device does not expire. Fingerprints keyed by community are
+/// never saved. @ref preload fills the cache from the store on start.
+class FingerprintCache
+{
+public:
+    static FingerprintCache& instance();
+
+    /// Builds cache key, SNMP view of the device depends on credentials so they are part of the key.
+    /// Credential id is preferred, community is only hashed into the key and such key is not persistent.
+    static std::string key(const std::string& address, uint16_t port = 0, const std::string& credentialId = {},
+        const std::string& community = {});
+
+    /// Checks if fingerprint of the key could be saved to the store
+    static bool persistent(const std::string& key);
+
+    /// Returns address the key was built for
+    static std::string addressOf(const std::string& key);
+
+    /// Loads saved fingerprints which are still valid, returns count of loaded ones
+    size_t preload();
+
+    /// Returns valid fingerprint
+    std::optional<Fingerprint> find(const std::string& key) const;
+
+    /// Updates (creates) fingerprint
+    void update(const std::string& key, const std::function<void(Fingerprint&)>& func);
+
+    /// Removes all fingerprints of the address
+    void forget(const std::string& address);
+
+    /// Removes all fingerprints
+    void clear();
+
+private:
+    FingerprintCache() = default;
+
+private:
+    mutable std::mutex                 m_mutex;
+    std::map<std::string, Fingerprint> m_cache;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -17,6 +17,7 @@
 #include "mibs.h"
 #include "snmp.h"
 #include "src/config.h"
+#include <fty/string-utils.h>
 #include <regex>
 #include <fty_log.h>
 #include <iostream>
@@ -26,6 +27,32 @@ namespace fty::impl {
 
 // =====================================================================================================================
 
+bool sortMibs(const std::string& l, const std::string& r)
+{
+    try {
+        // clang-format off
+        static const std::vector<std::regex> snmpMibPriority = {
+            std::regex("XUPS-MIB"),
+            std::regex("MG-SNMP-UPS-MIB"),
+            std::regex(".+")
+        };
+        // clang-format on
+
+        auto index = [&](const std::string& mib) -> size_t {
+            for (size_t i = 0; i < snmpMibPriority.size(); ++i) {
+                if (std::regex_match(mib, snmpMibPriority[i])) {
+                    return i;
+                }
+            }
+            return 999;
+        };
+
+        return index(l) < index(r);
+    } catch (...) {
+        return false;
+    }
+}
+
 bool filterMib(const std::string& mib)
 {
     static std::regex rex("^(IP-MIB|DISMAN-EVENT-MIB|RFC1213-MIB|SNMP-|TCP-MIB|UDP-MIB).*");
@@ -109,17 +136,21 @@ std::string mapMibToLegacy(const std::string& mib)
 // =====================================================================================================================
 
 MibsReader::MibsReader(const std::string& address, uint16_t port)
-    : m_session(Snmp::instance().session(address, port))
+    : m_address(address)
+    , m_port(port)
+    , m_session(Snmp::instance().session(address, port))
 {
 }
 
 Expected<void> MibsReader::setCredentialId(const std::string& credentialId)
 {
+    m_credentialId = credentialId;
     return m_session->setCredentialId(credentialId);
 }
 
 Expected<void> MibsReader::setCommunity(const std::string& community)
 {
+    m_community = community;
     return m_session->setCommunity(community);
 }
 
@@ -128,7 +159,12 @@ Expected<void> MibsReader::setTimeout(uint miliseconds)
     return m_session->setTimeout(miliseconds);
 }
 
-Expected<MibsReader::MibList> MibsReader::read() const
+void MibsReader::setForce(bool force)
+{
+    m_force = force;
+}
+
+Expected<void> MibsReader::open() const
 {
     if (!m_isOpen) {
         if (auto res = m_session->open(); !res) {
@@ -136,16 +172,91 @@ Expected<MibsReader::MibList> MibsReader::read() const
         }
         m_isOpen = true;
     }
+    return {};
+}
+
+Expected<Fingerprint> MibsReader::readIdentity(bool withObjectId) const
+{
+    // clang-format off
+    static const std::vector<std::string> withOid = {
+        "SNMPv2-MIB::sysDescr.0",
+        "SNMPv2-MIB::sysUpTime.0",
+        "RFC1213-MIB::sysObjectID.0"
+    };
+    // clang-format on
+    static const std::vector<std::string> withoutOid(withOid.begin(), withOid.begin() + 2);
+
+    auto start  = std::chrono::steady_clock::now();
+    auto values = m_session->read(withObjectId ? withOid : withoutOid);
+    if (!values) {
+        return unexpected(values.error());
+    }
+
+    Fingerprint print;
+    print.rtt = uint32_t(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+    print.descr  = (*values)[0];
+    print.upTime = convert<uint64_t>((*values)[1]);
+    if (withObjectId) {
+        print.objectId = (*values)[2];
+    }
+    return print;
+}
+
+Expected<Fingerprint> MibsReader::identity() const
+{
+    if (m_identity) {
+        return *m_identity;
+    }
+
+    if (auto res = open(); !res) {
+        return unexpected(res.error());
+    }
+
+    // Ask exactly what is cached to check it with one request, otherwise try sysObjectID first, some agents miss it
+    auto key    = FingerprintCache::key(m_address, m_port, m_credentialId, m_community);
+    auto cached = m_force ? std::nullopt : FingerprintCache::instance().find(key);
+
+    bool withObjectId = !cached || !cached->objectId.empty();
+    auto print        = readIdentity(withObjectId);
+    if (!print && withObjectId) {
+        print = readIdentity(false);
+    }
+    if (!print) {
+        return unexpected(print.error());
+    }
+
+    m_identity = *print;
+    return *print;
+}
+
+Expected<MibsReader::MibList> MibsReader::read() const
+{
+    if (auto res = open(); !res) {
+        return unexpected(res.error());
+    }
+
+    std::string key    = FingerprintCache::key(m_address, m_port, m_credentialId, m_community);
+    auto        cached = m_force ? std::nullopt : FingerprintCache::instance().find(key);
+    auto        print  = identity();
+
+    if (print && cached && !cached->mibs.empty() && cached->matchSnmp(*print)) {
+        log_debug("Fingerprint of %s:%d matches, skip mibs detection", m_address.c_str(), m_port);
+        FingerprintCache::instance().update(key, [&](Fingerprint& fp) {
+            fp.upTime = print->upTime;
+            fp.rtt    = print->rtt;
+        });
+        return MibList(cached->mibs.begin(), cached->mibs.end());
+    }
 
     MibList mibs;
 
-    auto oid = m_session->read("RFC1213-MIB::sysObjectID.0");
-    if (oid) {
+    if (print && !print->objectId.empty()) {
         size_t pos;
-        if (pos = oid->find("."); pos != std::string::npos) {
-            mibs.insert(oid->substr(0, pos));
+        if (pos = print->objectId.find("."); pos != std::string::npos) {
+            mibs.insert(print->objectId.substr(0, pos));
         } else {
-            mibs.insert(*oid);
+            mibs.insert(print->objectId);
         }
     } else {
         if (fty::Config::instance().tryAll) {
@@ -177,22 +288,26 @@ Expected<MibsReader::MibList> MibsReader::read() const
         }
     }
 
+    if (print) {
+        FingerprintCache::instance().update(key, [&](Fingerprint& fp) {
+            fp.objectId = print->objectId;
+            fp.descr    = print->descr;
+            fp.upTime   = print->upTime;
+            fp.rtt      = print->rtt;
+            fp.mibs.assign(mibs.begin(), mibs.end());
+        });
+    }
+
     return std::move(mibs);
 }
 
 Expected<std::string> MibsReader::readName() const
 {
-    if (!m_isOpen) {
-        if (auto res = m_session->open(); !res) {
-            return unexpected(res.error());
-        }
-        m_isOpen = true;
-    }
-    auto name = m_session->read("SNMPv2-MIB::sysDescr.0");
-    if (!name) {
-        return unexpected(name.error());
+    if (auto print = identity()) {
+        return print->descr;
+    } else {
+        return unexpected(print.error());
     }
-    return *name;
 }
 
 // =====================================================================================================================
@@ -15,6 +15,7 @@
 */
 
 #pragma once
+#include "fingerprint.h"
 #include <fty/expected.h>
 #include <memory>
 #include <set>
@@ -27,6 +28,7 @@ namespace fty::impl {
 bool        isSnmpSupported(const std::string& mib);
 std::string mapMibToLegacy(const std::string& mib);
 bool        filterMib(const std::string& mib);
+bool        sortMibs(const std::string& l, const std::string& r); // orders mibs from the most useful
 
 // =====================================================================================================================
 
@@ -45,13 +47,26 @@ public:
     Expected<void> setCredentialId(const std::string& credentialId);
     Expected<void> setCommunity(const std::string& community);
     Expected<void> setTimeout(uint miliseconds);
+    void           setForce(bool force);
 
+    /// Reads list of mibs, skips detection if device fingerprint matches the cached one
     Expected<MibList>     read() const;
     Expected<std::string> readName() const;
 
 private:
-    snmp::SessionPtr m_session;
-    mutable bool     m_isOpen = false;
+    Expected<void>        open() const;
+    Expected<Fingerprint> identity() const;
+    Expected<Fingerprint> readIdentity(bool withObjectId) const;
+
+private:
+    std::string                        m_address;
+    uint16_t                           m_port;
+    std::string                        m_credentialId;
+    std::string                        m_community;
+    snmp::SessionPtr                   m_session;
+    bool                               m_force  = false;
+    mutable bool                       m_isOpen = false;
+    mutable std::optional<Fingerprint> m_identity;
 };
 
 // =====================================================================================================================
@@ -0,0 +1,173 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "negative-cache.h"
+#include "capture.h"
+#include "fingerprint.h"
+#include "inspect.h"
+#include "ping.h"
+#include "src/config.h"
+#include <algorithm>
+#include <random>
+#include <utility>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+NegativeCache& NegativeCache::instance()
+{
+    static NegativeCache inst;
+    return inst;
+}
+
+/// Set by transports while the guarded call runs on the thread
+static thread_local bool t_unreachable = false;
+
+void NegativeCache::unreachable()
+{
+    t_unreachable = true;
+}
+
+bool NegativeCache::exchangeUnreachable(bool value)
+{
+    return std::exchange(t_unreachable, value);
+}
+
+std::optional<std::string> NegativeCache::find(const std::string& key, const std::string& protocol) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (auto it = m_cache.find({key, protocol}); it != m_cache.end()) {
+        if (std::chrono::steady_clock::now() < it->second.retryAt) {
+            return it->second.error;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<NegativeCache::Kind> NegativeCache::failure(const std::string& key, const std::string& protocol) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (auto it = m_cache.find({key, protocol}); it != m_cache.end()) {
+        return it->second.kind;
+    }
+    return std::nullopt;
+}
+
+void NegativeCache::prune(std::chrono::steady_clock::time_point now, std::chrono::seconds keep)
+{
+    if (now < m_pruneAt) {
+        return;
+    }
+    m_pruneAt = now + keep;
+
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        if (it->second.retryAt + keep < now) {
+            it = m_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void NegativeCache::failed(const std::string& key, const std::string& protocol, Kind kind, const std::string& error)
+{
+    auto base = std::chrono::seconds(Config::instance().negativeBackoff.value());
+    auto max  = std::chrono::seconds(Config::instance().negativeBackoffMax.value());
+    if (base.count() == 0) {
+        return;
+    }
+
+    thread_local std::mt19937 gen(std::random_device{}());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    prune(std::chrono::steady_clock::now(), std::max(base, max));
+
+    auto& entry = m_cache[{key, protocol}];
+    if (entry.failures && entry.kind != kind) {
+        // Host state changed, start over
+        entry.failures = 0;
+    }
+    entry.kind  = kind;
+    entry.error = error;
+    entry.failures++;
+
+    auto backoff = base;
+    for (uint32_t i = 1; i < entry.failures && backoff < max; ++i) {
+        backoff *= 2;
+    }
+    backoff = std::min(backoff, std::max(base, max));
+
+    std::uniform_real_distribution<double> jitter(0.8, 1.2);
+    entry.retryAt = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(backoff * jitter(gen));
+}
+
+void NegativeCache::succeeded(const std::string& key, const std::string& protocol)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cache.erase({key, protocol});
+}
+
+std::vector<std::string> NegativeCache::forget(const std::string& address)
+{
+    std::vector<std::string> removed;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        const std::string& key = it->first.first;
+        if (FingerprintCache::addressOf(key) == address) {
+            removed.push_back(key + "/" + it->first.second);
+            it = m_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return removed;
+}
+
+void NegativeCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cache.clear();
+}
+
+// =====================================================================================================================
+
+Expected<void> checkHost(const std::string& address, bool force)
+{
+    return NegativeCache::instance().guard(address, "host", force, [&]() -> Expected<void> {
+        stats::Timer   timer(stats::Stage::Liveness);
+        inspect::Stage stage("checking {} is alive", address);
+
+        auto alive = capture::exchangeOne(capture::kind::Host, address, "available", [&]() -> Expected<std::string> {
+            if (!available(address)) {
+                NegativeCache::unreachable();
+                return unexpected("Host is not available: {}", address);
+            }
+            return std::string("yes");
+        });
+        if (!alive) {
+            timer.fail();
+            return unexpected(alive.error());
+        }
+        return {};
+    });
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl
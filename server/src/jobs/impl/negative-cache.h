@@ -0,0 +1,128 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "metrics.h"
+#include <chrono>
+#include <fty/expected.h>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Remembers failed detections per host and protocol.
+/// Repeated request is answered with the remembered error until backoff time (growing twice after every failure up to
+/// `negative-backoff-max`, with +-20% jitter) passes. Any success clears the failure. Failures not retried for
+/// `negative-backoff-max` after their backoff passed are dropped.
+class NegativeCache
+{
+public:
+    enum class Kind
+    {
+        Unreachable, // no answer, timeouts
+        Unsupported  // host answers, but not as power device
+    };
+
+public:
+    static NegativeCache& instance();
+
+    /// Marks failure of the call guarded on the current thread as @ref Kind::Unreachable. Called by transports when
+    /// the host does not answer or refuses connection, other failures are @ref Kind::Unsupported.
+    static void unreachable();
+
+    /// Returns remembered error if host/protocol failed recently
+    std::optional<std::string> find(const std::string& key, const std::string& protocol) const;
+
+    /// Returns kind of remembered failure of host/protocol
+    std::optional<Kind> failure(const std::string& key, const std::string& protocol) const;
+
+    /// Remembers failure, prolongs backoff
+    void failed(const std::string& key, const std::string& protocol, Kind kind, const std::string& error);
+
+    /// Clears failure
+    void succeeded(const std::string& key, const std::string& protocol);
+
+    /// Removes all failures of the address, returns removed entries as `key/protocol`
+    std::vector<std::string> forget(const std::string& address);
+
+    /// Removes all failures
+    void clear();
+
+    /// Runs `func` unless it failed recently, remembers its result. `force` skips remembered failure.
+    template <typename Func>
+    auto guard(const std::string& key, const std::string& protocol, bool force, Func&& func) -> decltype(func())
+    {
+        if (!force) {
+            static auto& hits   = metrics::cacheLookups("negative", true);
+            static auto& misses = metrics::cacheLookups("negative", false);
+
+            if (auto error = find(key, protocol)) {
+                hits.inc();
+                return unexpected(*error);
+            }
+            misses.inc();
+        }
+
+        // Mark of outer guard is kept, failure of inner one is seen by the outer one too
+        bool outer       = exchangeUnreachable(false);
+        auto res         = func();
+        bool unreachable = exchangeUnreachable(false);
+        exchangeUnreachable(outer || unreachable);
+
+        if (res) {
+            succeeded(key, protocol);
+        } else {
+            failed(key, protocol, unreachable ? Kind::Unreachable : Kind::Unsupported, res.error());
+        }
+        return res;
+    }
+
+private:
+    struct Entry
+    {
+        Kind                                  kind;
+        std::string                           error;
+        uint32_t                              failures = 0;
+        std::chrono::steady_clock::time_point retryAt;
+    };
+
+    NegativeCache() = default;
+
+    /// Sets unreachable mark of the current thread, returns previous one
+    static bool exchangeUnreachable(bool value);
+
+    /// Drops failures not retried for `keep` after their backoff passed, at most once per `keep`, called under the lock
+    void prune(std::chrono::steady_clock::time_point now, std::chrono::seconds keep);
+
+private:
+    mutable std::mutex                                   m_mutex;
+    std::map<std::pair<std::string, std::string>, Entry> m_cache;
+    std::chrono::steady_clock::time_point                m_pruneAt;
+};
+
+// =====================================================================================================================
+
+/// Checks if host is available (see @ref available), remembers unavailable hosts in @ref NegativeCache
+Expected<void> checkHost(const std::string& address, bool force);
+
+// =====================================================================================================================
+
+} // namespace fty::impl
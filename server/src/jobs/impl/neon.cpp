@@ -15,6 +15,11 @@
 */
 
 #include "neon.h"
+#include "capture.h"
+#include "inspect.h"
+#include "negative-cache.h"
+#include "probes.h"
+#include "trace.h"
 #include <fty/string-utils.h>
 #include <neon/ne_request.h>
 #include <neon/ne_session.h>
@@ -26,6 +31,8 @@ namespace neon {
 
 Neon::Neon(const std::string& address, uint16_t port, uint16_t timeout)
     : m_session(ne_session_create("http", address.c_str(), port), &closeSession)
+    , m_address(address)
+    , m_port(port)
 {
     ne_set_connect_timeout(m_session.get(), timeout);
     ne_set_read_timeout(m_session.get(), timeout);
@@ -36,6 +43,22 @@ Neon::~Neon()
 }
 
 fty::Expected<std::string> Neon::get(const std::string& path) const
+{
+    fty::trace::Span    span("neon-get");
+    fty::inspect::Stage stage("HTTP GET {}:{}/{}", m_address, m_port, path);
+    fty::probes::Timer  timer(fty_probe_enabled(neon_response));
+    fty_probe(neon_request, m_address.c_str(), int(m_port), path.c_str());
+
+    auto res = fty::capture::exchangeOne(
+        fty::capture::kind::Http, m_address, std::to_string(m_port) + "/" + path, [&]() {
+            return request(path);
+        });
+
+    fty_probe(neon_response, m_address.c_str(), int(m_port), path.c_str(), timer.micros(), int(bool(res)));
+    return res;
+}
+
+fty::Expected<std::string> Neon::request(const std::string& path) const
 {
     std::string rpath = "/" + path;
     std::unique_ptr<ne_request, decltype(&ne_request_destroy)> request(
@@ -47,6 +70,9 @@ fty::Expected<std::string> Neon::get(const std::string& path) const
         int stat = ne_begin_request(request.get());
         auto status = ne_get_status(request.get());
         if (stat != NE_OK) {
+            if (stat == NE_LOOKUP || stat == NE_CONNECT || stat == NE_TIMEOUT) {
+                fty::impl::NegativeCache::unreachable();
+            }
             if (!status->code) {
                 return fty::unexpected(ne_get_error(m_session.get()));
             }
@@ -40,11 +40,14 @@ public:
     fty::Expected<std::string> get(const std::string& path) const;
 
 private:
-    static void closeSession(ne_session*);
+    fty::Expected<std::string> request(const std::string& path) const;
+    static void                closeSession(ne_session*);
 
 private:
     using NeonSession = std::unique_ptr<ne_session, decltype(&closeSession)>;
     NeonSession m_session;
+    std::string m_address;
+    uint16_t    m_port;
 };
 
 // =====================================================================================================================
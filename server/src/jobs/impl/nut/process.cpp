@@ -1,6 +1,10 @@
 #include "process.h"
+#include "inspect.h"
+#include "metrics.h"
+#include "probes.h"
 #include "src/config.h"
 #include "src/jobs/impl/mibs.h"
+#include "stats.h"
 #include <filesystem>
 #include <fty/process.h>
 #include <fty_common_socket_sync_client.h>
@@ -36,6 +40,7 @@ Expected<void> Process::setupSnmp(const std::string& address, uint16_t port)
     std::string toconnect = fmt::format("{}:{}", address, port);
 
     if (auto path = findExecutable("snmp-ups")) {
+        m_driver = "snmp-ups";
         // clang-format off
         m_process = std::unique_ptr<fty::Process>(new fty::Process(*path, {
             "-s", "discover",
@@ -64,6 +69,7 @@ Expected<void> Process::setupXmlPdc(const std::string& address, uint16_t port)
     }
 
     if (auto path = findExecutable("netxml-ups")) {
+        m_driver = "netxml-ups";
         // clang-format off
         m_process = std::unique_ptr<fty::Process>(new fty::Process(*path, {
             "-s", "discover",
@@ -81,6 +87,7 @@ Expected<void> Process::setupXmlPdc(const std::string& address, uint16_t port)
 Expected<void> Process::setupPowercom(const std::string& address)
 {
     if (auto path = findExecutable("etn-nut-powerconnect")) {
+        m_driver = "etn-nut-powerconnect";
         // clang-format off
         m_process = std::unique_ptr<fty::Process>(new fty::Process(*path, {
             "-x", fmt::format("port={}", address),
@@ -95,7 +102,7 @@ Expected<void> Process::setupPowercom(const std::string& address)
 
 Expected<void> Process::init(const std::string& address, uint16_t port)
 {
-    std::string driver;
+    m_address = address;
     if (m_protocol == "nut_snmp") {
         if (auto ret = setupSnmp(address, port); !ret) {
             return unexpected(ret.error());
@@ -307,8 +314,22 @@ Expected<void> Process::setMib(const std::string& mib)
 
 Expected<std::string> Process::run() const
 {
-    if (auto pid = m_process->run()) {
-        if (auto stat = m_process->wait(); *stat == 0) {
+    if (auto pid = stats::measure(stats::Stage::DriverSpawn, [&]() { return m_process->run(); })) {
+        static auto& running = metrics::gauge("fty_discovery_drivers_running", "Running nut driver processes");
+        metrics::counter("fty_discovery_driver_spawns_total", "Started nut driver processes",
+            {{"protocol", m_protocol}}).inc();
+
+        probes::Timer timer(fty_probe_enabled(driver_exit));
+        fty_probe(driver_spawn, m_protocol.c_str(), m_address.c_str(), int(*pid));
+
+        Expected<int> stat = [&]() {
+            metrics::Track track(running);
+            inspect::Stage stage("waiting {} pid {}", m_driver, *pid);
+            return stats::measure(stats::Stage::DriverRun, [&]() { return m_process->wait(); });
+        }();
+        fty_probe(driver_exit, m_protocol.c_str(), m_address.c_str(), int(*pid), stat ? *stat : -1, timer.micros());
+
+        if (stat && *stat == 0) {
             return m_process->readAllStandardOutput();
         } else {
             std::string stdError = m_process->readAllStandardError();
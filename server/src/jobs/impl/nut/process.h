@@ -29,6 +29,8 @@ private:
 
 private:
     std::string                   m_protocol;
+    std::string                   m_address;
+    std::string                   m_driver;
     std::string                   m_root;
     std::unique_ptr<fty::Process> m_process;
 };
@@ -15,6 +15,7 @@
 */
 
 #pragma once
+#include "stats.h"
 #include <errno.h>
 #include <netdb.h>
 #include <string>
@@ -41,7 +42,8 @@ inline bool available(const std::string& address)
     hints.ai_protocol = 0;
 
     addrinfo* result;
-    if (getaddrinfo(checkAddress.c_str(), nullptr, &hints, &result) != 0) {
+    if (fty::stats::Timer timer(fty::stats::Stage::Dns); getaddrinfo(checkAddress.c_str(), nullptr, &hints, &result) != 0) {
+        timer.fail();
         return false;
     }
 
@@ -15,6 +15,12 @@
 */
 
 #include "snmp.h"
+#include "capture.h"
+#include "inspect.h"
+#include "metrics.h"
+#include "negative-cache.h"
+#include "probes.h"
+#include "stats.h"
 // Config should be firt
 #include <net-snmp/net-snmp-config.h>
 // Snmp stuff
@@ -23,6 +29,7 @@
 #include <net-snmp/snmpv3_api.h>
 // Other
 #include <fty/expected.h>
+#include <fty/string-utils.h>
 #include <fty_common_socket_sync_client.h>
 #include <fty_log.h>
 #include <fty_security_wallet.h>
@@ -77,6 +84,17 @@ static Expected<oid*> authPriv(secw::Snmpv3PrivProtocol proc)
     return unexpected("Wrong protocol");
 }
 
+/// Counts requests left without answer after all retries, marks the host unreachable for the negative cache
+static void countTimeout(int status)
+{
+    static auto& timeouts =
+        metrics::counter("fty_discovery_snmp_timeouts_total", "SNMP requests without answer after all retries");
+    if (status == STAT_TIMEOUT) {
+        timeouts.inc();
+        NegativeCache::unreachable();
+    }
+}
+
 // =====================================================================================================================
 // Session private implementation
 // =====================================================================================================================
@@ -204,6 +222,7 @@ public:
 
         netsnmp_pdu* response = nullptr;
         int          status   = snmp_sess_synch_response(m_handle, pdu, &response);
+        countTimeout(status);
         std::unique_ptr<netsnmp_pdu, std::function<void(netsnmp_pdu*)>> rptr(response, [](netsnmp_pdu* p) {
             snmp_free_pdu(p);
         });
@@ -222,6 +241,49 @@ public:
         return unexpected(snmp_api_errstring(snmp_errno));
     }
 
+    /// Reads several values with one request
+    Expected<std::vector<std::string>> read(const std::vector<std::string>& oids)
+    {
+        netsnmp_pdu* pdu = snmp_pdu_create(SNMP_MSG_GET);
+        for (const auto& stroid : oids) {
+            oid    name[MAX_OID_LEN];
+            size_t nameLen = MAX_OID_LEN;
+
+            if (!snmp_parse_oid(stroid.c_str(), name, &nameLen)) {
+                snmp_free_pdu(pdu);
+                return unexpected("Cannot parse OID '{}'", stroid);
+            }
+            snmp_add_null_var(pdu, name, nameLen);
+        }
+
+        netsnmp_pdu* response = nullptr;
+        int          status   = snmp_sess_synch_response(m_handle, pdu, &response);
+        countTimeout(status);
+        std::unique_ptr<netsnmp_pdu, std::function<void(netsnmp_pdu*)>> rptr(response, [](netsnmp_pdu* p) {
+            snmp_free_pdu(p);
+        });
+
+        if (status != STAT_SUCCESS) {
+            return unexpected(snmp_api_errstring(snmp_errno));
+        }
+        if (response->errstat != SNMP_ERR_NOERROR) {
+            return unexpected(snmp_errstring(int(response->errstat)));
+        }
+
+        std::vector<std::string> values;
+        for (auto vars = response->variables; vars; vars = vars->next_variable) {
+            if (auto val = readVal(vars)) {
+                values.push_back(*val);
+            } else {
+                return unexpected(val.error());
+            }
+        }
+        if (values.size() != oids.size()) {
+            return unexpected("Wrong number of values in response");
+        }
+        return values;
+    }
+
     Expected<void> walk(std::function<void(const std::string&)>&& func)
     {
         oid    name[MAX_OID_LEN];
@@ -241,6 +303,7 @@ public:
 
             netsnmp_pdu* response = nullptr;
             int          status   = snmp_sess_synch_response(m_handle, pdu, &response);
+            countTimeout(status);
             std::unique_ptr<netsnmp_pdu, std::function<void(netsnmp_pdu*)>> rptr(response, [](netsnmp_pdu* p) {
                 snmp_free_pdu(p);
             });
@@ -268,16 +331,29 @@ public:
     }
 
 private:
+    const std::string& address() const
+    {
+        return m_addr;
+    }
+
     Expected<std::string> readVal(const netsnmp_variable_list* lst)
     {
         switch (lst->type) {
             case ASN_BOOLEAN:
             case ASN_INTEGER:
+                if (!lst->val.integer) {
+                    break;
+                }
+                return convert<std::string>(int64_t(*lst->val.integer));
             case ASN_COUNTER:
             case ASN_GAUGE:
             case ASN_TIMETICKS:
             case ASN_UINTEGER:
-                return convert<std::string>(int64_t(lst->val.integer));
+                // Unsigned 32 bit values are kept in long by net-snmp
+                if (!lst->val.integer) {
+                    break;
+                }
+                return convert<std::string>(uint64_t(uint32_t(*lst->val.integer)));
             case ASN_BIT_STR:
             case ASN_OCTET_STR:
             case ASN_OPAQUE:
@@ -320,12 +396,57 @@ Expected<void> snmp::Session::open()
 
 Expected<std::string> snmp::Session::read(const std::string& oid) const
 {
-    return m_impl->read(oid);
+    inspect::Stage stage("SNMP GET {} from {}", oid, m_impl->address());
+    probes::Timer  timer(fty_probe_enabled(snmp_response));
+    fty_probe(snmp_request, m_impl->address().c_str(), oid.c_str(), 1);
+
+    auto res = stats::measure(stats::Stage::SnmpGet, [&]() {
+        return capture::exchangeOne(capture::kind::Snmp, m_impl->address(), oid, [&]() {
+            return m_impl->read(oid);
+        });
+    });
+
+    fty_probe(snmp_response, m_impl->address().c_str(), oid.c_str(), 1, timer.micros(), int(bool(res)));
+    return res;
+}
+
+Expected<std::vector<std::string>> snmp::Session::read(const std::vector<std::string>& oids) const
+{
+    inspect::Stage stage("SNMP GET {} from {}", implode(oids, " "), m_impl->address());
+    probes::Timer  timer(fty_probe_enabled(snmp_response));
+    fty_probe(snmp_request, m_impl->address().c_str(), oids.empty() ? "" : oids.front().c_str(), oids.size());
+
+    auto res = stats::measure(stats::Stage::SnmpGet, [&]() {
+        return capture::exchange(capture::kind::Snmp, m_impl->address(), implode(oids, " "), [&]() {
+            return m_impl->read(oids);
+        });
+    });
+
+    fty_probe(snmp_response, m_impl->address().c_str(), oids.empty() ? "" : oids.front().c_str(), oids.size(),
+        timer.micros(), int(bool(res)));
+    return res;
 }
 
 Expected<void> snmp::Session::walk(std::function<void(const std::string&)>&& func) const
 {
-    return m_impl->walk(std::move(func));
+    inspect::Stage stage("SNMP WALK {}", m_impl->address());
+
+    // Walk is recorded and replayed as the list of walked names
+    auto names = capture::exchange(capture::kind::Snmp, m_impl->address(), "walk",
+        [&]() -> Expected<std::vector<std::string>> {
+            std::vector<std::string> walked;
+            if (auto res = m_impl->walk([&](const std::string& name) { walked.push_back(name); }); !res) {
+                return unexpected(res.error());
+            }
+            return walked;
+        });
+    if (!names) {
+        return unexpected(names.error());
+    }
+    for (const auto& name : *names) {
+        func(name);
+    }
+    return {};
 }
 
 Expected<void> snmp::Session::setCommunity(const std::string& community)
@@ -19,6 +19,7 @@
 #include <fty/expected.h>
 #include <functional>
 #include <memory>
+#include <vector>
 
 namespace fty::impl {
 
@@ -52,9 +53,10 @@ namespace snmp {
         Expected<void> setCredentialId(const std::string& credId);
         Expected<void> setTimeout(uint32_t milliseconds);
 
-        Expected<void>        open();
-        Expected<std::string> read(const std::string& oid) const;
-        Expected<void>        walk(std::function<void(const std::string&)>&& func) const;
+        Expected<void>                     open();
+        Expected<std::string>              read(const std::string& oid) const;
+        Expected<std::vector<std::string>> read(const std::vector<std::string>& oids) const;
+        Expected<void>                     walk(std::function<void(const std::string&)>&& func) const;
 
     protected:
         Session(const std::string& address, uint16_t port);
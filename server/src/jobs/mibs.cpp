@@ -16,7 +16,8 @@
 
 #include "mibs.h"
 #include "impl/mibs.h"
-#include "impl/ping.h"
+#include "impl/negative-cache.h"
+#include "store.h"
 #include <fty/string-utils.h>
 #include <set>
 
@@ -25,41 +26,16 @@ namespace fty::job {
 
 // =====================================================================================================================
 
-static bool sortMibs(const std::string& l, const std::string& r)
-{
-    try {
-        // clang-format off
-        static const std::vector<std::regex> snmpMibPriority = {
-            std::regex("XUPS-MIB"),
-            std::regex("MG-SNMP-UPS-MIB"),
-            std::regex(".+")
-        };
-        // clang-format on
-
-        auto index = [&](const std::string& mib) -> size_t {
-            for (size_t i = 0; i < snmpMibPriority.size(); ++i) {
-                if (std::regex_match(mib, snmpMibPriority[i])) {
-                    return i;
-                }
-            }
-            return 999;
-        };
-
-        return index(l) < index(r);
-    } catch (...) {
-        return false;
-    }
-}
-
-// =====================================================================================================================
-
 void Mibs::run(const commands::mibs::In& in, commands::mibs::Out& out)
 {
-    if (!available(in.address)) {
-        throw Error("Host is not available: {}", in.address.value());
+    stats::Timer timer(stats::Stage::Mibs);
+
+    if (auto res = impl::checkHost(in.address, in.force); !res) {
+        throw Error(res.error());
     }
 
     impl::MibsReader reader(in.address, uint16_t(in.port.value()));
+    reader.setForce(in.force);
 
     if (in.credentialId.hasValue()) {
         if (auto res = reader.setCredentialId(in.credentialId); !res) {
@@ -77,17 +53,34 @@ void Mibs::run(const commands::mibs::In& in, commands::mibs::Out& out)
         reader.setTimeout(in.timeout);
     }
 
+    // Failures are remembered per credentials, caller can try another one
+    std::string key =
+        impl::FingerprintCache::key(in.address, uint16_t(in.port.value()), in.credentialId, in.community);
+    auto& negative = impl::NegativeCache::instance();
+
     std::string assetName;
-    if (auto name = reader.readName()) {
+    if (auto name = negative.guard(key, "snmp", in.force, [&]() { return reader.readName(); })) {
         assetName = *name;
     } else {
         throw Error("Host is not available or SNMP is not supported. SNMP error: {}", name.error());
     }
 
-    if (auto mibs = reader.read()) {
+    if (auto mibs = negative.guard(key, "snmp", in.force, [&]() { return reader.read(); })) {
         out.setValue(std::vector<std::string>(mibs->begin(), mibs->end()));
-        out.sort(sortMibs);
+        out.sort(impl::sortMibs);
         log_info("Configure: '%s' mibs: [%s]", assetName.c_str(), implode(out, ", ").c_str());
+
+        if (Store::instance().isOpen()) {
+            auto res = Store::instance().update(in.address, [&](Store::Host& host) {
+                host.mibs.setValue(out.value());
+                if (in.credentialId.hasValue()) {
+                    host.credentialId = in.credentialId.value();
+                }
+            });
+            if (!res) {
+                log_error("Cannot store mibs of %s: %s", in.address.value().c_str(), res.error().c_str());
+            }
+        }
     } else {
         throw Error("Host is not available or SNMP is not supported. SNMP error: {}", mibs.error());
     }
@@ -15,9 +15,15 @@
 */
 
 #include "protocols.h"
+#include "impl/fingerprint.h"
 #include "impl/mibs.h"
-#include "impl/ping.h"
+#include "impl/negative-cache.h"
 #include "impl/xml-pdc.h"
+#include "inspect.h"
+#include "logger.h"
+#include "src/config.h"
+#include "store.h"
+#include <cstring>
 #include <fty/string-utils.h>
 #include <netdb.h>
 #include <netinet/ip_icmp.h>
@@ -61,32 +67,77 @@ inline std::ostream& operator<<(std::ostream& ss, Type type)
 
 void Protocols::run(const commands::protocols::In& in, commands::protocols::Out& out)
 {
+    stats::Timer timer(stats::Stage::Protocols);
+
     if (in.address == "__fake__") {
         out.setValue({"nut_snmp", "nut_xml_pdc"});
         return;
     }
 
-    if (!available(in.address)) {
-        throw Error("Host is not available: {}", in.address.value());
+    if (auto res = impl::checkHost(in.address, in.force); !res) {
+        throw Error(res.error());
+    }
+
+    auto cached = in.force ? std::nullopt : impl::FingerprintCache::instance().find(in.address);
+    if (cached && !cached->protocols.empty()) {
+        if (auto res = verify(in, *cached)) {
+            log_info("Fingerprint of %s matches, skip protocols detection", in.address.value().c_str());
+            out.setValue(cached->protocols);
+        } else {
+            log_debug("Fingerprint of %s does not match: %s", in.address.value().c_str(), res.error().c_str());
+        }
+    }
+
+    if (!out.size()) {
+        detect(in, out);
     }
 
+    slog_info("Protocols: return", {{"address", in.address.value()}, {"protocols", *pack::json::serialize(out)}});
+
+    if (Store::instance().isOpen()) {
+        auto res = Store::instance().update(in.address, [&](Store::Host& host) {
+            host.protocols.setValue(out.value());
+        });
+        if (!res) {
+            log_error("Cannot store protocols of %s: %s", in.address.value().c_str(), res.error().c_str());
+        }
+    }
+}
+
+void Protocols::detect(const commands::protocols::In& in, commands::protocols::Out& out)
+{
     std::vector<Type> protocols;
+    impl::Fingerprint print;
 
-    if (auto res = tryXmlPdc(in)) {
+    // Probes which failed recently are not repeated until backoff passes
+    auto& negative = impl::NegativeCache::instance();
+
+    if (auto res = negative.guard(in.address, "nut_xml_pdc", in.force, [&]() {
+            inspect::Stage stage("probing nut_xml_pdc");
+            return stats::measure(stats::Stage::ProbeXml, [&]() { return tryXmlPdc(in); });
+        })) {
         protocols.emplace_back(Type::Xml);
+        print.product = res->name;
+        print.version = res->version;
         log_info("Found XML device");
     } else {
         log_info("Skipped xml_pdc, reason: %s", res.error().c_str());
     }
 
-    if (auto res = trySnmp(in)) {
+    if (auto res = negative.guard(in.address, "nut_snmp", in.force, [&]() {
+            inspect::Stage stage("probing nut_snmp");
+            return stats::measure(stats::Stage::ProbeSnmp, [&]() { return trySnmp(in); });
+        })) {
         protocols.emplace_back(Type::Snmp);
         log_info("Found SNMP device");
     } else {
         log_info("Skipped snmp, reason: %s", res.error().c_str());
     }
 
-    if (auto res = tryPowercom(in)) {
+    if (auto res = negative.guard(in.address, "nut_powercom", in.force, [&]() {
+            inspect::Stage stage("probing nut_powercom");
+            return stats::measure(stats::Stage::ProbePowercom, [&]() { return tryPowercom(in); });
+        })) {
         protocols.emplace_back(Type::Powercom);
         log_info("Found Powercon device");
     } else {
@@ -108,13 +159,44 @@ void Protocols::run(const commands::protocols::In& in, commands::protocols::Out&
                 break;
         }
     }
-    std::string resp = *pack::json::serialize(out);
-    log_info("Return %s", resp.c_str());
+
+    if (out.size()) {
+        impl::FingerprintCache::instance().update(in.address, [&](impl::Fingerprint& fp) {
+            fp.product   = print.product;
+            fp.version   = print.version;
+            fp.protocols = out.value();
+        });
+    }
+}
+
+Expected<void> Protocols::verify(const commands::protocols::In& in, const impl::Fingerprint& cached) const
+{
+    // One request to the most useful protocol found before is enough to check if it is the same device
+    const auto& first = cached.protocols.front();
+    if (first == "nut_xml_pdc") {
+        impl::XmlPdc xml(in.address, uint16_t(Config::instance().httpPort.value()));
+        if (auto prod = xml.get<impl::ProductInfo>("product.xml")) {
+            impl::Fingerprint current;
+            current.product = prod->name;
+            current.version = prod->version;
+            if (!cached.matchXml(current)) {
+                return unexpected("product changed to '{} {}'", current.product, current.version);
+            }
+            return {};
+        } else {
+            return unexpected(prod.error());
+        }
+    } else if (first == "nut_snmp") {
+        return trySnmp(in);
+    } else if (first == "nut_powercom") {
+        return tryPowercom(in);
+    }
+    return unexpected("unknown protocol {}", first);
 }
 
-Expected<void> Protocols::tryXmlPdc(const commands::protocols::In& in) const
+Expected<impl::ProductInfo> Protocols::tryXmlPdc(const commands::protocols::In& in) const
 {
-    impl::XmlPdc xml(in.address);
+    impl::XmlPdc xml(in.address, uint16_t(Config::instance().httpPort.value()));
     if (auto prod = xml.get<impl::ProductInfo>("product.xml")) {
         if(!(prod->name == "Network Management Card" || prod->name == "HPE UPS Network Module")) {
             return unexpected("unsupported card type");
@@ -125,7 +207,7 @@ Expected<void> Protocols::tryXmlPdc(const commands::protocols::In& in) const
         }
 
         if (auto props = xml.get<impl::Properties>(prod->summary.summary.url)) {
-            return {};
+            return *prod;
         } else {
             return unexpected(props.error());
         }
@@ -136,7 +218,7 @@ Expected<void> Protocols::tryXmlPdc(const commands::protocols::In& in) const
 
 Expected<void> Protocols::tryPowercom(const commands::protocols::In& in) const
 {
-    neon::Neon ne(in.address);
+    neon::Neon ne(in.address, uint16_t(Config::instance().httpPort.value()));
     if (auto content = ne.get("etn/v1/comm")) {
         try {
             YAML::Node yaml = YAML::Load(*content);
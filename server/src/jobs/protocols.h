@@ -16,6 +16,8 @@
 
 #pragma once
 #include "discovery-task.h"
+#include "impl/fingerprint.h"
+#include "impl/xml-pdc.h"
 
 // =====================================================================================================================
 
@@ -35,8 +37,14 @@ public:
     void run(const commands::protocols::In& in, commands::protocols::Out& out);
 
 private:
+    /// Runs full detection, probes every known protocol
+    void detect(const commands::protocols::In& in, commands::protocols::Out& out);
+
+    /// Checks if cached fingerprint still belongs to the endpoint
+    Expected<void> verify(const commands::protocols::In& in, const impl::Fingerprint& cached) const;
+
     /// Try out if endpoint support xml pdc protocol
-    Expected<void> tryXmlPdc(const commands::protocols::In& in) const;
+    Expected<impl::ProductInfo> tryXmlPdc(const commands::protocols::In& in) const;
 
     /// Try out if endpoint support xnmp protocol
     Expected<void> trySnmp(const commands::protocols::In& in) const;
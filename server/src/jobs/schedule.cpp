@@ -0,0 +1,52 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "schedule.h"
+#include "scheduler.h"
+
+namespace fty::job {
+
+// =====================================================================================================================
+
+void Schedule::run(const commands::schedule::In& in, commands::schedule::Out& out)
+{
+    if (in.request.address.hasValue()) {
+        if (auto res = Scheduler::instance().schedule(in); !res) {
+            throw Error(res.error());
+        }
+    }
+
+    for (const auto& target : Scheduler::instance().targets()) {
+        out.append(target);
+    }
+}
+
+// =====================================================================================================================
+
+void Unschedule::run(const commands::unschedule::In& in, commands::unschedule::Out& out)
+{
+    if (in.address.empty()) {
+        throw Error("Address is empty");
+    }
+
+    for (const auto& target : Scheduler::instance().unschedule(in.address, in.port, in.protocol)) {
+        out.append(target);
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::job
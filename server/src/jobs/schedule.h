@@ -0,0 +1,48 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "discovery-task.h"
+
+// =====================================================================================================================
+
+namespace fty::job {
+
+/// Registers device for periodic rediscovery
+/// Returns @ref commands::schedule::Out (all registered targets)
+class Schedule : public Task<Schedule, commands::schedule::In, commands::schedule::Out>
+{
+public:
+    using Task::Task;
+
+    /// Runs schedule job.
+    void run(const commands::schedule::In& in, commands::schedule::Out& out);
+};
+
+/// Removes device from periodic rediscovery
+/// Returns @ref commands::unschedule::Out (removed targets)
+class Unschedule : public Task<Unschedule, commands::unschedule::In, commands::unschedule::Out>
+{
+public:
+    using Task::Task;
+
+    /// Runs unschedule job.
+    void run(const commands::unschedule::In& in, commands::unschedule::Out& out);
+};
+
+} // namespace fty::job
+
+// =====================================================================================================================
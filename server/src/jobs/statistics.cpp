@@ -0,0 +1,96 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "statistics.h"
+#include "inspect.h"
+#include "memory.h"
+#include "stats.h"
+
+namespace fty::job {
+
+// =====================================================================================================================
+
+void Stats::run(const commands::stats::In& in, commands::stats::Out& out)
+{
+    auto snapshot = stats::snapshot();
+    if (in.reset) {
+        stats::reset();
+    }
+
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        const auto& hist = snapshot[i];
+        if (!hist.count) {
+            continue;
+        }
+
+        auto& stage  = out.append();
+        stage.name   = stats::name(stats::Stage(i));
+        stage.count  = hist.count;
+        stage.errors = hist.errors;
+        stage.mean   = hist.sum / hist.count;
+        stage.p50    = hist.percentile(0.5);
+        stage.p90    = hist.percentile(0.9);
+        stage.p99    = hist.percentile(0.99);
+        stage.p999   = hist.percentile(0.999);
+        stage.max    = hist.max;
+    }
+}
+
+void Memory::run(const commands::memory::In& in, commands::memory::Out& out)
+{
+    if (!memory::enabled()) {
+        throw Error("Memory accounting is disabled");
+    }
+
+    auto top = memory::top(in.top);
+    if (in.reset) {
+        memory::reset();
+    }
+
+    for (const auto& con : top) {
+        auto& item       = out.append();
+        item.subject     = con.subject;
+        item.target      = con.target;
+        item.jobs        = con.jobs;
+        item.allocated   = con.allocated;
+        item.allocations = con.allocations;
+        item.peak        = con.peak;
+        item.retained    = con.retained;
+    }
+}
+
+void Inspect::run(const commands::inspect::In& in, commands::inspect::Out& out)
+{
+    for (const auto& job : inspect::jobs()) {
+        if (!in.subject.empty() && in.subject.value() != job.subject) {
+            continue;
+        }
+
+        auto& item         = out.append();
+        item.subject       = job.subject;
+        item.target        = job.target;
+        item.correlationId = job.correlationId;
+        item.state         = job.running ? "running" : "queued";
+        item.stage         = job.stage;
+        item.age           = job.age;
+        item.busy          = job.busy;
+        item.thread        = job.thread;
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::job
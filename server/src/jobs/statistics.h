@@ -0,0 +1,59 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "discovery-task.h"
+
+// =====================================================================================================================
+
+namespace fty::job {
+
+/// Latency statistics of discovery stages since start (or last reset)
+/// Returns @ref commands::stats::Out (statistics of measured stages)
+class Stats : public Task<Stats, commands::stats::In, commands::stats::Out>
+{
+public:
+    using Task::Task;
+
+    /// Runs stats job.
+    void run(const commands::stats::In& in, commands::stats::Out& out);
+};
+
+/// Top memory consumers by subject and target since start (or last reset)
+/// Returns @ref commands::memory::Out
+class Memory : public Task<Memory, commands::memory::In, commands::memory::Out>
+{
+public:
+    using Task::Task;
+
+    /// Runs memory job.
+    void run(const commands::memory::In& in, commands::memory::Out& out);
+};
+
+/// Queued and running jobs with their current stage, served on the bus thread
+/// Returns @ref commands::inspect::Out
+class Inspect : public Task<Inspect, commands::inspect::In, commands::inspect::Out>
+{
+public:
+    using Task::Task;
+
+    /// Runs inspect job.
+    void run(const commands::inspect::In& in, commands::inspect::Out& out);
+};
+
+} // namespace fty::job
+
+// =====================================================================================================================
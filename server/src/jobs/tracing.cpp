@@ -0,0 +1,48 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "tracing.h"
+#include <unistd.h>
+
+namespace fty::job {
+
+// =====================================================================================================================
+
+void Tracing::run(const commands::trace::In& in, commands::trace::Out& out)
+{
+    if (!trace::enabled()) {
+        throw Error("Tracing is disabled");
+    }
+
+    auto events = trace::events(in.correlationId);
+    if (in.clear) {
+        trace::clear();
+    }
+
+    for (const auto& event : events) {
+        auto& item = out.traceEvents.append();
+        item.name  = event.name;
+        item.ts    = event.start;
+        item.dur   = event.duration;
+        item.pid   = uint32_t(getpid());
+        item.tid   = event.thread;
+        item.args.append("correlation_id", event.correlationId);
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::job
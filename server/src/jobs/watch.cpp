@@ -0,0 +1,47 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "watch.h"
+#include "watchers.h"
+
+namespace fty::job {
+
+// =====================================================================================================================
+
+void Watch::run(const commands::watch::In& in, commands::watch::Out& out)
+{
+    if (m_in.meta.from.empty()) {
+        throw Error("Requester is unknown");
+    }
+
+    if (in.remove) {
+        out.setValue(Watchers::instance().unwatch(m_in.meta.from, in.hosts.value()));
+        return;
+    }
+
+    if (in.hosts.empty()) {
+        throw Error("Hosts are empty");
+    }
+    if (auto res = Watchers::instance().watch(m_in.meta.from, in.hosts.value())) {
+        out.setValue(*res);
+    } else {
+        throw Error(res.error());
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::job
@@ -1,21 +1,36 @@
+#include "bench.h"
 #include "config.h"
 #include "daemon.h"
 #include "discovery.h"
 #include "jobs/impl/snmp.h"
+#include <algorithm>
+#include <cctype>
 #include <fty/command-line.h>
+#include <fty/string-utils.h>
 #include <fty_log.h>
+#include <optional>
 
 int main(int argc, char** argv)
 {
     bool        daemon = false;
     std::string config = "conf/discovery.conf";
     bool        help   = false;
+    bool        bench  = false;
+
+    fty::bench::Options opts;
+    std::string         benchDuration    = std::to_string(opts.duration);
+    std::string         benchConcurrency = std::to_string(opts.concurrency);
 
     // clang-format off
     fty::CommandLine cmd("New discovery service", {
-        {"--config", config, "Configuration file"},
-        {"--daemon", daemon, "Daemonize this application"},
-        {"--help",   help,   "Show this help"}
+        {"--config",            config,           "Configuration file"},
+        {"--daemon",            daemon,           "Daemonize this application"},
+        {"--bench",             bench,            "Run capacity benchmark against simulated devices and exit"},
+        {"--bench-data",        opts.data,        "Benchmark devices, directory with snmprec files"},
+        {"--bench-mix",         opts.mix,         "Benchmark requests with weights, as 'protocols:1,mibs:2,assets:2'"},
+        {"--bench-duration",    benchDuration,    "Benchmark duration in seconds"},
+        {"--bench-concurrency", benchConcurrency, "Benchmark parallel clients"},
+        {"--help",              help,             "Show this help"}
     });
     // clang-format on
 
@@ -31,6 +46,40 @@ int main(int argc, char** argv)
         return EXIT_SUCCESS;
     }
 
+    if (bench) {
+        // Positive whole number, anything else is refused before convert() would throw on it
+        auto positive = [](const std::string& value) -> std::optional<uint32_t> {
+            if (value.empty() || value.size() > 9 || !std::all_of(value.begin(), value.end(), [](char ch) {
+                    return std::isdigit(uint8_t(ch));
+                })) {
+                return std::nullopt;
+            }
+            if (auto num = fty::convert<uint32_t>(value); num > 0) {
+                return num;
+            }
+            return std::nullopt;
+        };
+
+        auto duration    = positive(benchDuration);
+        auto concurrency = positive(benchConcurrency);
+        if (!duration || !concurrency) {
+            std::cerr << "Wrong " << (!duration ? "--bench-duration '" + benchDuration + "'"
+                                                : "--bench-concurrency '" + benchConcurrency + "'")
+                      << ", expected number greater than 0" << std::endl;
+            std::cout << std::endl;
+            std::cout << cmd.help() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // Configuration is optional, it only tunes the agent (caches, mib database)
+        if (auto ret = pack::yaml::deserializeFile(config, fty::Config::instance()); !ret) {
+            std::cerr << "Benchmark runs with default configuration: " << ret.error() << std::endl;
+        }
+        opts.duration    = *duration;
+        opts.concurrency = *concurrency;
+        return fty::bench::run(opts);
+    }
+
     fty::Discovery dis(config);
     if (!dis.loadConfig()) {
         return EXIT_FAILURE;
@@ -0,0 +1,514 @@
+/*  =========================================================================
+    scheduler.cpp - Periodic rediscovery of registered devices
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "scheduler.h"
+#include "config.h"
+#include "inspect.h"
+#include "jobs/assets.h"
+#include "jobs/impl/delta.h"
+#include "memory.h"
+#include "message-bus.h"
+#include "stats.h"
+#include "trace.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <fty_log.h>
+#include <random>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fty {
+
+// =====================================================================================================================
+// Timer wheel
+// =====================================================================================================================
+
+TimerWheel::TimerWheel(size_t size)
+    : m_slots(size)
+{
+}
+
+void TimerWheel::add(const std::string& key, uint64_t delay)
+{
+    remove(key);
+
+    delay       = std::max<uint64_t>(delay, 1);
+    size_t slot = (m_current + delay) % m_slots.size();
+    auto   it   = m_slots[slot].insert(m_slots[slot].end(), Timer{key, (delay - 1) / m_slots.size()});
+    m_timers.emplace(key, std::make_pair(slot, it));
+}
+
+void TimerWheel::remove(const std::string& key)
+{
+    if (auto it = m_timers.find(key); it != m_timers.end()) {
+        m_slots[it->second.first].erase(it->second.second);
+        m_timers.erase(it);
+    }
+}
+
+bool TimerWheel::contains(const std::string& key) const
+{
+    return m_timers.count(key);
+}
+
+std::vector<std::string> TimerWheel::tick()
+{
+    m_current = (m_current + 1) % m_slots.size();
+
+    std::vector<std::string> fired;
+    auto&                    slot = m_slots[m_current];
+    for (auto it = slot.begin(); it != slot.end();) {
+        if (it->rounds == 0) {
+            fired.push_back(it->key);
+            m_timers.erase(it->key);
+            it = slot.erase(it);
+        } else {
+            it->rounds--;
+            ++it;
+        }
+    }
+    return fired;
+}
+
+// =====================================================================================================================
+// Scheduler helpers
+// =====================================================================================================================
+
+/// Saved scheduler state
+class State : public pack::Node
+{
+public:
+    pack::ObjectList<commands::schedule::Target> targets = FIELD("targets");
+
+public:
+    using pack::Node::Node;
+    META(State, targets);
+};
+
+static uint64_t now()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+static uint64_t random(uint64_t from, uint64_t to)
+{
+    thread_local std::mt19937_64 gen(std::random_device{}());
+    return std::uniform_int_distribution<uint64_t>(from, std::max(from, to))(gen);
+}
+
+/// Missed runs are spread over this time after start
+static constexpr uint64_t CatchUpWindow = 300;
+
+/// Changed state is saved at most once per this time
+static constexpr auto SaveDelay = std::chrono::seconds(5);
+
+/// Target as it is returned and saved, without secrets
+static commands::schedule::Target redacted(commands::schedule::Target target)
+{
+    commands::assets::redact(target.request);
+    return target;
+}
+
+/// Writes the state to temporary file readable only by the agent, synced before it replaces the state file
+static void save(const State& state)
+{
+    const std::string& path = Config::instance().scheduleState;
+
+    auto cnt = pack::json::serialize(state);
+    if (!cnt) {
+        log_error("Scheduler: %s", cnt.error().c_str());
+        return;
+    }
+
+    std::string tmp = path + ".tmp";
+    int         fd  = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        log_error("Scheduler: cannot save state to %s: %s", path.c_str(), strerror(errno));
+        return;
+    }
+
+    bool ok = fchmod(fd, S_IRUSR | S_IWUSR) == 0;
+    for (size_t done = 0; ok && done < cnt->size();) {
+        ssize_t wrote = ::write(fd, cnt->data() + done, cnt->size() - done);
+        if (wrote < 0 && errno == EINTR) {
+            continue;
+        }
+        ok = wrote > 0;
+        done += ok ? size_t(wrote) : 0;
+    }
+    ok = ok && fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        log_error("Scheduler: cannot save state to %s: %s", path.c_str(), strerror(errno));
+        std::remove(tmp.c_str());
+    }
+}
+
+// =====================================================================================================================
+// Scheduled run
+// =====================================================================================================================
+
+class Scheduler::Run : public fty::Task<Run>
+{
+public:
+    Run(Scheduler& scheduler, const std::string& key, const commands::assets::In& request, MessageBus& bus)
+        : m_scheduler(&scheduler)
+        , m_key(key)
+        , m_request(request)
+        , m_bus(&bus)
+        , m_job(commands::schedule::Subject, "schedule/" + key)
+    {
+        m_job.setTarget(request.address);
+    }
+
+    void operator()() override
+    {
+        trace::Context  context("schedule/" + m_key);
+        memory::Scope   scope;
+        stats::Scope    stages;
+        inspect::Active active(m_job);
+
+        std::string error;
+        try {
+            job::Assets           assets(Message(), *m_bus);
+            commands::assets::Out out;
+            assets.run(m_request, out);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+            log_error("Scheduled discovery of %s failed: %s", m_key.c_str(), error.c_str());
+        }
+        stats::logSlow(stages, commands::schedule::Subject, m_key, {}, job::credential(m_request), error.empty());
+        if (memory::enabled()) {
+            memory::account(commands::schedule::Subject, m_request.address, scope.finish());
+        }
+        m_scheduler->done(m_key, error);
+    }
+
+private:
+    Scheduler*           m_scheduler;
+    std::string          m_key;
+    commands::assets::In m_request;
+    MessageBus*          m_bus;
+    inspect::Job         m_job;
+};
+
+// =====================================================================================================================
+// Scheduler
+// =====================================================================================================================
+
+Scheduler& Scheduler::instance()
+{
+    static Scheduler inst;
+    return inst;
+}
+
+Scheduler::~Scheduler()
+{
+    stop();
+}
+
+std::string Scheduler::key(const Target& target)
+{
+    return target.request.address.value() + ":" + std::to_string(target.request.port.value()) + "/" +
+           target.request.protocol.value();
+}
+
+Expected<void> Scheduler::start(MessageBus& bus)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_stop) {
+        return unexpected("Scheduler is already started");
+    }
+
+    m_bus     = &bus;
+    m_stop    = false;
+    m_pool    = std::make_unique<ThreadPool>(std::max<uint32_t>(Config::instance().scheduleConcurrency, 1));
+    m_tokens  = 1;
+    m_refill  = std::chrono::steady_clock::now();
+    m_running = 0;
+
+    load();
+
+    m_thread = std::thread(&Scheduler::loop, this);
+    return {};
+}
+
+void Scheduler::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop) {
+            return;
+        }
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    m_pool->stop();
+    m_pool.reset();
+
+    flush();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dirty = false;
+    m_targets.clear();
+    m_ready.clear();
+    m_wheel = TimerWheel(3600);
+}
+
+Expected<Scheduler::Target> Scheduler::schedule(const Target& target)
+{
+    if (target.request.address.empty()) {
+        return unexpected("Address is empty");
+    }
+    if (target.request.protocol.empty()) {
+        return unexpected("Protocol is empty");
+    }
+    if (target.interval.value() == 0) {
+        return unexpected("Interval must be positive");
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stop) {
+        return unexpected("Scheduler is not started");
+    }
+
+    std::string key = Scheduler::key(target);
+    auto        it  = m_targets.find(key);
+
+    if (it == m_targets.end()) {
+        it = m_targets.emplace(key, target).first;
+        it->second.lastRun.clear();
+        it->second.lastError.clear();
+        plan(key, it->second, random(1, target.interval));
+    } else {
+        bool intervalChanged = it->second.interval.value() != target.interval.value();
+
+        it->second.request  = target.request;
+        it->second.interval = target.interval;
+        if (intervalChanged || it->second.nextRun.value() == 0) {
+            // Waiting for secrets after restart, see load()
+            it->second.lastError.clear();
+            plan(key, it->second, random(1, target.interval));
+        }
+    }
+
+    m_dirty = true;
+    return redacted(it->second);
+}
+
+Scheduler::Targets Scheduler::unschedule(const std::string& address, uint32_t port, const std::string& protocol)
+{
+    Targets removed;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_targets.begin(); it != m_targets.end();) {
+        const auto& req = it->second.request;
+        if (req.address.value() == address && (!port || req.port.value() == port) &&
+            (protocol.empty() || req.protocol.value() == protocol)) {
+            removed.push_back(redacted(it->second));
+            m_wheel.remove(it->first);
+            it = m_targets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (!removed.empty()) {
+        m_dirty = true;
+        // Next schedule of the target starts from scratch
+        impl::AssetsHistory::instance().forget(address, port, protocol);
+    }
+    return removed;
+}
+
+void Scheduler::flush()
+{
+    std::lock_guard<std::mutex> saving(m_saving);
+
+    State state;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_dirty || Config::instance().scheduleState.empty()) {
+            return;
+        }
+        for (const auto& [key, target] : m_targets) {
+            state.targets.append(redacted(target));
+        }
+        m_dirty = false;
+        m_saved = std::chrono::steady_clock::now();
+    }
+    save(state);
+}
+
+Scheduler::Targets Scheduler::targets() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Targets targets;
+    for (const auto& [key, target] : m_targets) {
+        targets.push_back(redacted(target));
+    }
+    return targets;
+}
+
+void Scheduler::plan(const std::string& key, Target& target, uint64_t delay)
+{
+    target.nextRun = now() + delay;
+    m_wheel.add(key, delay);
+}
+
+uint64_t Scheduler::jittered(uint32_t interval)
+{
+    uint64_t jitter = uint64_t(interval) * std::min<uint32_t>(Config::instance().scheduleJitter, 100) / 100;
+    return std::max<uint64_t>(1, random(interval - jitter, interval + jitter));
+}
+
+void Scheduler::loop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto next = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!m_stop) {
+        m_cv.wait_until(lock, next);
+        if (m_stop) {
+            break;
+        }
+
+        for (auto now = std::chrono::steady_clock::now(); now >= next; next += std::chrono::seconds(1)) {
+            for (auto& key : m_wheel.tick()) {
+                m_ready.push_back(key);
+            }
+        }
+
+        dispatch();
+
+        // Snapshot is taken under the lock, written without it
+        if (m_dirty && std::chrono::steady_clock::now() >= m_saved + SaveDelay) {
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+}
+
+void Scheduler::dispatch()
+{
+    auto     now         = std::chrono::steady_clock::now();
+    uint32_t concurrency = std::max<uint32_t>(Config::instance().scheduleConcurrency, 1);
+    double   rate        = Config::instance().scheduleRate / 60.;
+
+    // Token bucket, allows short burst up to concurrency
+    if (rate > 0) {
+        double elapsed = std::chrono::duration<double>(now - m_refill).count();
+        m_tokens       = std::min<double>(m_tokens + elapsed * rate, concurrency);
+    } else {
+        m_tokens = concurrency;
+    }
+    m_refill = now;
+
+    while (!m_ready.empty() && m_running < concurrency && m_tokens >= 1) {
+        std::string key = m_ready.front();
+        m_ready.pop_front();
+
+        auto it = m_targets.find(key);
+        if (it == m_targets.end() || m_wheel.contains(key)) {
+            // Removed or rescheduled meanwhile
+            continue;
+        }
+
+        m_running++;
+        m_tokens -= 1;
+        log_debug("Scheduler: run discovery of %s", key.c_str());
+        m_pool->pushWorker<Run>(*this, key, it->second.request, *m_bus);
+    }
+}
+
+void Scheduler::done(const std::string& key, const std::string& error)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running--;
+
+    if (auto it = m_targets.find(key); it != m_targets.end() && !m_wheel.contains(key)) {
+        it->second.lastRun   = now();
+        it->second.lastError = error;
+        plan(key, it->second, jittered(it->second.interval));
+        m_dirty = true;
+    }
+    m_cv.notify_all();
+}
+
+void Scheduler::load()
+{
+    const std::string& path = Config::instance().scheduleState;
+    if (path.empty()) {
+        return;
+    }
+
+    std::ifstream st(path);
+    if (!st) {
+        return;
+    }
+
+    std::stringstream ss;
+    ss << st.rdbuf();
+
+    State state;
+    if (auto res = pack::json::deserialize(ss.str(), state); !res) {
+        log_error("Scheduler: cannot load state from %s: %s", path.c_str(), res.error().c_str());
+        return;
+    }
+
+    uint64_t current = now();
+    for (const auto& target : state.targets) {
+        std::string key = Scheduler::key(target);
+        auto&       tgt = m_targets.emplace(key, target).first->second;
+
+        if (commands::assets::redacted(tgt.request)) {
+            // Secrets are not saved, target runs again when registered with them or with credential id
+            tgt.nextRun   = 0;
+            tgt.lastError = "Secrets are not saved, register the target again";
+            log_warning("Scheduler: %s waits for registration with secrets", key.c_str());
+            continue;
+        }
+
+        if (tgt.nextRun.value() > current) {
+            plan(key, tgt, std::min<uint64_t>(tgt.nextRun.value() - current, tgt.interval.value()));
+        } else {
+            // Missed while agent was stopped
+            plan(key, tgt, random(1, std::min<uint64_t>(tgt.interval.value(), CatchUpWindow)));
+        }
+    }
+    log_info("Scheduler: loaded %zu targets", m_targets.size());
+}
+
+// =====================================================================================================================
+
+} // namespace fty
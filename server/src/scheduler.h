@@ -0,0 +1,148 @@
+/*  =========================================================================
+    scheduler.h - Periodic rediscovery of registered devices
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include "commands.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fty/expected.h>
+#include <fty/thread-pool.h>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fty {
+
+class MessageBus;
+
+// =====================================================================================================================
+
+/// Hashed timer wheel. Timer lands to the slot `(current + delay) % size` and fires after `delay / size` full turns.
+/// Adding, removing and firing of the timer are O(1).
+class TimerWheel
+{
+public:
+    explicit TimerWheel(size_t size);
+
+    /// Adds (moves) timer, fires after `delay` ticks (at least one)
+    void add(const std::string& key, uint64_t delay);
+
+    /// Removes timer
+    void remove(const std::string& key);
+
+    /// Checks if timer is set
+    bool contains(const std::string& key) const;
+
+    /// Advances wheel by one tick, returns fired timers
+    std::vector<std::string> tick();
+
+private:
+    struct Timer
+    {
+        std::string key;
+        uint64_t    rounds;
+    };
+    using Slot = std::list<Timer>;
+
+    std::vector<Slot>                                        m_slots;
+    size_t                                                   m_current = 0;
+    std::map<std::string, std::pair<size_t, Slot::iterator>> m_timers;
+};
+
+// =====================================================================================================================
+
+/// Periodic rediscovery of registered devices.
+///
+/// Every target is rediscovered (@ref job::Assets) each `interval` seconds. Next run is shifted by random jitter
+/// (`schedule-jitter` percents of the interval), new targets start at random point of their interval, so targets
+/// registered at the same time do not run at the same time. Runs are limited by `schedule-concurrency` parallel runs
+/// and `schedule-rate` runs per minute, runs over the limits wait in the queue.
+///
+/// Targets are saved to `schedule-state` file at most once per a few seconds by the scheduler thread, without
+/// communities and passwords (targets registered with them wait for new registration after restart). Runs missed while
+/// agent was stopped are spread over a few minutes after start.
+class Scheduler
+{
+public:
+    using Target  = commands::schedule::Target;
+    using Targets = std::vector<Target>;
+
+public:
+    static Scheduler& instance();
+    ~Scheduler();
+
+    /// Loads saved targets and starts to run them
+    [[nodiscard]] Expected<void> start(MessageBus& bus);
+
+    /// Stops scheduler, waits for running rediscoveries
+    void stop();
+
+    /// Registers (updates) target
+    [[nodiscard]] Expected<Target> schedule(const Target& target);
+
+    /// Removes targets of address, port and protocol (empty or zero match any)
+    Targets unschedule(const std::string& address, uint32_t port, const std::string& protocol);
+
+    /// Returns all targets
+    Targets targets() const;
+
+    /// Saves changed targets now
+    void flush();
+
+private:
+    class Run;
+
+    Scheduler() = default;
+
+    void     loop();
+    void     dispatch();
+    void     done(const std::string& key, const std::string& error);
+    void     plan(const std::string& key, Target& target, uint64_t delay);
+    uint64_t jittered(uint32_t interval);
+    void     load();
+
+    static std::string key(const Target& target);
+
+private:
+    mutable std::mutex                    m_mutex;
+    std::mutex                            m_saving;
+    std::condition_variable               m_cv;
+    std::thread                           m_thread;
+    std::unique_ptr<ThreadPool>           m_pool;
+    MessageBus*                           m_bus   = nullptr;
+    bool                                  m_stop  = true;
+    TimerWheel                            m_wheel = TimerWheel(3600);
+    std::map<std::string, Target>         m_targets;
+    std::deque<std::string>               m_ready;
+    uint32_t                              m_running = 0;
+    double                                m_tokens  = 0;
+    std::chrono::steady_clock::time_point m_refill;
+    bool                                  m_dirty = false;
+    std::chrono::steady_clock::time_point m_saved;
+};
+
+// =====================================================================================================================
+
+} // namespace fty
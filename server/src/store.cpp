@@ -0,0 +1,749 @@
+/*  =========================================================================
+    store.cpp - Persistent storage of discovery results
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "store.h"
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fty_log.h>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fty {
+
+// =====================================================================================================================
+// On disk structures
+// =====================================================================================================================
+
+static constexpr const char* LogName   = "hosts.log";
+static constexpr const char* IndexName = "hosts.idx";
+static constexpr uint64_t    LogMagic  = 0x31474f4c474e4446; // FDNGLOG1
+static constexpr uint64_t    IdxMagic  = 0x31584449474e4446; // FDNGIDX1
+static constexpr uint32_t    RecMagic  = 0x52474e44;         // DNGR
+
+static constexpr uint64_t MinCapacity    = 1024;
+static constexpr uint64_t MinCompactSize = 1024 * 1024;
+static constexpr auto     CompactPeriod  = std::chrono::minutes(10);
+
+struct LogHeader
+{
+    uint64_t magic;
+    uint64_t generation;
+};
+
+struct RecordHeader
+{
+    uint32_t magic;
+    uint32_t crc;     // crc32 of flags, address and payload
+    uint32_t length;  // address + payload length
+    uint16_t flags;   // see RecordFlags
+    uint16_t addrLen; // address length
+};
+
+enum RecordFlags : uint16_t
+{
+    Removed = 1
+};
+
+struct Store::Entry
+{
+    enum Flags : uint32_t
+    {
+        Used    = 1,
+        Deleted = 2
+    };
+
+    uint64_t hash;
+    uint64_t offset;
+    uint32_t length;
+    uint32_t flags;
+};
+
+struct Store::Index
+{
+    uint64_t magic;
+    uint64_t generation;
+    uint64_t capacity;  // power of two
+    uint64_t count;     // used slots
+    uint64_t logSize;   // log size covered by index
+    uint64_t liveBytes; // size of live records in the log
+    uint64_t clean;     // index was closed properly
+
+    Entry* entries()
+    {
+        return reinterpret_cast<Entry*>(this + 1);
+    }
+
+    static size_t mapSize(uint64_t capacity)
+    {
+        return sizeof(Index) + capacity * sizeof(Entry);
+    }
+};
+
+// =====================================================================================================================
+// Helpers
+// =====================================================================================================================
+
+static uint32_t crc32(uint32_t crc, const void* data, size_t len)
+{
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> tbl;
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            tbl[i] = c;
+        }
+        return tbl;
+    }();
+
+    auto ptr = static_cast<const uint8_t*>(data);
+    crc      = ~crc;
+    for (size_t i = 0; i < len; ++i) {
+        crc = table[(crc ^ ptr[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint64_t hashOf(const std::string& address)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (char ch : address) {
+        hash ^= uint8_t(ch);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+static uint64_t now()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+static bool readAll(int fd, void* buff, size_t size, uint64_t offset)
+{
+    auto ptr = static_cast<char*>(buff);
+    while (size) {
+        ssize_t ret = pread(fd, ptr, size, off_t(offset));
+        if (ret <= 0) {
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        ptr += ret;
+        size -= size_t(ret);
+        offset += uint64_t(ret);
+    }
+    return true;
+}
+
+static bool writeAll(int fd, const void* buff, size_t size, uint64_t offset)
+{
+    auto ptr = static_cast<const char*>(buff);
+    while (size) {
+        ssize_t ret = pwrite(fd, ptr, size, off_t(offset));
+        if (ret <= 0) {
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        ptr += ret;
+        size -= size_t(ret);
+        offset += uint64_t(ret);
+    }
+    return true;
+}
+
+struct RawRecord
+{
+    RecordHeader head;
+    std::string  address;
+    std::string  payload;
+};
+
+static std::optional<RawRecord> readRaw(int fd, uint64_t offset, uint64_t logSize)
+{
+    RawRecord rec;
+    if (offset + sizeof(RecordHeader) > logSize || !readAll(fd, &rec.head, sizeof(RecordHeader), offset)) {
+        return std::nullopt;
+    }
+    if (rec.head.magic != RecMagic || rec.head.addrLen > rec.head.length ||
+        offset + sizeof(RecordHeader) + rec.head.length > logSize) {
+        return std::nullopt;
+    }
+
+    std::string data(rec.head.length, '\0');
+    if (!readAll(fd, data.data(), data.size(), offset + sizeof(RecordHeader))) {
+        return std::nullopt;
+    }
+
+    uint32_t crc = crc32(0, &rec.head.flags, sizeof(rec.head.flags));
+    crc          = crc32(crc, data.data(), data.size());
+    if (crc != rec.head.crc) {
+        return std::nullopt;
+    }
+
+    rec.address = data.substr(0, rec.head.addrLen);
+    rec.payload = data.substr(rec.head.addrLen);
+    return rec;
+}
+
+/// Walks through valid records from offset, returns end of the last valid one
+template <typename Func>
+static uint64_t scanLog(int fd, uint64_t from, uint64_t logSize, Func&& func)
+{
+    uint64_t offset = from;
+    while (auto rec = readRaw(fd, offset, logSize)) {
+        uint32_t length = uint32_t(sizeof(RecordHeader) + rec->head.length);
+        func(*rec, offset, length);
+        offset += length;
+    }
+    return offset;
+}
+
+// =====================================================================================================================
+// Store
+// =====================================================================================================================
+
+Store::~Store()
+{
+    close();
+}
+
+Store& Store::instance()
+{
+    static Store inst;
+    return inst;
+}
+
+bool Store::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index != nullptr;
+}
+
+Expected<void> Store::open(const std::string& path)
+{
+    close();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    if (ec) {
+        return unexpected("Cannot create store directory {}: {}", path, ec.message());
+    }
+
+    m_path = path;
+    if (auto res = openLog(); !res) {
+        return unexpected(res.error());
+    }
+    if (auto res = openIndex(); !res) {
+        return unexpected(res.error());
+    }
+
+    m_stop      = false;
+    m_compactor = std::thread(&Store::compactor, this);
+    return {};
+}
+
+void Store::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_compactor.joinable()) {
+        m_compactor.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_index) {
+        msync(m_index, m_mapSize, MS_SYNC);
+        m_index->clean = 1;
+        msync(m_index, sizeof(Index), MS_SYNC);
+    }
+    unmapIndex();
+    if (m_idxFd != -1) {
+        ::close(m_idxFd);
+        m_idxFd = -1;
+    }
+    if (m_logFd != -1) {
+        ::close(m_logFd);
+        m_logFd = -1;
+    }
+}
+
+Expected<void> Store::openLog()
+{
+    std::string logPath = m_path + "/" + LogName;
+
+    m_logFd = ::open(logPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0640);
+    if (m_logFd == -1) {
+        return unexpected("Cannot open {}: {}", logPath, strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(m_logFd, &st) != 0) {
+        return unexpected("Cannot stat {}: {}", logPath, strerror(errno));
+    }
+
+    LogHeader head;
+    if (uint64_t(st.st_size) < sizeof(LogHeader)) {
+        head.magic      = LogMagic;
+        head.generation = uint64_t(std::chrono::steady_clock::now().time_since_epoch().count()) ^ now();
+        if (ftruncate(m_logFd, 0) != 0 || !writeAll(m_logFd, &head, sizeof(head), 0) || fdatasync(m_logFd) != 0) {
+            return unexpected("Cannot initialize {}: {}", logPath, strerror(errno));
+        }
+        st.st_size = sizeof(head);
+    } else if (!readAll(m_logFd, &head, sizeof(head), 0) || head.magic != LogMagic) {
+        return unexpected("{} is not a discovery store", logPath);
+    }
+
+    m_generation = head.generation;
+    m_logSize    = scanLog(m_logFd, sizeof(LogHeader), uint64_t(st.st_size), [](const RawRecord&, uint64_t, uint32_t) {
+    });
+
+    if (m_logSize < uint64_t(st.st_size)) {
+        log_warning("Store: cut broken tail of %s, %lu bytes", logPath.c_str(), uint64_t(st.st_size) - m_logSize);
+        if (ftruncate(m_logFd, off_t(m_logSize)) != 0) {
+            return unexpected("Cannot truncate {}: {}", logPath, strerror(errno));
+        }
+    }
+    return {};
+}
+
+Expected<void> Store::openIndex()
+{
+    std::string idxPath = m_path + "/" + IndexName;
+
+    m_idxFd = ::open(idxPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0640);
+    if (m_idxFd == -1) {
+        return unexpected("Cannot open {}: {}", idxPath, strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(m_idxFd, &st) != 0) {
+        return unexpected("Cannot stat {}: {}", idxPath, strerror(errno));
+    }
+
+    Index head;
+    bool  valid = uint64_t(st.st_size) >= sizeof(Index) && readAll(m_idxFd, &head, sizeof(head), 0) &&
+                 head.magic == IdxMagic && head.generation == m_generation && head.clean == 1 &&
+                 head.capacity >= MinCapacity && (head.capacity & (head.capacity - 1)) == 0 &&
+                 uint64_t(st.st_size) == Index::mapSize(head.capacity) && head.logSize == m_logSize;
+
+    if (!valid) {
+        log_info("Store: rebuild index %s", idxPath.c_str());
+        return rebuildIndex(MinCapacity);
+    }
+
+    void* map = mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, m_idxFd, 0);
+    if (map == MAP_FAILED) {
+        return unexpected("Cannot map {}: {}", idxPath, strerror(errno));
+    }
+    m_index   = static_cast<Index*>(map);
+    m_mapSize = size_t(st.st_size);
+
+    // Dirty until closed, crash in between will force rebuild
+    m_index->clean = 0;
+    msync(m_index, sizeof(Index), MS_SYNC);
+    return {};
+}
+
+Expected<void> Store::rebuildIndex(uint64_t capacity)
+{
+    struct Live
+    {
+        uint64_t offset;
+        uint32_t length;
+        bool     removed;
+    };
+
+    std::map<std::string, Live> live;
+    scanLog(m_logFd, sizeof(LogHeader), m_logSize, [&](const RawRecord& rec, uint64_t offset, uint32_t length) {
+        live[rec.address] = {offset, length, (rec.head.flags & Removed) != 0};
+    });
+
+    while (capacity < live.size() * 2) {
+        capacity *= 2;
+    }
+
+    std::string idxPath = m_path + "/" + IndexName;
+    std::string tmpPath = idxPath + ".tmp";
+
+    int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd == -1) {
+        return unexpected("Cannot open {}: {}", tmpPath, strerror(errno));
+    }
+
+    size_t size = Index::mapSize(capacity);
+    if (ftruncate(fd, off_t(size)) != 0) {
+        ::close(fd);
+        return unexpected("Cannot resize {}: {}", tmpPath, strerror(errno));
+    }
+
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        ::close(fd);
+        return unexpected("Cannot map {}: {}", tmpPath, strerror(errno));
+    }
+
+    Index* index      = static_cast<Index*>(map);
+    index->magic      = IdxMagic;
+    index->generation = m_generation;
+    index->capacity   = capacity;
+    index->count      = 0;
+    index->logSize    = m_logSize;
+    index->liveBytes  = 0;
+    index->clean      = 0;
+
+    for (const auto& [address, rec] : live) {
+        uint64_t hash = hashOf(address);
+        uint64_t slot = hash & (capacity - 1);
+        while (index->entries()[slot].flags & Entry::Used) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        Entry& entry = index->entries()[slot];
+        entry.hash   = hash;
+        entry.offset = rec.offset;
+        entry.length = rec.length;
+        entry.flags  = Entry::Used | (rec.removed ? uint32_t(Entry::Deleted) : 0u);
+        index->count++;
+        if (!rec.removed) {
+            index->liveBytes += rec.length;
+        }
+    }
+
+    msync(map, size, MS_SYNC);
+    if (rename(tmpPath.c_str(), idxPath.c_str()) != 0) {
+        munmap(map, size);
+        ::close(fd);
+        return unexpected("Cannot rename {}: {}", tmpPath, strerror(errno));
+    }
+
+    unmapIndex();
+    if (m_idxFd != -1) {
+        ::close(m_idxFd);
+    }
+    m_idxFd   = fd;
+    m_index   = index;
+    m_mapSize = size;
+    return {};
+}
+
+void Store::unmapIndex()
+{
+    if (m_index) {
+        munmap(m_index, m_mapSize);
+        m_index   = nullptr;
+        m_mapSize = 0;
+    }
+}
+
+Expected<uint64_t> Store::append(const std::string& address, const std::string& payload, bool removed)
+{
+    RecordHeader head;
+    head.magic   = RecMagic;
+    head.flags   = removed ? Removed : 0;
+    head.addrLen = uint16_t(address.size());
+    head.length  = uint32_t(address.size() + payload.size());
+    head.crc     = crc32(0, &head.flags, sizeof(head.flags));
+    head.crc     = crc32(head.crc, address.data(), address.size());
+    head.crc     = crc32(head.crc, payload.data(), payload.size());
+
+    std::string buff(reinterpret_cast<const char*>(&head), sizeof(head));
+    buff += address;
+    buff += payload;
+
+    uint64_t offset = m_logSize;
+    if (!writeAll(m_logFd, buff.data(), buff.size(), offset) || fdatasync(m_logFd) != 0) {
+        // Do not leave half written record, it will hide following ones
+        if (ftruncate(m_logFd, off_t(offset)) != 0) {
+            log_error("Store: cannot truncate log: %s", strerror(errno));
+        }
+        return unexpected("Cannot write store log: {}", strerror(errno));
+    }
+    m_logSize += buff.size();
+    return offset;
+}
+
+Expected<Store::Host> Store::readRecord(uint64_t offset, uint32_t /*length*/) const
+{
+    auto rec = readRaw(m_logFd, offset, m_logSize);
+    if (!rec) {
+        return unexpected("Broken store record at {}", offset);
+    }
+
+    Host host;
+    if (auto res = pack::json::deserialize(rec->payload, host); !res) {
+        return unexpected(res.error());
+    }
+    return host;
+}
+
+Store::Entry* Store::findEntry(const std::string& address) const
+{
+    uint64_t hash = hashOf(address);
+    uint64_t mask = m_index->capacity - 1;
+
+    for (uint64_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        Entry& entry = m_index->entries()[slot];
+        if (!(entry.flags & Entry::Used)) {
+            return nullptr;
+        }
+        if (entry.hash != hash) {
+            continue;
+        }
+        if (auto rec = readRaw(m_logFd, entry.offset, m_logSize); rec && rec->address == address) {
+            return &entry;
+        }
+    }
+}
+
+Expected<void> Store::insertEntry(const std::string& address, uint64_t offset, uint32_t length, bool removed)
+{
+    if (Entry* entry = findEntry(address)) {
+        if (!(entry->flags & Entry::Deleted)) {
+            m_index->liveBytes -= entry->length;
+        }
+        entry->offset = offset;
+        entry->length = length;
+        entry->flags  = Entry::Used | (removed ? uint32_t(Entry::Deleted) : 0u);
+    } else {
+        if ((m_index->count + 1) * 10 > m_index->capacity * 7) {
+            // Record is already in the log, so rebuild will pick it up
+            return rebuildIndex(m_index->capacity * 2);
+        }
+
+        uint64_t hash = hashOf(address);
+        uint64_t mask = m_index->capacity - 1;
+        uint64_t slot = hash & mask;
+        while (m_index->entries()[slot].flags & Entry::Used) {
+            slot = (slot + 1) & mask;
+        }
+
+        Entry& newEntry = m_index->entries()[slot];
+        newEntry.hash   = hash;
+        newEntry.offset = offset;
+        newEntry.length = length;
+        newEntry.flags  = Entry::Used | (removed ? uint32_t(Entry::Deleted) : 0u);
+        m_index->count++;
+    }
+
+    if (!removed) {
+        m_index->liveBytes += length;
+    }
+    m_index->logSize = m_logSize;
+    return {};
+}
+
+Expected<void> Store::update(const std::string& address, const std::function<void(Host&)>& func)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_index) {
+        return unexpected("Store is not opened");
+    }
+
+    Host host;
+    if (Entry* entry = findEntry(address); entry && !(entry->flags & Entry::Deleted)) {
+        if (auto rec = readRecord(entry->offset, entry->length)) {
+            host = *rec;
+        }
+    }
+
+    func(host);
+
+    host.address  = address;
+    host.lastSeen = now();
+    if (!host.firstSeen.value()) {
+        host.firstSeen = host.lastSeen.value();
+    }
+
+    auto payload = pack::json::serialize(host);
+    if (!payload) {
+        return unexpected(payload.error());
+    }
+
+    if (auto offset = append(address, *payload, false)) {
+        return insertEntry(address, *offset, uint32_t(m_logSize - *offset), false);
+    } else {
+        return unexpected(offset.error());
+    }
+}
+
+Expected<void> Store::remove(const std::string& address)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_index) {
+        return unexpected("Store is not opened");
+    }
+
+    if (Entry* entry = findEntry(address); !entry || (entry->flags & Entry::Deleted)) {
+        return {};
+    }
+
+    if (auto offset = append(address, {}, true)) {
+        return insertEntry(address, *offset, uint32_t(m_logSize - *offset), true);
+    } else {
+        return unexpected(offset.error());
+    }
+}
+
+std::optional<Store::Host> Store::find(const std::string& address) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_index) {
+        return std::nullopt;
+    }
+
+    if (Entry* entry = findEntry(address); entry && !(entry->flags & Entry::Deleted)) {
+        if (auto rec = readRecord(entry->offset, entry->length)) {
+            return *rec;
+        } else {
+            log_error("Store: %s", rec.error().c_str());
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<Store::Host> Store::all() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<Host> hosts;
+    if (!m_index) {
+        return hosts;
+    }
+
+    for (uint64_t i = 0; i < m_index->capacity; ++i) {
+        const Entry& entry = m_index->entries()[i];
+        if (!(entry.flags & Entry::Used) || (entry.flags & Entry::Deleted)) {
+            continue;
+        }
+        if (auto rec = readRecord(entry.offset, entry.length)) {
+            hosts.push_back(*rec);
+        } else {
+            log_error("Store: %s", rec.error().c_str());
+        }
+    }
+    return hosts;
+}
+
+Expected<void> Store::compact()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_index) {
+        return unexpected("Store is not opened");
+    }
+
+    std::string logPath = m_path + "/" + LogName;
+    std::string tmpPath = logPath + ".tmp";
+
+    int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd == -1) {
+        return unexpected("Cannot open {}: {}", tmpPath, strerror(errno));
+    }
+
+    auto fail = [&](const std::string& what) {
+        ::close(fd);
+        std::filesystem::remove(tmpPath);
+        return unexpected("Cannot compact store, {}: {}", what, strerror(errno));
+    };
+
+    LogHeader head;
+    head.magic      = LogMagic;
+    head.generation = m_generation + 1;
+    if (!writeAll(fd, &head, sizeof(head), 0)) {
+        return fail("write header");
+    }
+
+    // Records are self contained, so live ones are copied as is
+    uint64_t size = sizeof(head);
+    for (uint64_t i = 0; i < m_index->capacity; ++i) {
+        const Entry& entry = m_index->entries()[i];
+        if (!(entry.flags & Entry::Used) || (entry.flags & Entry::Deleted)) {
+            continue;
+        }
+
+        std::string buff(entry.length, '\0');
+        if (!readAll(m_logFd, buff.data(), buff.size(), entry.offset)) {
+            return fail("read record");
+        }
+        if (!writeAll(fd, buff.data(), buff.size(), size)) {
+            return fail("write record");
+        }
+        size += buff.size();
+    }
+
+    if (fdatasync(fd) != 0) {
+        return fail("sync");
+    }
+    if (rename(tmpPath.c_str(), logPath.c_str()) != 0) {
+        return fail("rename");
+    }
+
+    if (int dir = ::open(m_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC); dir != -1) {
+        fsync(dir);
+        ::close(dir);
+    }
+
+    log_info("Store: compacted log from %lu to %lu bytes", m_logSize, size);
+
+    ::close(m_logFd);
+    m_logFd      = fd;
+    m_logSize    = size;
+    m_generation = head.generation;
+
+    return rebuildIndex(m_index->capacity);
+}
+
+void Store::compactor()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_cv.wait_for(lock, CompactPeriod, [&]() {
+        return m_stop;
+    })) {
+        if (!m_index || m_logSize < MinCompactSize || m_index->liveBytes * 2 > m_logSize) {
+            continue;
+        }
+
+        lock.unlock();
+        if (auto res = compact(); !res) {
+            log_error("Store: %s", res.error().c_str());
+        }
+        lock.lock();
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty
@@ -0,0 +1,107 @@
+/*  =========================================================================
+    store.h - Persistent storage of discovery results
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include "commands.h"
+#include <condition_variable>
+#include <fty/expected.h>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace fty {
+
+/// Persistent per host discovery results.
+///
+/// Store is a directory with two files:
+///  * `hosts.log` - append only log of host records, every record is protected by crc, so torn tail after crash is
+///                  detected and cut on open;
+///  * `hosts.idx` - memory mapped open addressing hash table `address -> record offset`. Index is rebuilt from the log
+///                  if it is missing, belongs to other log generation or is behind the log.
+///
+/// Every update appends full record, old records are dropped by compaction running in background.
+class Store
+{
+public:
+    using Host = commands::hosts::Host;
+
+public:
+    Store() = default;
+    ~Store();
+
+    /// Global agent store
+    static Store& instance();
+
+    /// Opens (creates) store in directory
+    [[nodiscard]] Expected<void> open(const std::string& path);
+
+    /// Closes store
+    void close();
+
+    /// Checks if store was opened
+    bool isOpen() const;
+
+    /// Updates host record, `func` gets current record (or empty one for the new host)
+    Expected<void> update(const std::string& address, const std::function<void(Host&)>& func);
+
+    /// Removes host record
+    Expected<void> remove(const std::string& address);
+
+    /// Finds host record
+    std::optional<Host> find(const std::string& address) const;
+
+    /// Returns all known hosts
+    std::vector<Host> all() const;
+
+    /// Rewrites log with live records only
+    Expected<void> compact();
+
+private:
+    struct Index;
+    struct Entry;
+
+    Expected<void>     openLog();
+    Expected<void>     openIndex();
+    Expected<void>     rebuildIndex(uint64_t capacity);
+    Expected<uint64_t> append(const std::string& address, const std::string& payload, bool removed);
+    Expected<Host>     readRecord(uint64_t offset, uint32_t length) const;
+    Entry*             findEntry(const std::string& address) const;
+    Expected<void>     insertEntry(const std::string& address, uint64_t offset, uint32_t length, bool removed);
+    void               unmapIndex();
+    void               compactor();
+
+private:
+    std::string             m_path;
+    int                     m_logFd      = -1;
+    int                     m_idxFd      = -1;
+    uint64_t                m_generation = 0;
+    uint64_t                m_logSize    = 0;
+    Index*                  m_index      = nullptr;
+    size_t                  m_mapSize    = 0;
+    mutable std::mutex      m_mutex;
+    std::thread             m_compactor;
+    std::condition_variable m_cv;
+    bool                    m_stop = false;
+};
+
+} // namespace fty
@@ -0,0 +1,149 @@
+/*  =========================================================================
+    warmup.cpp - Warm start of the agent caches
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "warmup.h"
+#include "config.h"
+#include "jobs/impl/fingerprint.h"
+#include "jobs/mibs.h"
+#include "jobs/protocols.h"
+#include "message-bus.h"
+#include "store.h"
+#include <algorithm>
+#include <fty_log.h>
+
+namespace fty {
+
+// =====================================================================================================================
+
+Warmup& Warmup::instance()
+{
+    static Warmup inst;
+    return inst;
+}
+
+Warmup::~Warmup()
+{
+    stop();
+}
+
+void Warmup::start(MessageBus& bus)
+{
+    if (!Store::instance().isOpen()) {
+        return;
+    }
+
+    size_t loaded = impl::FingerprintCache::instance().preload();
+    log_info("Warmup: loaded %zu fingerprints", loaded);
+
+    uint32_t count = Config::instance().warmupHosts;
+    if (!count || !loaded) {
+        return;
+    }
+
+    auto hosts = Store::instance().all();
+    std::sort(hosts.begin(), hosts.end(), [](const auto& l, const auto& r) {
+        return l.lastSeen.value() > r.lastSeen.value();
+    });
+
+    std::vector<std::string> addresses;
+    for (const auto& host : hosts) {
+        if (addresses.size() >= count) {
+            break;
+        }
+        if (!host.fingerprints.empty()) {
+            addresses.push_back(host.address);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_stop) {
+        return;
+    }
+    m_bus    = &bus;
+    m_stop   = false;
+    m_thread = std::thread(&Warmup::loop, this, std::move(addresses));
+}
+
+void Warmup::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop) {
+            return;
+        }
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void Warmup::loop(std::vector<std::string> addresses)
+{
+    uint32_t rate  = Config::instance().warmupRate;
+    auto     pause = rate ? std::chrono::milliseconds(60000 / rate) : std::chrono::milliseconds(0);
+
+    for (const auto& address : addresses) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_cv.wait_for(lock, pause, [&]() { return m_stop; })) {
+                return;
+            }
+        }
+        validate(address);
+    }
+    log_info("Warmup: %zu hosts revalidated", addresses.size());
+}
+
+void Warmup::validate(const std::string& address)
+{
+    auto host = Store::instance().find(address);
+    if (!host) {
+        return;
+    }
+
+    // Jobs check fingerprints with one request and update the caches, full detection runs only if device changed
+    try {
+        if (!host->protocols.empty()) {
+            commands::protocols::In  in;
+            commands::protocols::Out out;
+            in.address = address;
+            job::Protocols(Message(), *m_bus).run(in, out);
+        }
+
+        // Community is not saved, only devices with stored credentials can be revalidated over SNMP
+        if (host->credentialId.hasValue() && !host->mibs.empty()) {
+            commands::mibs::In  in;
+            commands::mibs::Out out;
+            in.address      = address;
+            in.credentialId = host->credentialId;
+            job::Mibs(Message(), *m_bus).run(in, out);
+        }
+        log_debug("Warmup: %s revalidated", address.c_str());
+    } catch (const std::exception& ex) {
+        log_debug("Warmup: revalidation of %s failed: %s", address.c_str(), ex.what());
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty
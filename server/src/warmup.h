@@ -0,0 +1,70 @@
+/*  =========================================================================
+    warmup.h - Warm start of the agent caches
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <condition_variable>
+#include <fty/expected.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fty {
+
+class MessageBus;
+
+// =====================================================================================================================
+
+/// Warm start of the agent.
+///
+/// On start fingerprints saved in the store are loaded to the fingerprint cache, so the first requests after restart
+/// skip full detection of known devices. Then `warmup-hosts` most recently seen hosts are revalidated in background
+/// (one identity request per host and protocol), at most `warmup-rate` hosts per minute, so the first interactive
+/// requests find the caches checked against the devices.
+class Warmup
+{
+public:
+    static Warmup& instance();
+    ~Warmup();
+
+    /// Preloads caches and starts background revalidation
+    void start(MessageBus& bus);
+
+    /// Stops background revalidation
+    void stop();
+
+private:
+    Warmup() = default;
+
+    void loop(std::vector<std::string> addresses);
+    void validate(const std::string& address);
+
+private:
+    std::mutex              m_mutex;
+    std::condition_variable m_cv;
+    std::thread             m_thread;
+    MessageBus*             m_bus  = nullptr;
+    bool                    m_stop = true;
+};
+
+// =====================================================================================================================
+
+} // namespace fty
@@ -0,0 +1,230 @@
+/*  =========================================================================
+    watchers.cpp - Subscriptions to discovered device changes
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "watchers.h"
+#include "message-bus.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstring>
+#include <fty/string-utils.h>
+#include <fty_log.h>
+
+namespace fty {
+
+// =====================================================================================================================
+
+Watchers& Watchers::instance()
+{
+    static Watchers inst;
+    return inst;
+}
+
+void Watchers::init(MessageBus& bus)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bus = &bus;
+}
+
+void Watchers::stop()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bus = nullptr;
+    m_watches.clear();
+}
+
+Expected<std::vector<std::string>> Watchers::watch(const std::string& client, const std::vector<std::string>& hosts)
+{
+    std::map<std::string, Pattern> parsed;
+    for (const auto& host : hosts) {
+        if (auto pattern = Pattern::parse(host)) {
+            parsed.emplace(host, *pattern);
+        } else {
+            return unexpected("Invalid watch pattern '{}': {}", host, pattern.error());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto& watches = m_watches[client];
+    watches.insert(parsed.begin(), parsed.end());
+
+    std::vector<std::string> out;
+    for (const auto& [text, pattern] : watches) {
+        out.push_back(text);
+    }
+    return out;
+}
+
+std::vector<std::string> Watchers::unwatch(const std::string& client, const std::vector<std::string>& hosts)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_watches.find(client);
+    if (it == m_watches.end()) {
+        return {};
+    }
+
+    if (hosts.empty()) {
+        m_watches.erase(it);
+        return {};
+    }
+
+    for (const auto& host : hosts) {
+        it->second.erase(host);
+    }
+
+    std::vector<std::string> remaining;
+    for (const auto& [text, pattern] : it->second) {
+        remaining.push_back(text);
+    }
+    if (remaining.empty()) {
+        m_watches.erase(it);
+    }
+    return remaining;
+}
+
+void Watchers::notify(
+    const std::string& address, uint32_t port, const std::string& protocol, const commands::delta::Out& delta)
+{
+    if (delta.unchanged) {
+        return;
+    }
+
+    // Bus is not used under the lock, sending must not block watch requests and other notifications
+    MessageBus*              bus = nullptr;
+    std::vector<std::string> clients;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bus = m_bus;
+        for (const auto& [client, patterns] : m_watches) {
+            bool match = std::any_of(patterns.begin(), patterns.end(), [&](const auto& it) {
+                return it.second.matches(address);
+            });
+            if (match) {
+                clients.push_back(client);
+            }
+        }
+    }
+    if (!bus || clients.empty()) {
+        return;
+    }
+
+    commands::watch::Event event;
+    event.address  = address;
+    event.port     = port;
+    event.protocol = protocol;
+    event.delta    = delta;
+
+    auto payload = pack::json::serialize(event);
+    if (!payload) {
+        log_error("Watch: %s", payload.error().c_str());
+        return;
+    }
+
+    for (const auto& client : clients) {
+        Message msg;
+        msg.meta.to      = client;
+        msg.meta.subject = commands::watch::EventSubject;
+        msg.userData.setString(*payload);
+
+        if (auto res = bus->notify(fty::Channel, msg); !res) {
+            log_error("Watch: cannot notify %s: %s", client.c_str(), res.error().c_str());
+        }
+    }
+}
+
+bool Watchers::matches(const std::string& pattern, const std::string& address)
+{
+    auto parsed = Pattern::parse(pattern);
+    return parsed && parsed->matches(address);
+}
+
+// =====================================================================================================================
+
+Expected<Watchers::Pattern> Watchers::Pattern::parse(const std::string& pattern)
+{
+    Pattern out;
+    if (pattern.empty()) {
+        return unexpected("empty");
+    }
+    if (pattern == "*") {
+        out.m_any = true;
+        return out;
+    }
+
+    auto pos = pattern.find('/');
+    if (pos == std::string::npos) {
+        out.m_address = pattern;
+        return out;
+    }
+
+    std::string net    = pattern.substr(0, pos);
+    std::string prefix = pattern.substr(pos + 1);
+    if (prefix.empty() || prefix.size() > 3 || !std::all_of(prefix.begin(), prefix.end(), ::isdigit)) {
+        return unexpected("prefix '{}' is not a number", prefix);
+    }
+
+    size_t size;
+    if (inet_pton(AF_INET, net.c_str(), out.m_net) == 1) {
+        out.m_family = AF_INET;
+        size         = 4;
+    } else if (inet_pton(AF_INET6, net.c_str(), out.m_net) == 1) {
+        out.m_family = AF_INET6;
+        size         = 16;
+    } else {
+        return unexpected("'{}' is not an IP address", net);
+    }
+
+    out.m_prefix = uint32_t(std::stoul(prefix));
+    if (out.m_prefix > size * 8) {
+        return unexpected("prefix {} is too long", out.m_prefix);
+    }
+    return out;
+}
+
+bool Watchers::Pattern::matches(const std::string& address) const
+{
+    if (m_any) {
+        return true;
+    }
+    if (!m_family) {
+        return m_address == address;
+    }
+
+    uint8_t hostAddr[16];
+    if (inet_pton(m_family, address.c_str(), hostAddr) != 1) {
+        return false;
+    }
+
+    size_t bytes = m_prefix / 8;
+    if (memcmp(m_net, hostAddr, bytes) != 0) {
+        return false;
+    }
+    if (uint32_t bits = m_prefix % 8) {
+        uint8_t mask = uint8_t(0xFF << (8 - bits));
+        return (m_net[bytes] & mask) == (hostAddr[bytes] & mask);
+    }
+    return true;
+}
+
+// =====================================================================================================================
+
+} // namespace fty
@@ -0,0 +1,92 @@
+/*  =========================================================================
+    watchers.h - Subscriptions to discovered device changes
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include "commands.h"
+#include <fty/expected.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fty {
+
+class MessageBus;
+
+// =====================================================================================================================
+
+/// Clients watching for device changes.
+/// Watch is a pattern: address, CIDR range (`10.0.0.0/24`, `fd00::/64`) or `*`. Every change detected by any
+/// rediscovery (requested or scheduled) is sent to all clients with matching pattern. Watches are not persistent,
+/// client registers them again after agent restart.
+class Watchers
+{
+public:
+    static Watchers& instance();
+
+    /// Sets bus to send events with
+    void init(MessageBus& bus);
+
+    /// Drops the bus and all watches
+    void stop();
+
+    /// Adds client watches, returns all watches of the client. Nothing is added if any pattern is invalid.
+    Expected<std::vector<std::string>> watch(const std::string& client, const std::vector<std::string>& hosts);
+
+    /// Removes client watches (all if empty), returns remaining watches of the client
+    std::vector<std::string> unwatch(const std::string& client, const std::vector<std::string>& hosts);
+
+    /// Sends change event to all clients watching the address, unchanged devices are not reported
+    void notify(const std::string& address, uint32_t port, const std::string& protocol,
+        const commands::delta::Out& delta);
+
+    /// Checks if address matches watch pattern, invalid pattern matches nothing
+    static bool matches(const std::string& pattern, const std::string& address);
+
+public:
+    /// Parsed watch pattern
+    class Pattern
+    {
+    public:
+        static Expected<Pattern> parse(const std::string& pattern);
+
+        bool matches(const std::string& address) const;
+
+    private:
+        bool        m_any    = false;
+        int         m_family = 0; // AF_INET or AF_INET6 for range, 0 for single address
+        uint8_t     m_net[16]{};
+        uint32_t    m_prefix = 0;
+        std::string m_address;
+    };
+
+private:
+    Watchers() = default;
+
+private:
+    std::mutex                                            m_mutex;
+    MessageBus*                                           m_bus = nullptr;
+    std::map<std::string, std::map<std::string, Pattern>> m_watches;
+};
+
+// =====================================================================================================================
+
+} // namespace fty
@@ -0,0 +1,225 @@
+/*  =========================================================================
+    workload.cpp - Request mix driving the agent in benchmarks
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "workload.h"
+#include "commands.h"
+#include "config.h"
+#include <fstream>
+#include <fty/string-utils.h>
+#include <random>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace fty::bench {
+
+// =====================================================================================================================
+
+Expected<std::vector<Weighted>> parseMix(const std::string& mix)
+{
+    std::vector<Weighted> out;
+    for (const auto& part : split(mix, ",")) {
+        auto        pos    = part.find(':');
+        std::string name   = trimmed(part.substr(0, pos));
+        std::string weight = pos == std::string::npos ? "" : trimmed(part.substr(pos + 1));
+
+        Weighted item;
+        if (name == commands::protocols::Subject) {
+            item.kind = Kind::Protocols;
+        } else if (name == commands::mibs::Subject) {
+            item.kind = Kind::Mibs;
+        } else if (name == commands::assets::Subject) {
+            item.kind = Kind::Assets;
+        } else {
+            return unexpected("Unknown request '{}' in mix", name);
+        }
+        item.weight = weight.empty() ? 1 : convert<uint32_t>(weight);
+        out.push_back(item);
+    }
+    if (out.empty()) {
+        return unexpected("Mix is empty");
+    }
+    return out;
+}
+
+std::string subject(Kind kind)
+{
+    switch (kind) {
+        case Kind::Protocols:
+            return commands::protocols::Subject;
+        case Kind::Mibs:
+            return commands::mibs::Subject;
+        case Kind::Assets:
+            return commands::assets::Subject;
+        case Kind::Count:
+            break;
+    }
+    return {};
+}
+
+// =====================================================================================================================
+
+MixClient::MixClient(size_t id, const std::vector<Weighted>& mix, const std::vector<std::string>& devices,
+    uint16_t port, uint32_t agents, bool force)
+    : m_id(id)
+    , m_mix(mix)
+    , m_devices(devices)
+    , m_port(port)
+    , m_agents(agents)
+    , m_force(force)
+    , m_hists(size_t(Kind::Count))
+{
+}
+
+Expected<void> MixClient::init()
+{
+    return m_bus.init(Config::instance().actorName.value() + "-client-" + std::to_string(m_id),
+        Config::instance().endpoint);
+}
+
+void MixClient::run(std::chrono::steady_clock::time_point deadline)
+{
+    std::mt19937 gen{uint32_t(m_id)};
+
+    uint32_t total = 0;
+    for (const auto& item : m_mix) {
+        total += item.weight;
+    }
+
+    std::uniform_int_distribution<uint32_t> pickKind(0, total - 1);
+    std::uniform_int_distribution<size_t>   pickDevice(0, m_devices.size() - 1);
+    std::uniform_int_distribution<uint32_t> pickAgent(0, m_agents - 1);
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        uint32_t point = pickKind(gen);
+        Kind     kind  = m_mix.back().kind;
+        for (const auto& item : m_mix) {
+            if (point < item.weight) {
+                kind = item.kind;
+                break;
+            }
+            point -= item.weight;
+        }
+
+        uint16_t    port   = uint16_t(m_port + pickAgent(gen));
+        const auto& device = m_devices[pickDevice(gen)];
+
+        auto start = std::chrono::steady_clock::now();
+        auto ret   = m_bus.send(Channel, request(kind, port, device));
+        m_hists[size_t(kind)].add(elapsed(start));
+        if (!ret) {
+            m_hists[size_t(kind)].errors++;
+        }
+    }
+}
+
+const stats::Histogram& MixClient::histogram(Kind kind) const
+{
+    return m_hists[size_t(kind)];
+}
+
+Message MixClient::request(Kind kind, uint16_t port, const std::string& community) const
+{
+    Message msg;
+    msg.meta.to = Config::instance().actorName;
+
+    // Simulated agent serves all devices on every endpoint, community selects the device
+    if (kind == Kind::Protocols) {
+        commands::protocols::In in;
+        in.address       = "127.0.0.1";
+        in.force         = m_force;
+        msg.meta.subject = commands::protocols::Subject;
+        msg.userData.setString(*pack::json::serialize(in));
+    } else if (kind == Kind::Mibs) {
+        commands::mibs::In in;
+        in.address       = "127.0.0.1";
+        in.port          = port;
+        in.community     = community;
+        in.timeout       = 10000;
+        in.force         = m_force;
+        msg.meta.subject = commands::mibs::Subject;
+        msg.userData.setString(*pack::json::serialize(in));
+    } else {
+        commands::assets::In in;
+        in.address            = "127.0.0.1";
+        in.port               = port;
+        in.protocol           = "nut_snmp";
+        in.settings.community = community;
+        in.settings.timeout   = 10000;
+        in.force              = m_force;
+        msg.meta.subject      = commands::assets::Subject;
+        msg.userData.setString(*pack::json::serialize(in));
+    }
+    return msg;
+}
+
+// =====================================================================================================================
+
+Resources Resources::now()
+{
+    auto seconds = [](const timeval& tv) {
+        return double(tv.tv_sec) + double(tv.tv_usec) / 1e6;
+    };
+
+    rusage self, children;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+
+    Resources usage;
+    usage.cpuUser   = seconds(self.ru_utime) + seconds(children.ru_utime);
+    usage.cpuSystem = seconds(self.ru_stime) + seconds(children.ru_stime);
+    usage.maxRss    = uint64_t(self.ru_maxrss);
+
+    std::ifstream statm("/proc/self/statm");
+    uint64_t      size = 0, resident = 0;
+    if (statm >> size >> resident) {
+        usage.rss = resident * uint64_t(sysconf(_SC_PAGESIZE)) / 1024;
+    }
+    return usage;
+}
+
+Resources Resources::since(const Resources& start) const
+{
+    Resources diff = *this;
+    diff.cpuUser   = cpuUser - start.cpuUser;
+    diff.cpuSystem = cpuSystem - start.cpuSystem;
+    return diff;
+}
+
+void merge(stats::Histogram& to, const stats::Histogram& from)
+{
+    for (size_t i = 0; i < from.buckets.size(); ++i) {
+        to.buckets[i] += from.buckets[i];
+    }
+    to.count += from.count;
+    to.errors += from.errors;
+    to.sum += from.sum;
+    to.max = std::max(to.max, from.max);
+}
+
+uint64_t elapsed(std::chrono::steady_clock::time_point start)
+{
+    return uint64_t(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+// =====================================================================================================================
+
+} // namespace fty::bench
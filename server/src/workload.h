@@ -0,0 +1,110 @@
+/*  =========================================================================
+    workload.h - Request mix driving the agent in benchmarks
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include "message-bus.h"
+#include "message.h"
+#include "stats.h"
+#include <chrono>
+#include <fty/expected.h>
+#include <string>
+#include <vector>
+
+namespace fty::bench {
+
+// =====================================================================================================================
+
+/// Request of the mix
+enum class Kind
+{
+    Protocols,
+    Mibs,
+    Assets,
+    Count
+};
+
+struct Weighted
+{
+    Kind     kind;
+    uint32_t weight;
+};
+
+/// Parses mix as 'protocols:1,mibs:2,assets:1', weight is 1 if not set
+Expected<std::vector<Weighted>> parseMix(const std::string& mix);
+
+/// Subject of the request
+std::string subject(Kind kind);
+
+// =====================================================================================================================
+
+/// Client sending requests of the mix to the agent until deadline, simulated devices are selected by community
+class MixClient
+{
+public:
+    MixClient(size_t id, const std::vector<Weighted>& mix, const std::vector<std::string>& devices, uint16_t port,
+        uint32_t agents, bool force);
+
+    Expected<void> init();
+    void           run(std::chrono::steady_clock::time_point deadline);
+
+    /// Client side latencies of the request
+    const stats::Histogram& histogram(Kind kind) const;
+
+private:
+    Message request(Kind kind, uint16_t port, const std::string& community) const;
+
+private:
+    size_t                        m_id;
+    std::vector<Weighted>         m_mix;
+    std::vector<std::string>      m_devices;
+    uint16_t                      m_port;
+    uint32_t                      m_agents;
+    bool                          m_force;
+    MessageBus                    m_bus;
+    std::vector<stats::Histogram> m_hists;
+};
+
+// =====================================================================================================================
+
+/// Resources used by the process and its children (nut drivers)
+struct Resources
+{
+    double   cpuUser   = 0; // seconds
+    double   cpuSystem = 0; // seconds
+    uint64_t rss       = 0; // current resident set, kB
+    uint64_t maxRss    = 0; // peak resident set, kB
+
+    /// Current usage
+    static Resources now();
+
+    /// Usage since `start`, memory is the current one
+    Resources since(const Resources& start) const;
+};
+
+/// Adds counts of `from` histogram
+void merge(stats::Histogram& to, const stats::Histogram& from);
+
+/// Microseconds since `start`
+uint64_t elapsed(std::chrono::steady_clock::time_point start);
+
+// =====================================================================================================================
+
+} // namespace fty::bench
@@ -0,0 +1,281 @@
+/*  =========================================================================
+    ber.cpp - Minimal BER codec of SNMP messages
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "ber.h"
+#include <charconv>
+
+namespace fty::sim::ber {
+
+// =====================================================================================================================
+
+void append(std::string& out, uint8_t tag, std::string_view content)
+{
+    out += char(tag);
+
+    size_t len = content.size();
+    if (len < 0x80) {
+        out += char(len);
+    } else {
+        char   bytes[sizeof(size_t)];
+        size_t count = 0;
+        for (; len; len >>= 8) {
+            bytes[count++] = char(len & 0xff);
+        }
+        out += char(0x80 | count);
+        while (count) {
+            out += bytes[--count];
+        }
+    }
+    out.append(content.data(), content.size());
+}
+
+std::string integer(int64_t value)
+{
+    // Two's complement, minimal count of bytes
+    std::string out;
+    for (int shift = 56; shift > 0; shift -= 8) {
+        int64_t top  = value >> shift;
+        auto    next = uint8_t((value >> (shift - 8)) & 0xff);
+        if (out.empty() && ((top == 0 && !(next & 0x80)) || (top == -1 && (next & 0x80)))) {
+            continue;
+        }
+        out += char((value >> shift) & 0xff);
+    }
+    out += char(value & 0xff);
+    return out;
+}
+
+std::string unsignedInteger(uint64_t value)
+{
+    std::string out;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        auto byte = uint8_t((value >> shift) & 0xff);
+        if (out.empty() && !byte && shift) {
+            continue;
+        }
+        if (out.empty() && (byte & 0x80)) {
+            out += '\0';
+        }
+        out += char(byte);
+    }
+    return out;
+}
+
+static void base128(std::string& out, uint64_t value)
+{
+    char   bytes[10];
+    size_t count = 0;
+    do {
+        bytes[count++] = char(value & 0x7f);
+        value >>= 7;
+    } while (value);
+    while (count > 1) {
+        out += char(bytes[--count] | 0x80);
+    }
+    out += bytes[0];
+}
+
+std::string objectId(const Oid& oid)
+{
+    std::string out;
+    if (oid.size() < 2) {
+        base128(out, oid.empty() ? 0 : uint64_t(oid[0]) * 40);
+        return out;
+    }
+    base128(out, uint64_t(oid[0]) * 40 + oid[1]);
+    for (size_t i = 2; i < oid.size(); ++i) {
+        base128(out, oid[i]);
+    }
+    return out;
+}
+
+static std::string unhex(std::string_view str)
+{
+    auto digit = [](char ch) -> int {
+        if (ch >= '0' && ch <= '9') {
+            return ch - '0';
+        }
+        if (ch >= 'a' && ch <= 'f') {
+            return ch - 'a' + 10;
+        }
+        if (ch >= 'A' && ch <= 'F') {
+            return ch - 'A' + 10;
+        }
+        return 0;
+    };
+
+    std::string out;
+    out.reserve(str.size() / 2);
+    for (size_t i = 0; i + 1 < str.size(); i += 2) {
+        out += char(digit(str[i]) << 4 | digit(str[i + 1]));
+    }
+    return out;
+}
+
+template <typename T>
+static T number(std::string_view str)
+{
+    T value = 0;
+    std::from_chars(str.data(), str.data() + str.size(), value);
+    return value;
+}
+
+std::string value(const Snmprec::Entry& entry)
+{
+    std::string out;
+    switch (entry.tag) {
+        case Integer:
+            append(out, Integer, integer(number<int64_t>(entry.value)));
+            break;
+        case Null:
+            append(out, Null, {});
+            break;
+        case ObjectId:
+            if (auto oid = parseOid(entry.value)) {
+                append(out, ObjectId, objectId(*oid));
+            } else {
+                append(out, ObjectId, objectId({0, 0}));
+            }
+            break;
+        case IpAddress:
+            if (entry.hex) {
+                append(out, IpAddress, unhex(entry.value));
+            } else {
+                std::string      addr;
+                std::string_view str = entry.value;
+                while (!str.empty()) {
+                    size_t dot = str.find('.');
+                    addr += char(number<uint32_t>(str.substr(0, dot)));
+                    str.remove_prefix(dot == std::string_view::npos ? str.size() : dot + 1);
+                }
+                append(out, IpAddress, addr);
+            }
+            break;
+        case Counter32:
+        case Gauge32:
+        case TimeTicks:
+        case Counter64:
+            append(out, entry.tag, unsignedInteger(number<uint64_t>(entry.value)));
+            break;
+        case OctetString:
+        case Opaque:
+        default:
+            append(out, entry.tag == Opaque ? Opaque : OctetString, entry.hex ? unhex(entry.value) : entry.value);
+            break;
+    }
+    return out;
+}
+
+// =====================================================================================================================
+
+Reader::Reader(std::string_view data)
+    : m_data(data)
+{
+}
+
+bool Reader::atEnd() const
+{
+    return m_data.empty();
+}
+
+Expected<Reader::Tlv> Reader::next()
+{
+    if (m_data.size() < 2) {
+        return unexpected("Truncated message");
+    }
+
+    Tlv tlv;
+    tlv.tag = uint8_t(m_data[0]);
+
+    size_t len   = uint8_t(m_data[1]);
+    size_t start = 2;
+    if (len & 0x80) {
+        size_t count = len & 0x7f;
+        if (count == 0 || count > sizeof(size_t) || m_data.size() < 2 + count) {
+            return unexpected("Wrong length");
+        }
+        len = 0;
+        for (size_t i = 0; i < count; ++i) {
+            len = len << 8 | uint8_t(m_data[2 + i]);
+        }
+        start += count;
+    }
+    if (m_data.size() - start < len) {
+        return unexpected("Truncated message");
+    }
+
+    tlv.content = m_data.substr(start, len);
+    m_data.remove_prefix(start + len);
+    return tlv;
+}
+
+Expected<std::string_view> Reader::expect(uint8_t tag)
+{
+    auto tlv = next();
+    if (!tlv) {
+        return unexpected(tlv.error());
+    }
+    if (tlv->tag != tag) {
+        return unexpected("Unexpected tag {}", int(tlv->tag));
+    }
+    return tlv->content;
+}
+
+Expected<int64_t> toInteger(std::string_view content)
+{
+    if (content.empty() || content.size() > 8) {
+        return unexpected("Wrong integer");
+    }
+    // Sign extension from the first byte
+    int64_t value = int8_t(content[0]);
+    for (size_t i = 1; i < content.size(); ++i) {
+        value = int64_t(uint64_t(value) << 8 | uint8_t(content[i]));
+    }
+    return value;
+}
+
+Expected<Oid> toObjectId(std::string_view content)
+{
+    Oid      oid;
+    uint64_t value = 0;
+    for (char ch : content) {
+        value = value << 7 | (uint8_t(ch) & 0x7f);
+        if (uint8_t(ch) & 0x80) {
+            continue;
+        }
+        if (oid.empty()) {
+            uint32_t first = value < 40 ? 0 : (value < 80 ? 1 : 2);
+            oid.push_back(first);
+            oid.push_back(uint32_t(value - first * 40));
+        } else {
+            oid.push_back(uint32_t(value));
+        }
+        value = 0;
+    }
+    if (oid.empty()) {
+        return unexpected("Wrong OID");
+    }
+    return oid;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::sim::ber
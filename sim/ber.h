@@ -0,0 +1,95 @@
+/*  =========================================================================
+    ber.h - Minimal BER codec of SNMP messages
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include "snmprec.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace fty::sim::ber {
+
+// =====================================================================================================================
+
+enum Tag : uint8_t
+{
+    Integer        = 0x02,
+    OctetString    = 0x04,
+    Null           = 0x05,
+    ObjectId       = 0x06,
+    Sequence       = 0x30,
+    IpAddress      = 0x40,
+    Counter32      = 0x41,
+    Gauge32        = 0x42,
+    TimeTicks      = 0x43,
+    Opaque         = 0x44,
+    Counter64      = 0x46,
+    NoSuchObject   = 0x80,
+    NoSuchInstance = 0x81,
+    EndOfMibView   = 0x82,
+    GetRequest     = 0xa0,
+    GetNextRequest = 0xa1,
+    Response       = 0xa2,
+    GetBulkRequest = 0xa5,
+};
+
+// =====================================================================================================================
+
+/// Appends tag, length and content
+void append(std::string& out, uint8_t tag, std::string_view content);
+
+std::string integer(int64_t value);
+std::string unsignedInteger(uint64_t value);
+std::string objectId(const Oid& oid);
+
+/// Encodes recorded value as TLV of its type
+std::string value(const Snmprec::Entry& entry);
+
+// =====================================================================================================================
+
+/// Sequential reader of TLVs
+class Reader
+{
+public:
+    struct Tlv
+    {
+        uint8_t          tag = 0;
+        std::string_view content;
+    };
+
+    explicit Reader(std::string_view data);
+
+    bool          atEnd() const;
+    Expected<Tlv> next();
+
+    /// Next TLV which must have the tag
+    Expected<std::string_view> expect(uint8_t tag);
+
+private:
+    std::string_view m_data;
+};
+
+Expected<int64_t> toInteger(std::string_view content);
+Expected<Oid>     toObjectId(std::string_view content);
+
+// =====================================================================================================================
+
+} // namespace fty::sim::ber
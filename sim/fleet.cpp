@@ -0,0 +1,374 @@
+/*  =========================================================================
+    fleet.cpp - Synthetic fleet of devices generated from recordings
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "fleet.h"
+#include "snmp-agent.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <fty/string-utils.h>
+#include <random>
+#include <set>
+
+namespace fty::sim::fleet {
+
+// =====================================================================================================================
+
+static Oid join(const Oid& base, std::initializer_list<uint32_t> tail)
+{
+    Oid oid = base;
+    oid.insert(oid.end(), tail);
+    return oid;
+}
+
+static bool startsWith(const Oid& oid, const Oid& prefix)
+{
+    return oid.size() >= prefix.size() && std::equal(prefix.begin(), prefix.end(), oid.begin());
+}
+
+/// SNMP engine id, last bytes are usually MAC address of the card
+static const Oid EngineId = {1, 3, 6, 1, 6, 3, 10, 2, 1, 1, 0};
+
+/// EATON-EPDU-MIB, tables are indexed by daisy chain unit first, outlet tables by unit and outlet
+static const Oid Epdu = {1, 3, 6, 1, 4, 1, 534, 6, 6, 7};
+
+/// Comma separated indexes of daisy chained units
+static const Oid UnitsPresent = join(Epdu, {1, 1, 0});
+
+/// Outlet count column of unit table
+static const Oid OutletCount = join(Epdu, {1, 2, 1, 22});
+
+/// Positions in OIDs of ePDU tables: `<Epdu>.<group>.<table>.1.<column>.<unit>[.<outlet>]`
+static constexpr size_t   GroupAt     = 10;
+static constexpr size_t   RowAt       = 12;
+static constexpr size_t   UnitAt      = 14;
+static constexpr size_t   OutletAt    = 15;
+static constexpr uint32_t OutletGroup = 6;
+
+// =====================================================================================================================
+
+static std::string fromHex(std::string_view hex)
+{
+    std::string out;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        out += char(std::stoi(std::string(hex.substr(i, 2)), nullptr, 16));
+    }
+    return out;
+}
+
+static std::string toHex(const std::string& data)
+{
+    static constexpr char Digits[] = "0123456789abcdef";
+
+    std::string out;
+    for (unsigned char ch : data) {
+        out += Digits[ch >> 4];
+        out += Digits[ch & 0xf];
+    }
+    return out;
+}
+
+static Oid toOid(const std::string& data)
+{
+    Oid oid;
+    for (unsigned char ch : data) {
+        oid.push_back(ch);
+    }
+    return oid;
+}
+
+/// Serial numbers of Eaton, MGE and HP cards look like `G112F25024`: upper case letters and digits, starting with a
+/// letter and ending with a digit
+static bool isSerial(const std::string& value)
+{
+    if (value.size() < 8 || value.size() > 16 || !std::isupper(uint8_t(value.front())) ||
+        !std::isdigit(uint8_t(value.back()))) {
+        return false;
+    }
+
+    size_t digits = 0;
+    for (char ch : value) {
+        if (std::isdigit(uint8_t(ch))) {
+            digits++;
+        } else if (!std::isupper(uint8_t(ch))) {
+            return false;
+        }
+    }
+    return digits >= 4;
+}
+
+/// Replaces tail of the serial number by unique id in base 36, so the serial keeps its length and vendor prefix
+static std::string varySerial(const std::string& serial, uint64_t id)
+{
+    static constexpr char Digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+    std::string out  = serial;
+    size_t      tail = std::min<size_t>(6, out.size() - 2);
+    for (size_t i = 0; i < tail; ++i) {
+        out[out.size() - 1 - i] = Digits[id % 36];
+        id /= 36;
+    }
+    return out;
+}
+
+/// Puts MAC address into engine id, as EUI-64 if the id ends with IPv6 link local address
+static std::string varyEngineId(const std::string& id, const std::array<uint8_t, 6>& mac)
+{
+    std::string out  = id;
+    size_t      size = out.size();
+    if (size >= 13 && uint8_t(out[size - 5]) == 0xff && uint8_t(out[size - 4]) == 0xfe) {
+        out[size - 8] = char(mac[0] ^ 0x02);
+        out[size - 7] = char(mac[1]);
+        out[size - 6] = char(mac[2]);
+        out[size - 3] = char(mac[3]);
+        out[size - 2] = char(mac[4]);
+        out[size - 1] = char(mac[5]);
+    } else if (size >= 11) {
+        // Bytes after enterprise and format prefix
+        std::copy(mac.begin(), mac.end(), out.end() - 6);
+    }
+    return out;
+}
+
+// =====================================================================================================================
+
+/// Daisy chained unit of generated ePDU
+struct Unit
+{
+    uint32_t source  = 0; // unit of the template
+    uint32_t outlets = 0;
+};
+
+static std::string render(const Snmprec& rec, uint32_t index, std::mt19937_64& gen, const Options& options)
+{
+    // Locally administered MAC unique in the fleet
+    std::array<uint8_t, 6> mac = {
+        0x02, 0x00, uint8_t(index >> 24), uint8_t(index >> 16), uint8_t(index >> 8), uint8_t(index)};
+
+    std::string oldEngine, newEngine;
+    if (const auto* entry = rec.get(EngineId)) {
+        oldEngine = entry->hex ? fromHex(entry->value) : std::string(entry->value);
+        newEngine = varyEngineId(oldEngine, mac);
+    }
+    Oid oldEngineOid = toOid(oldEngine);
+    Oid newEngineOid = toOid(newEngine);
+
+    // Daisy chain of the template with outlet count of each unit
+    std::set<uint32_t>           sourceUnits;
+    std::map<uint32_t, uint32_t> sourceOutlets;
+    for (const auto& entry : rec.entries()) {
+        if (startsWith(entry.oid, Epdu) && entry.oid.size() > UnitAt && entry.oid[RowAt] == 1) {
+            sourceUnits.insert(entry.oid[UnitAt]);
+            if (entry.oid[GroupAt] == OutletGroup && entry.oid.size() > OutletAt) {
+                auto& count = sourceOutlets[entry.oid[UnitAt]];
+                count       = std::max(count, entry.oid[OutletAt]);
+            }
+        }
+    }
+
+    std::vector<Unit> units;
+    if (!sourceUnits.empty()) {
+        std::vector<uint32_t> sources(sourceUnits.begin(), sourceUnits.end());
+
+        auto chain = std::uniform_int_distribution<uint32_t>(options.minChain, options.maxChain)(gen);
+        for (uint32_t i = 0; i < chain; ++i) {
+            Unit unit;
+            unit.source = sources[i % sources.size()];
+            if (sourceOutlets[unit.source]) {
+                unit.outlets = std::uniform_int_distribution<uint32_t>(options.minOutlets, options.maxOutlets)(gen);
+            }
+            units.push_back(unit);
+        }
+    }
+    uint32_t firstUnit = sourceUnits.empty() ? 0 : *sourceUnits.begin();
+
+    std::string out;
+    auto emit = [&](Oid oid, const Snmprec::Entry& entry, uint32_t unit) {
+        std::string value = entry.hex ? fromHex(entry.value) : std::string(entry.value);
+
+        if (oid == UnitsPresent) {
+            std::vector<std::string> present;
+            for (uint32_t i = 0; i < units.size(); ++i) {
+                present.push_back(std::to_string(firstUnit + i));
+            }
+            value = implode(present, ",");
+        } else if (startsWith(oid, OutletCount) && oid.size() == OutletCount.size() + 1 && unit < units.size()) {
+            value = std::to_string(units[unit].outlets);
+        } else if (!oldEngine.empty() && value == oldEngine) {
+            value = newEngine;
+        } else if (isSerial(value)) {
+            value = varySerial(value, uint64_t(index) * 256 + unit);
+        }
+
+        // Engine id is part of USM and VACM table indexes
+        if (oldEngineOid.size() > 4) {
+            auto it = std::search(oid.begin(), oid.end(), oldEngineOid.begin(), oldEngineOid.end());
+            if (it != oid.end()) {
+                std::copy(newEngineOid.begin(), newEngineOid.end(), it);
+            }
+        }
+
+        out += toString(oid) + "|" + std::to_string(entry.tag) + (entry.hex ? "x|" + toHex(value) : "|" + value);
+        out += "\n";
+    };
+
+    for (const auto& entry : rec.entries()) {
+        bool unitRow = !units.empty() && startsWith(entry.oid, Epdu) && entry.oid.size() > UnitAt &&
+                       entry.oid[RowAt] == 1;
+        if (!unitRow) {
+            emit(entry.oid, entry, 0);
+            continue;
+        }
+
+        // Rows of template units are repeated for every generated unit made of them, outlets likewise
+        bool outletRow = entry.oid[GroupAt] == OutletGroup && entry.oid.size() > OutletAt;
+        for (uint32_t i = 0; i < units.size(); ++i) {
+            if (units[i].source != entry.oid[UnitAt]) {
+                continue;
+            }
+
+            Oid oid     = entry.oid;
+            oid[UnitAt] = firstUnit + i;
+            if (!outletRow) {
+                emit(oid, entry, i);
+                continue;
+            }
+
+            uint32_t count = sourceOutlets[units[i].source];
+            for (uint32_t outlet = 1; outlet <= units[i].outlets; ++outlet) {
+                if ((outlet - 1) % count + 1 == entry.oid[OutletAt]) {
+                    oid[OutletAt] = outlet;
+                    emit(oid, entry, i);
+                }
+            }
+        }
+    }
+    return out;
+}
+
+// =====================================================================================================================
+
+Expected<Templates> templates(const std::string& dir)
+{
+    Templates       list;
+    std::error_code ec;
+    for (const auto& it : std::filesystem::directory_iterator(dir, ec)) {
+        if (it.path().extension() != ".snmprec") {
+            continue;
+        }
+        if (auto rec = Snmprec::open(it.path().string())) {
+            list.emplace(it.path().stem().string(), *rec);
+        } else {
+            return unexpected(rec.error());
+        }
+    }
+    if (ec) {
+        return unexpected("Cannot read {}: {}", dir, ec.message());
+    }
+    return list;
+}
+
+Expected<std::vector<Device>> generate(const Templates& templates, const Options& options)
+{
+    if (templates.empty()) {
+        return unexpected("No templates");
+    }
+    if (options.minChain < 1 || options.minChain > options.maxChain) {
+        return unexpected("Wrong daisy chain range {}-{}", options.minChain, options.maxChain);
+    }
+    if (options.minOutlets < 1 || options.minOutlets > options.maxOutlets) {
+        return unexpected("Wrong outlets range {}-{}", options.minOutlets, options.maxOutlets);
+    }
+    if (options.minDelay > options.maxDelay) {
+        return unexpected("Wrong delay range {}-{}", options.minDelay.count(), options.maxDelay.count());
+    }
+
+    std::vector<std::pair<std::string, Snmprec::Ptr>> sources(templates.begin(), templates.end());
+
+    std::vector<Device> devices;
+    devices.reserve(options.count);
+    for (uint32_t i = 0; i < options.count; ++i) {
+        const auto& [name, rec] = sources[i % sources.size()];
+
+        // Every device has own generator, so the device does not depend on the fleet size
+        std::mt19937_64 gen(options.seed * 0x9e3779b97f4a7c15ull + i);
+
+        auto parsed = Snmprec::parse(render(*rec, i, gen, options));
+        if (!parsed) {
+            return unexpected("{}: {}", name, parsed.error());
+        }
+
+        Device dev;
+        dev.name      = name + "-" + std::to_string(i);
+        dev.origin    = name;
+        dev.recording = *parsed;
+        if (options.maxDelay.count() > 0) {
+            dev.impairment.latency = Impairment::Duration(std::uniform_int_distribution<int64_t>(
+                options.minDelay.count(), options.maxDelay.count())(gen));
+        }
+        devices.push_back(std::move(dev));
+    }
+    return devices;
+}
+
+Expected<void> save(const std::string& dir, const std::vector<Device>& devices)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        return unexpected("Cannot create {}: {}", dir, ec.message());
+    }
+
+    std::ofstream impairments(std::filesystem::path(dir) / "impairments", std::ios::trunc);
+    for (const auto& dev : devices) {
+        // Sorted, as snmpsim expects
+        std::ofstream st(std::filesystem::path(dir) / (dev.name + ".snmprec"), std::ios::trunc);
+        for (const auto& entry : dev.recording->entries()) {
+            st << toString(entry.oid) << "|" << int(entry.tag) << (entry.hex ? "x|" : "|") << entry.value << "\n";
+        }
+        if (!st) {
+            return unexpected("Cannot write {}/{}.snmprec", dir, dev.name);
+        }
+        if (!dev.impairment.empty()) {
+            impairments << dev.name << " " << dev.impairment.spec() << "\n";
+        }
+    }
+    if (!impairments) {
+        return unexpected("Cannot write {}/impairments", dir);
+    }
+    return {};
+}
+
+void add(SnmpAgent& agent, const std::vector<Device>& devices)
+{
+    for (const auto& dev : devices) {
+        agent.add(dev.name, dev.recording);
+        if (!dev.impairment.empty()) {
+            agent.impair(dev.name, dev.impairment);
+        }
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::sim::fleet
@@ -0,0 +1,74 @@
+/*  =========================================================================
+    fleet.h - Synthetic fleet of devices generated from recordings
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include "impairment.h"
+#include "snmprec.h"
+#include <map>
+
+namespace fty::sim {
+class SnmpAgent;
+}
+
+namespace fty::sim::fleet {
+
+// =====================================================================================================================
+
+/// Generation settings, ranges are inclusive
+struct Options
+{
+    uint32_t             count      = 1000;
+    uint64_t             seed       = 1;  // same seed generates the same fleet
+    uint32_t             minChain   = 1;  // daisy chained units of ePDU templates
+    uint32_t             maxChain   = 4;
+    uint32_t             minOutlets = 8;  // outlets of each ePDU unit
+    uint32_t             maxOutlets = 24;
+    Impairment::Duration minDelay   = Impairment::Duration(0); // response delay of the device
+    Impairment::Duration maxDelay   = Impairment::Duration(0);
+};
+
+/// Generated device
+struct Device
+{
+    std::string  name;   // `<template>-<index>`, used as community
+    std::string  origin; // template name
+    Snmprec::Ptr recording;
+    Impairment   impairment;
+};
+
+using Templates = std::map<std::string, Snmprec::Ptr>;
+
+/// Opens all `.snmprec` files of the directory, file name without extension is the template name
+Expected<Templates> templates(const std::string& dir);
+
+/// Generates devices from templates used round robin. Every device gets its own serial numbers and MAC address (as
+/// part of SNMP engine id), ePDU templates are resized to a random daisy chain of units with random outlet counts.
+Expected<std::vector<Device>> generate(const Templates& templates, const Options& options);
+
+/// Writes recordings as `<name>.snmprec` and delays to `impairments` file, as read by @ref SnmpAgent::load
+Expected<void> save(const std::string& dir, const std::vector<Device>& devices);
+
+/// Adds devices and their delays to the agent
+void add(SnmpAgent& agent, const std::vector<Device>& devices);
+
+// =====================================================================================================================
+
+} // namespace fty::sim::fleet
@@ -0,0 +1,254 @@
+/*  =========================================================================
+    http-server.cpp - Local HTTP stand-in of XML-PDC and Powercom devices
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "http-server.h"
+#include <arpa/inet.h>
+#include <fstream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace fty::sim {
+
+// =====================================================================================================================
+
+/// Requests with longer head are refused
+static constexpr size_t MaxHead = 16384;
+
+// =====================================================================================================================
+
+HttpServer::HttpServer() = default;
+
+HttpServer::~HttpServer()
+{
+    stop();
+}
+
+void HttpServer::add(const std::string& path, const std::string& body, const std::string& contentType, Duration latency)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pages[path] = Page{body, contentType, latency};
+}
+
+Expected<void> HttpServer::addFile(
+    const std::string& path, const std::string& file, const std::string& contentType, Duration latency)
+{
+    std::ifstream st(file);
+    if (!st) {
+        return unexpected("Cannot open {}", file);
+    }
+    std::stringstream ss;
+    ss << st.rdbuf();
+    add(path, ss.str(), contentType, latency);
+    return {};
+}
+
+void HttpServer::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pages.clear();
+}
+
+void HttpServer::setLatency(Duration latency)
+{
+    m_latency = latency.count();
+}
+
+void HttpServer::impair(const Impairment& impairment)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_impairment = impairment;
+}
+
+Expected<uint16_t> HttpServer::listen(uint16_t port)
+{
+    if (m_fd >= 0) {
+        return unexpected("Server is already listening");
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return unexpected("Cannot create socket");
+    }
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 128) != 0) {
+        ::close(fd);
+        return unexpected("Cannot listen on 127.0.0.1:{}", port);
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+
+    m_fd = fd;
+    return ntohs(addr.sin_port);
+}
+
+Expected<void> HttpServer::start(uint32_t threads)
+{
+    if (m_fd < 0) {
+        return unexpected("Server is not listening");
+    }
+    if (!m_stop) {
+        return unexpected("Server is already started");
+    }
+
+    m_stop = false;
+    for (uint32_t i = 0; i < std::max(threads, 1u); ++i) {
+        m_threads.emplace_back(&HttpServer::serve, this);
+    }
+    return {};
+}
+
+void HttpServer::stop()
+{
+    m_stop = true;
+    for (auto& th : m_threads) {
+        th.join();
+    }
+    m_threads.clear();
+
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+uint64_t HttpServer::requests() const
+{
+    return m_requests;
+}
+
+void HttpServer::serve()
+{
+    while (!m_stop) {
+        pollfd pfd{m_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+
+        // Other thread can take the connection first
+        int fd = accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        timeval timeout{5, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        handle(fd);
+        ::close(fd);
+    }
+}
+
+void HttpServer::handle(int fd)
+{
+    std::string head;
+    char        buffer[4096];
+    while (head.find("\r\n\r\n") == std::string::npos) {
+        ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+        if (got <= 0 || head.size() > MaxHead) {
+            return;
+        }
+        head.append(buffer, size_t(got));
+    }
+
+    // Request line: `GET /path HTTP/1.1`
+    std::istringstream line(head.substr(0, head.find("\r\n")));
+    std::string        method, target;
+    line >> method >> target;
+
+    target = target.substr(0, target.find('?'));
+    if (!target.empty() && target.front() == '/') {
+        target.erase(0, 1);
+    }
+
+    int         status = 200;
+    std::string reason = "OK";
+    Page        page;
+    if (method != "GET") {
+        status = 405;
+        reason = "Method Not Allowed";
+    } else {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto it = m_pages.find(target); it != m_pages.end()) {
+            page = it->second;
+        } else {
+            status = 404;
+            reason = "Not Found";
+        }
+    }
+
+    std::optional<Duration> impaired;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        impaired = m_impairment.stream();
+    }
+    if (!impaired) {
+        hold(fd);
+        return;
+    }
+
+    auto delay = Duration(m_latency.load()) + page.latency + *impaired;
+    if (delay.count() > 0) {
+        std::this_thread::sleep_for(delay);
+    }
+
+    std::string answer = "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\n";
+    if (!page.contentType.empty()) {
+        answer += "Content-Type: " + page.contentType + "\r\n";
+    }
+    answer += "Content-Length: " + std::to_string(page.body.size()) + "\r\n";
+    answer += "Connection: close\r\n\r\n";
+    answer += page.body;
+
+    for (size_t sent = 0; sent < answer.size();) {
+        ssize_t res = send(fd, answer.data() + sent, answer.size() - sent, MSG_NOSIGNAL);
+        if (res <= 0) {
+            return;
+        }
+        sent += size_t(res);
+    }
+    m_requests++;
+}
+
+void HttpServer::hold(int fd)
+{
+    // Waits until the client closes the connection
+    char buffer[256];
+    while (!m_stop) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) > 0 && recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT) <= 0) {
+            return;
+        }
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::sim
@@ -0,0 +1,103 @@
+/*  =========================================================================
+    http-server.h - Local HTTP stand-in of XML-PDC and Powercom devices
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include "impairment.h"
+#include <atomic>
+#include <chrono>
+#include <fty/expected.h>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fty::sim {
+
+// =====================================================================================================================
+
+/// Minimal HTTP/1.1 server answering GET requests with recorded pages (XML-PDC `product.xml` and summary pages,
+/// Powercom `etn/v1/comm`) on localhost. Every connection is closed after the answer.
+class HttpServer
+{
+public:
+    using Duration = std::chrono::milliseconds;
+
+    HttpServer();
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    /// Serves `body` on `path` (without leading slash, as device paths are requested), answer is delayed by `latency`
+    void add(const std::string& path, const std::string& body, const std::string& contentType = "text/xml",
+        Duration latency = Duration(0));
+
+    /// Serves content of the file on `path`
+    Expected<void> addFile(const std::string& path, const std::string& file,
+        const std::string& contentType = "text/xml", Duration latency = Duration(0));
+
+    /// Removes all pages
+    void clear();
+
+    /// Delay of every answer, added to the page latency
+    void setLatency(Duration latency);
+
+    /// Impairs all connections, blackholed connections are held unanswered until the client gives up
+    void impair(const Impairment& impairment);
+
+    /// Listens on `127.0.0.1:port` (any free port if 0), returns the port
+    Expected<uint16_t> listen(uint16_t port = 0);
+
+    /// Starts threads, each serves one connection at a time
+    Expected<void> start(uint32_t threads = 4);
+
+    /// Stops threads and closes the port
+    void stop();
+
+    /// Count of answered requests
+    uint64_t requests() const;
+
+private:
+    struct Page
+    {
+        std::string body;
+        std::string contentType;
+        Duration    latency;
+    };
+
+    void serve();
+    void handle(int fd);
+    void hold(int fd);
+
+private:
+    mutable std::mutex          m_mutex;
+    std::map<std::string, Page> m_pages;
+    Impairment                  m_impairment;
+    std::atomic<int64_t>        m_latency  = 0;
+    int                         m_fd       = -1;
+    std::vector<std::thread>    m_threads;
+    std::atomic<bool>           m_stop     = true;
+    std::atomic<uint64_t>       m_requests = 0;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::sim
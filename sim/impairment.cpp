@@ -0,0 +1,140 @@
+/*  =========================================================================
+    impairment.cpp - Simulated network impairment of devices
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "impairment.h"
+#include <fty/string-utils.h>
+#include <random>
+#include <sstream>
+
+namespace fty::sim {
+
+// =====================================================================================================================
+
+/// Initial TCP retransmission timeout (RFC 6298), doubled on every following loss
+static constexpr Impairment::Duration InitialRto = Impairment::Duration(1000);
+
+/// Connection is given up after so many retransmissions of one segment
+static constexpr int MaxRetransmits = 5;
+
+static double random()
+{
+    thread_local std::mt19937_64 gen(std::random_device{}());
+    return std::uniform_real_distribution<double>(0, 1)(gen);
+}
+
+// =====================================================================================================================
+
+Expected<Impairment> Impairment::parse(const std::string& spec)
+{
+    Impairment imp;
+    for (const auto& item : split(spec, ",")) {
+        if (trimmed(item).empty()) {
+            continue;
+        }
+
+        auto        pos   = item.find('=');
+        std::string key   = trimmed(item.substr(0, pos));
+        std::string value = pos == std::string::npos ? std::string{} : trimmed(item.substr(pos + 1));
+
+        try {
+            if (key == "latency") {
+                imp.latency = Duration(std::stoul(value));
+            } else if (key == "jitter") {
+                imp.jitter = Duration(std::stoul(value));
+            } else if (key == "loss") {
+                imp.loss = std::stod(value);
+                if (imp.loss < 0 || imp.loss > 1) {
+                    return unexpected("Loss must be in 0..1, got {}", value);
+                }
+            } else if (key == "blackhole") {
+                imp.blackhole = value.empty() || value == "true" || value == "1";
+            } else {
+                return unexpected("Unknown impairment '{}'", key);
+            }
+        } catch (const std::exception&) {
+            return unexpected("Wrong value of impairment '{}': '{}'", key, value);
+        }
+    }
+    return imp;
+}
+
+std::string Impairment::spec() const
+{
+    if (blackhole) {
+        return "blackhole";
+    }
+
+    std::vector<std::string> items;
+    if (latency.count()) {
+        items.push_back("latency=" + std::to_string(latency.count()));
+    }
+    if (jitter.count()) {
+        items.push_back("jitter=" + std::to_string(jitter.count()));
+    }
+    if (loss > 0) {
+        std::ostringstream ss;
+        ss << "loss=" << loss;
+        items.push_back(ss.str());
+    }
+    return implode(items, ",");
+}
+
+bool Impairment::empty() const
+{
+    return latency.count() == 0 && jitter.count() == 0 && loss <= 0 && !blackhole;
+}
+
+std::optional<Impairment::Duration> Impairment::datagram() const
+{
+    if (blackhole || (loss > 0 && random() < loss)) {
+        return std::nullopt;
+    }
+
+    auto delay = latency;
+    if (jitter.count() > 0) {
+        delay += Duration(int64_t((random() * 2 - 1) * double(jitter.count())));
+    }
+    return std::max(delay, Duration(0));
+}
+
+std::optional<Impairment::Duration> Impairment::stream() const
+{
+    if (blackhole) {
+        return std::nullopt;
+    }
+
+    Duration rto   = InitialRto;
+    Duration delay = Duration(0);
+    for (int i = 0;; ++i) {
+        if (auto sent = datagram()) {
+            return delay + *sent;
+        }
+        if (i == MaxRetransmits) {
+            return std::nullopt;
+        }
+        delay += rto;
+        rto *= 2;
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::sim
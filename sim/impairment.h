@@ -0,0 +1,63 @@
+/*  =========================================================================
+    impairment.h - Simulated network impairment of devices
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <chrono>
+#include <fty/expected.h>
+#include <optional>
+#include <string>
+
+namespace fty::sim {
+
+// =====================================================================================================================
+
+/// Network impairment of simulated device: what a lossy or slow link does to its traffic.
+///
+/// Datagrams (SNMP) are delayed or dropped one by one. Streams (HTTP) are delayed, loss of a segment is seen by the
+/// client as TCP retransmission after RTO. Blackhole device never answers.
+struct Impairment
+{
+    using Duration = std::chrono::milliseconds;
+
+    Duration latency   = Duration(0); // one way delay of the answer
+    Duration jitter    = Duration(0); // latency varies uniformly in +-jitter
+    double   loss      = 0;           // probability of lost datagram or segment, 0..1
+    bool     blackhole = false;       // nothing is answered
+
+    /// Parses spec as `latency=50,jitter=10,loss=0.05` or `blackhole`, durations are in milliseconds
+    static Expected<Impairment> parse(const std::string& spec);
+
+    /// Spec as accepted by @ref parse, empty if not impaired
+    std::string spec() const;
+
+    /// True if traffic is not impaired at all
+    bool empty() const;
+
+    /// Delay of one answer datagram, nullopt if it is lost
+    std::optional<Duration> datagram() const;
+
+    /// Delay of one answer over TCP including retransmissions, nullopt if it is never answered
+    std::optional<Duration> stream() const;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::sim
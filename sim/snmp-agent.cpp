@@ -0,0 +1,455 @@
+/*  =========================================================================
+    snmp-agent.cpp - In-process simulated SNMP agent
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "snmp-agent.h"
+#include "ber.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <netinet/in.h>
+#include <sstream>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace fty::sim {
+
+// =====================================================================================================================
+
+/// Bulk answers stop growing at this size to fit into one datagram
+static constexpr size_t MaxAnswer = 60000;
+
+/// Snmp v1 error status
+static constexpr int NoSuchName = 2;
+
+// =====================================================================================================================
+
+SnmpAgent::SnmpAgent()
+    : m_epoll(epoll_create1(EPOLL_CLOEXEC))
+{
+}
+
+SnmpAgent::~SnmpAgent()
+{
+    stop();
+    if (m_epoll >= 0) {
+        ::close(m_epoll);
+    }
+}
+
+void SnmpAgent::add(const std::string& name, Snmprec::Ptr device)
+{
+    std::unique_lock<std::shared_mutex> lock(m_devicesMutex);
+    m_devices[name] = std::move(device);
+}
+
+Expected<void> SnmpAgent::load(const std::string& dir)
+{
+    std::error_code ec;
+    for (const auto& it : std::filesystem::directory_iterator(dir, ec)) {
+        if (it.path().extension() != ".snmprec") {
+            continue;
+        }
+        if (auto rec = Snmprec::open(it.path().string())) {
+            add(it.path().stem().string(), *rec);
+        } else {
+            return unexpected(rec.error());
+        }
+    }
+    if (ec) {
+        return unexpected("Cannot read {}: {}", dir, ec.message());
+    }
+
+    std::ifstream st(std::filesystem::path(dir) / "impairments");
+    std::string   line;
+    for (size_t num = 1; std::getline(st, line); ++num) {
+        std::istringstream ss(line);
+        std::string        name, spec;
+        if (!(ss >> name) || name.front() == '#') {
+            continue;
+        }
+        std::getline(ss, spec);
+        if (auto imp = Impairment::parse(spec)) {
+            impair(name, *imp);
+        } else {
+            return unexpected("{}/impairments, line {}: {}", dir, num, imp.error());
+        }
+    }
+    return {};
+}
+
+Snmprec::Ptr SnmpAgent::device(const std::string& name) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_devicesMutex);
+    if (auto it = m_devices.find(name); it != m_devices.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+std::vector<std::string> SnmpAgent::names() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_devicesMutex);
+
+    std::vector<std::string> names;
+    for (const auto& [name, device] : m_devices) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+void SnmpAgent::impair(const std::string& device, const Impairment& impairment)
+{
+    std::unique_lock<std::shared_mutex> lock(m_devicesMutex);
+    if (impairment.empty()) {
+        m_impairments.erase(device);
+    } else {
+        m_impairments[device] = impairment;
+    }
+}
+
+Expected<uint16_t> SnmpAgent::listen(uint16_t port, const std::string& device)
+{
+    if (m_epoll < 0) {
+        return unexpected("Cannot create epoll");
+    }
+    if (!device.empty() && !this->device(device)) {
+        return unexpected("Unknown device {}", device);
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return unexpected("Cannot create socket");
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return unexpected("Cannot bind 127.0.0.1:{}", port);
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto&                       ep = m_endpoints.emplace_back();
+    ep.fd                          = fd;
+    ep.port                        = ntohs(addr.sin_port);
+    ep.device                      = device;
+
+    epoll_event event{};
+    event.events   = EPOLLIN;
+    event.data.ptr = &ep;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+        ::close(fd);
+        m_endpoints.pop_back();
+        return unexpected("Cannot watch 127.0.0.1:{}", port);
+    }
+    return ep.port;
+}
+
+Expected<void> SnmpAgent::start(uint32_t threads)
+{
+    if (!m_stop) {
+        return unexpected("Agent is already started");
+    }
+
+    m_stop = false;
+    for (uint32_t i = 0; i < std::max(threads, 1u); ++i) {
+        m_threads.emplace_back(&SnmpAgent::serve, this);
+    }
+    m_sender = std::thread(&SnmpAgent::send, this);
+    return {};
+}
+
+void SnmpAgent::stop()
+{
+    m_stop = true;
+    for (auto& th : m_threads) {
+        th.join();
+    }
+    m_threads.clear();
+
+    // Answers still on the way are lost
+    {
+        std::lock_guard<std::mutex> lock(m_delayedMutex);
+        m_delayedCv.notify_all();
+    }
+    if (m_sender.joinable()) {
+        m_sender.join();
+    }
+    m_delayed = {};
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& ep : m_endpoints) {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, ep.fd, nullptr);
+        ::close(ep.fd);
+    }
+    m_endpoints.clear();
+}
+
+uint64_t SnmpAgent::requests() const
+{
+    return m_requests;
+}
+
+uint64_t SnmpAgent::dropped() const
+{
+    return m_dropped;
+}
+
+void SnmpAgent::serve()
+{
+    std::array<epoll_event, 64> events;
+    std::vector<char>           buffer(65536);
+
+    while (!m_stop) {
+        int count = epoll_wait(m_epoll, events.data(), int(events.size()), 100);
+        for (int i = 0; i < count; ++i) {
+            auto* ep = static_cast<Endpoint*>(events[size_t(i)].data.ptr);
+            for (;;) {
+                sockaddr_in from{};
+                socklen_t   len = sizeof(from);
+
+                ssize_t got =
+                    recvfrom(ep->fd, buffer.data(), buffer.size(), 0, reinterpret_cast<sockaddr*>(&from), &len);
+                if (got <= 0) {
+                    break;
+                }
+
+                Impairment  impairment;
+                std::string resp = answer(std::string_view(buffer.data(), size_t(got)), ep->device, impairment);
+                if (resp.empty()) {
+                    continue;
+                }
+
+                auto delay = impairment.datagram();
+                if (!delay) {
+                    m_dropped++;
+                } else if (delay->count() == 0) {
+                    sendto(ep->fd, resp.data(), resp.size(), 0, reinterpret_cast<sockaddr*>(&from), len);
+                } else {
+                    std::lock_guard<std::mutex> lock(m_delayedMutex);
+                    m_delayed.push({std::chrono::steady_clock::now() + *delay, ep->fd, from, std::move(resp)});
+                    m_delayedCv.notify_one();
+                }
+            }
+        }
+    }
+}
+
+void SnmpAgent::send()
+{
+    std::unique_lock<std::mutex> lock(m_delayedMutex);
+    while (!m_stop) {
+        if (m_delayed.empty()) {
+            m_delayedCv.wait_for(lock, std::chrono::milliseconds(100));
+            continue;
+        }
+
+        auto at = m_delayed.top().at;
+        if (std::chrono::steady_clock::now() < at) {
+            m_delayedCv.wait_until(lock, at);
+            continue;
+        }
+
+        Delayed item = m_delayed.top();
+        m_delayed.pop();
+        lock.unlock();
+        sendto(item.fd, item.data.data(), item.data.size(), 0, reinterpret_cast<const sockaddr*>(&item.to),
+            sizeof(item.to));
+        lock.lock();
+    }
+}
+
+// =====================================================================================================================
+
+std::string SnmpAgent::answer(std::string_view request, const std::string& device) const
+{
+    Impairment impairment;
+    return answer(request, device, impairment);
+}
+
+std::string SnmpAgent::answer(std::string_view request, const std::string& device, Impairment& impairment) const
+{
+    // Malformed requests, unsupported versions and unknown communities are dropped as a real agent does
+    ber::Reader message(request);
+    auto        seq = message.expect(ber::Sequence);
+    if (!seq) {
+        return {};
+    }
+
+    ber::Reader fields(*seq);
+    auto        version   = fields.expect(ber::Integer);
+    auto        community = fields.expect(ber::OctetString);
+    auto        pdu       = fields.next();
+    if (!version || !community || !pdu) {
+        return {};
+    }
+
+    auto ver = ber::toInteger(*version);
+    if (!ver || (*ver != 0 && *ver != 1)) {
+        return {};
+    }
+    bool v1 = *ver == 0;
+    if (pdu->tag != ber::GetRequest && pdu->tag != ber::GetNextRequest && (pdu->tag != ber::GetBulkRequest || v1)) {
+        return {};
+    }
+
+    ber::Reader pduFields(pdu->content);
+    auto        requestId = pduFields.expect(ber::Integer);
+    auto        first     = pduFields.expect(ber::Integer);
+    auto        second    = pduFields.expect(ber::Integer);
+    auto        bindList  = pduFields.expect(ber::Sequence);
+    if (!requestId || !first || !second || !bindList) {
+        return {};
+    }
+
+    std::vector<Oid> oids;
+    for (ber::Reader binds(*bindList); !binds.atEnd();) {
+        auto bind = binds.expect(ber::Sequence);
+        if (!bind) {
+            return {};
+        }
+        auto oid = ber::Reader(*bind).expect(ber::ObjectId);
+        if (!oid) {
+            return {};
+        }
+        if (auto parsed = ber::toObjectId(*oid)) {
+            oids.push_back(std::move(*parsed));
+        } else {
+            return {};
+        }
+    }
+
+    Snmprec::Ptr rec;
+    {
+        std::string name = device.empty() ? std::string(*community) : device;
+
+        std::shared_lock<std::shared_mutex> lock(m_devicesMutex);
+        auto it = m_devices.find(name);
+        if (it == m_devices.end()) {
+            return {};
+        }
+        rec = it->second;
+
+        if (auto imp = m_impairments.find(name); imp != m_impairments.end()) {
+            impairment = imp->second;
+        } else if (imp = m_impairments.find({}); imp != m_impairments.end()) {
+            impairment = imp->second;
+        }
+    }
+
+    std::string binds;
+    int64_t     errorStatus = 0;
+    int64_t     errorIndex  = 0;
+
+    auto add = [&](const Oid& oid, const std::string& value) {
+        std::string bind;
+        ber::append(bind, ber::ObjectId, ber::objectId(oid));
+        bind += value;
+        ber::append(binds, ber::Sequence, bind);
+    };
+    auto exception = [](uint8_t tag) {
+        std::string out;
+        ber::append(out, tag, {});
+        return out;
+    };
+
+    if (pdu->tag == ber::GetRequest || pdu->tag == ber::GetNextRequest) {
+        for (size_t i = 0; i < oids.size(); ++i) {
+            const auto* entry = pdu->tag == ber::GetRequest ? rec->get(oids[i]) : rec->next(oids[i]);
+            if (entry) {
+                add(entry->oid, ber::value(*entry));
+            } else if (v1) {
+                errorStatus = NoSuchName;
+                errorIndex  = int64_t(i + 1);
+                break;
+            } else {
+                add(oids[i], exception(pdu->tag == ber::GetRequest ? ber::NoSuchObject : ber::EndOfMibView));
+            }
+        }
+    } else {
+        auto nonRep = ber::toInteger(*first);
+        auto maxRep = ber::toInteger(*second);
+        if (!nonRep || !maxRep) {
+            return {};
+        }
+        auto nonRepeaters   = size_t(std::clamp<int64_t>(*nonRep, 0, int64_t(oids.size())));
+        auto maxRepetitions = std::max<int64_t>(*maxRep, 0);
+
+        for (size_t i = 0; i < nonRepeaters; ++i) {
+            if (const auto* entry = rec->next(oids[i])) {
+                add(entry->oid, ber::value(*entry));
+            } else {
+                add(oids[i], exception(ber::EndOfMibView));
+            }
+        }
+
+        std::vector<Oid> current(oids.begin() + long(nonRepeaters), oids.end());
+        for (int64_t rep = 0; rep < maxRepetitions && !current.empty() && binds.size() < MaxAnswer; ++rep) {
+            bool any = false;
+            for (auto& oid : current) {
+                if (const auto* entry = rec->next(oid)) {
+                    add(entry->oid, ber::value(*entry));
+                    oid = entry->oid;
+                    any = true;
+                } else {
+                    add(oid, exception(ber::EndOfMibView));
+                }
+            }
+            if (!any) {
+                break;
+            }
+        }
+    }
+
+    if (errorStatus) {
+        // Snmp v1 error returns request variables
+        binds.assign(bindList->data(), bindList->size());
+    }
+
+    std::string body;
+    ber::append(body, ber::Integer, *requestId);
+    ber::append(body, ber::Integer, ber::integer(errorStatus));
+    ber::append(body, ber::Integer, ber::integer(errorIndex));
+    ber::append(body, ber::Sequence, binds);
+
+    std::string content;
+    ber::append(content, ber::Integer, *version);
+    ber::append(content, ber::OctetString, *community);
+    ber::append(content, ber::Response, body);
+
+    std::string out;
+    ber::append(out, ber::Sequence, content);
+
+    m_requests++;
+    return out;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::sim
@@ -0,0 +1,135 @@
+/*  =========================================================================
+    snmp-agent.h - In-process simulated SNMP agent
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include "impairment.h"
+#include "snmprec.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <netinet/in.h>
+#include <queue>
+#include <shared_mutex>
+#include <thread>
+
+namespace fty::sim {
+
+// =====================================================================================================================
+
+/// Simulated SNMP v1/v2c agent serving recorded devices on localhost UDP ports.
+///
+/// As in snmpsim, the community selects the device on ports listening for all devices. A port can also be bound to
+/// one device, so thousands of virtual agents are served by a few threads from one epoll set. Recordings are shared
+/// read only. Answers of impaired devices are delayed or dropped, delayed answers are sent by one more thread.
+class SnmpAgent
+{
+public:
+    SnmpAgent();
+    ~SnmpAgent();
+
+    SnmpAgent(const SnmpAgent&) = delete;
+    SnmpAgent& operator=(const SnmpAgent&) = delete;
+
+    /// Adds device recording
+    void add(const std::string& name, Snmprec::Ptr device);
+
+    /// Adds all `.snmprec` files of the directory, file name without extension is the device name (community).
+    /// Optional `impairments` file of the directory has `<device> <impairment spec>` lines.
+    Expected<void> load(const std::string& dir);
+
+    /// Device by name, nullptr if not found
+    Snmprec::Ptr device(const std::string& name) const;
+
+    /// Names of all devices
+    std::vector<std::string> names() const;
+
+    /// Impairs traffic of the device, empty name impairs all devices without own impairment. Empty impairment
+    /// removes the one set before.
+    void impair(const std::string& device, const Impairment& impairment);
+
+    /// Listens on `127.0.0.1:port` (any free port if 0), returns the port. With `device` set the port serves only
+    /// this device whatever the community is.
+    Expected<uint16_t> listen(uint16_t port = 0, const std::string& device = {});
+
+    /// Starts serving threads
+    Expected<void> start(uint32_t threads = 1);
+
+    /// Stops threads and closes all ports
+    void stop();
+
+    /// Answers request datagram received on port bound to `device`, empty answer means the request is dropped
+    std::string answer(std::string_view request, const std::string& device = {}) const;
+
+    /// Count of answered requests
+    uint64_t requests() const;
+
+    /// Count of answers dropped by impairment
+    uint64_t dropped() const;
+
+private:
+    struct Endpoint
+    {
+        int         fd   = -1;
+        uint16_t    port = 0;
+        std::string device;
+    };
+
+    struct Delayed
+    {
+        std::chrono::steady_clock::time_point at;
+        int                                   fd = -1;
+        sockaddr_in                           to{};
+        std::string                           data;
+
+        bool operator>(const Delayed& other) const
+        {
+            return at > other.at;
+        }
+    };
+
+    std::string answer(std::string_view request, const std::string& device, Impairment& impairment) const;
+    void        serve();
+    void        send();
+
+private:
+    using DelayQueue = std::priority_queue<Delayed, std::vector<Delayed>, std::greater<Delayed>>;
+
+    std::map<std::string, Snmprec::Ptr> m_devices;
+    std::map<std::string, Impairment>   m_impairments;
+    mutable std::shared_mutex           m_devicesMutex;
+    std::mutex                          m_mutex;
+    std::deque<Endpoint>                m_endpoints;
+    std::vector<std::thread>            m_threads;
+    std::thread                         m_sender;
+    std::mutex                          m_delayedMutex;
+    std::condition_variable             m_delayedCv;
+    DelayQueue                          m_delayed;
+    std::atomic<bool>                   m_stop     = true;
+    mutable std::atomic<uint64_t>       m_requests = 0;
+    std::atomic<uint64_t>               m_dropped  = 0;
+    int                                 m_epoll    = -1;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::sim
@@ -0,0 +1,222 @@
+/*  =========================================================================
+    snmprec.cpp - Indexed .snmprec recording of the device
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#include "snmprec.h"
+#include <algorithm>
+#include <charconv>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fty::sim {
+
+// =====================================================================================================================
+
+Expected<Oid> parseOid(std::string_view str)
+{
+    if (!str.empty() && str.front() == '.') {
+        str.remove_prefix(1);
+    }
+    if (str.empty()) {
+        return unexpected("OID is empty");
+    }
+
+    Oid oid;
+    while (!str.empty()) {
+        uint32_t num = 0;
+        auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), num);
+        if (ec != std::errc()) {
+            return unexpected("Wrong OID '{}'", std::string(str));
+        }
+        oid.push_back(num);
+        str.remove_prefix(size_t(ptr - str.data()));
+        if (!str.empty()) {
+            if (str.front() != '.' || str.size() == 1) {
+                return unexpected("Wrong OID '{}'", std::string(str));
+            }
+            str.remove_prefix(1);
+        }
+    }
+    return oid;
+}
+
+std::string toString(const Oid& oid)
+{
+    std::string out;
+    for (size_t i = 0; i < oid.size(); ++i) {
+        if (i) {
+            out += '.';
+        }
+        out += std::to_string(oid[i]);
+    }
+    return out;
+}
+
+// =====================================================================================================================
+
+Snmprec::~Snmprec()
+{
+    if (m_mapped && m_data) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+}
+
+Expected<Snmprec::Ptr> Snmprec::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return unexpected("Cannot open {}", path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return unexpected("Cannot stat {}", path);
+    }
+
+    std::shared_ptr<Snmprec> rec(new Snmprec);
+    if (st.st_size > 0) {
+        void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            return unexpected("Cannot map {}", path);
+        }
+        rec->m_data   = static_cast<const char*>(data);
+        rec->m_size   = size_t(st.st_size);
+        rec->m_mapped = true;
+    }
+    ::close(fd);
+
+    if (auto res = rec->index(); !res) {
+        return unexpected("{}: {}", path, res.error());
+    }
+    return Ptr(rec);
+}
+
+Expected<Snmprec::Ptr> Snmprec::parse(std::string content)
+{
+    std::shared_ptr<Snmprec> rec(new Snmprec);
+    rec->m_owned = std::move(content);
+    rec->m_data  = rec->m_owned.data();
+    rec->m_size  = rec->m_owned.size();
+
+    if (auto res = rec->index(); !res) {
+        return unexpected(res.error());
+    }
+    return Ptr(rec);
+}
+
+Expected<void> Snmprec::index()
+{
+    std::string_view content(m_data, m_size);
+
+    size_t num = 0;
+    while (!content.empty()) {
+        ++num;
+        size_t           end  = content.find('\n');
+        std::string_view line = content.substr(0, end);
+        content.remove_prefix(end == std::string_view::npos ? content.size() : end + 1);
+
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+
+        size_t first  = line.find('|');
+        size_t second = first == std::string_view::npos ? first : line.find('|', first + 1);
+        if (second == std::string_view::npos) {
+            return unexpected("line {}: expected 'oid|tag|value'", num);
+        }
+
+        Entry entry;
+        if (auto oid = parseOid(line.substr(0, first))) {
+            entry.oid = std::move(*oid);
+        } else {
+            return unexpected("line {}: {}", num, oid.error());
+        }
+
+        // Tag is BER type in decimal, `x` marks hex value, variation module after `:` is ignored
+        std::string_view tag = line.substr(first + 1, second - first - 1);
+        tag                  = tag.substr(0, tag.find(':'));
+        if (!tag.empty() && tag.back() == 'x') {
+            entry.hex = true;
+            tag.remove_suffix(1);
+        }
+        unsigned type = 0;
+        if (auto [ptr, ec] = std::from_chars(tag.data(), tag.data() + tag.size(), type);
+            ec != std::errc() || ptr != tag.data() + tag.size() || type > 0xff) {
+            return unexpected("line {}: wrong tag", num);
+        }
+        entry.tag   = uint8_t(type);
+        entry.value = line.substr(second + 1);
+
+        m_entries.push_back(std::move(entry));
+    }
+
+    // Recordings are usually sorted already
+    if (!std::is_sorted(m_entries.begin(), m_entries.end(), [](const Entry& l, const Entry& r) {
+            return l.oid < r.oid;
+        })) {
+        std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry& l, const Entry& r) {
+            return l.oid < r.oid;
+        });
+    }
+    return {};
+}
+
+const Snmprec::Entry* Snmprec::get(const Oid& oid) const
+{
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), oid, [](const Entry& entry, const Oid& val) {
+        return entry.oid < val;
+    });
+    if (it != m_entries.end() && it->oid == oid) {
+        return &*it;
+    }
+    return nullptr;
+}
+
+const Snmprec::Entry* Snmprec::next(const Oid& oid) const
+{
+    auto it = std::upper_bound(m_entries.begin(), m_entries.end(), oid, [](const Oid& val, const Entry& entry) {
+        return val < entry.oid;
+    });
+    if (it != m_entries.end()) {
+        return &*it;
+    }
+    return nullptr;
+}
+
+const std::vector<Snmprec::Entry>& Snmprec::entries() const
+{
+    return m_entries;
+}
+
+std::string_view Snmprec::content() const
+{
+    return std::string_view(m_data, m_size);
+}
+
+// =====================================================================================================================
+
+} // namespace fty::sim
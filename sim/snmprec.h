@@ -0,0 +1,95 @@
+/*  =========================================================================
+    snmprec.h - Indexed .snmprec recording of the device
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+ */
+
+#pragma once
+#include <fty/expected.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fty::sim {
+
+// =====================================================================================================================
+
+using Oid = std::vector<uint32_t>;
+
+/// Parses dotted OID, leading dot is optional
+Expected<Oid> parseOid(std::string_view str);
+
+/// Dotted OID without leading dot
+std::string toString(const Oid& oid);
+
+// =====================================================================================================================
+
+/// Snmpsim recording (`oid|tag|value` per line, `tag` with `x` suffix has hex encoded value) indexed by OID.
+/// Values point to the file content, which is memory mapped and shared by all agents serving the device.
+class Snmprec
+{
+public:
+    struct Entry
+    {
+        Oid              oid;
+        uint8_t          tag = 0;     // BER type of the value
+        bool             hex = false; // value is hex encoded
+        std::string_view value;
+    };
+
+    using Ptr = std::shared_ptr<const Snmprec>;
+
+public:
+    ~Snmprec();
+
+    Snmprec(const Snmprec&) = delete;
+    Snmprec& operator=(const Snmprec&) = delete;
+
+    /// Maps the file
+    static Expected<Ptr> open(const std::string& path);
+
+    /// Takes generated content
+    static Expected<Ptr> parse(std::string content);
+
+    /// Entry with exactly this OID
+    const Entry* get(const Oid& oid) const;
+
+    /// First entry after the OID
+    const Entry* next(const Oid& oid) const;
+
+    const std::vector<Entry>& entries() const;
+
+    /// Whole recording as it was loaded
+    std::string_view content() const;
+
+private:
+    Snmprec() = default;
+    Expected<void> index();
+
+private:
+    const char*        m_data   = nullptr;
+    size_t             m_size   = 0;
+    bool               m_mapped = false;
+    std::string        m_owned;
+    std::vector<Entry> m_entries;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::sim
@@ -1,5 +1,6 @@
 #include "test-common.h"
-#include <fty/process.h>
+#include "snmp-agent.h"
+#include "src/jobs/impl/delta.h"
 
 TEST_CASE("Assets / Empty request")
 {
@@ -33,17 +34,11 @@ TEST_CASE("Assets / Unaviable host")
 
 TEST_CASE("Assets / Test output")
 {
-    // clang-format off
-    fty::Process proc("snmpsimd",  {
-        "--data-dir=assets",
-        "--agent-udpv4-endpoint=127.0.0.1:1161",
-        "--logging-method=file:.snmpsim.txt",
-        "--variation-modules-dir=assets",
-        "--log-level=error"
-    });
-    // clang-format on
-
-    if (auto pid = proc.run()) {
+    fty::sim::SnmpAgent agent;
+    REQUIRE(agent.load("assets"));
+    REQUIRE(agent.listen(1161));
+
+    if (auto started = agent.start()) {
         fty::Message msg = Test::createMessage(fty::commands::assets::Subject);
 
         fty::commands::assets::In in;
@@ -100,11 +95,151 @@ TEST_CASE("Assets / Test output")
             FAIL(ret.error());
         }
 
-        proc.interrupt();
-        proc.wait();
+        agent.stop();
     } else {
-        FAIL(pid.error());
+        FAIL(started.error());
+    }
+}
+
+TEST_CASE("Assets / Delta")
+{
+    auto unit = [](const std::string& subAddress, const std::string& serial) {
+        fty::commands::assets::Return ret;
+        ret.subAddress     = subAddress;
+        ret.asset.type     = "device";
+        ret.asset.subtype  = "epdu";
+        auto& ext          = ret.asset.ext.append();
+        ext.append("serial_no", serial);
+        ext.append("read_only", "true");
+        return ret;
+    };
+
+    fty::commands::assets::Out before;
+    before.append(unit("1", "AAA"));
+    before.append(unit("2", "BBB"));
+
+    SECTION("Unchanged")
+    {
+        auto delta = fty::impl::AssetsHistory::diff(before, before);
+        CHECK(delta.unchanged);
+        CHECK(delta.added.empty());
+        CHECK(delta.removed.empty());
+        CHECK(delta.changed.empty());
+    }
+
+    SECTION("Changed")
+    {
+        fty::commands::assets::Out after;
+        after.append(unit("1", "AAA"));
+        after.append(unit("2", "CCC"));
+        after.append(unit("3", "DDD"));
+
+        auto delta = fty::impl::AssetsHistory::diff(before, after);
+        CHECK_FALSE(delta.unchanged);
+        REQUIRE(1 == delta.added.size());
+        CHECK("3" == delta.added[0].subAddress.value());
+        CHECK(delta.removed.empty());
+        REQUIRE(1 == delta.changed.size());
+        CHECK("2" == delta.changed[0].subAddress.value());
+        CHECK("serial_no" == delta.changed[0].key.value());
+        CHECK("BBB" == delta.changed[0].before.value());
+        CHECK("CCC" == delta.changed[0].after.value());
     }
+
+    SECTION("Removed")
+    {
+        fty::commands::assets::Out after;
+        after.append(unit("1", "AAA"));
+
+        auto delta = fty::impl::AssetsHistory::diff(before, after);
+        CHECK_FALSE(delta.unchanged);
+        REQUIRE(1 == delta.removed.size());
+        CHECK("2" == delta.removed[0]);
+    }
+}
+
+TEST_CASE("Assets / Delta request")
+{
+    fty::sim::SnmpAgent agent;
+    REQUIRE(agent.load("assets"));
+    REQUIRE(agent.listen(1161));
+
+    if (auto started = agent.start()) {
+        fty::Message msg = Test::createMessage(fty::commands::delta::Subject);
+
+        fty::commands::delta::In in;
+        in.address            = "127.0.0.1";
+        in.port               = 1161;
+        in.protocol           = "nut_snmp";
+        in.settings.timeout   = 10000;
+        in.settings.mib       = "EATON-EPDU-MIB::eatonEpdu";
+        in.settings.community = "epdu.147";
+        msg.userData.setString(*pack::json::serialize(in));
+
+        fty::impl::AssetsHistory::instance().forget("127.0.0.1");
+
+        fty::Expected<fty::Message> first = Test::send(msg);
+        REQUIRE(first);
+        auto res = first->userData.decode<fty::commands::delta::Out>();
+        REQUIRE(res);
+        CHECK_FALSE(res->unchanged);
+        CHECK(res->added.size());
+
+        fty::Expected<fty::Message> second = Test::send(msg);
+        REQUIRE(second);
+        res = second->userData.decode<fty::commands::delta::Out>();
+        REQUIRE(res);
+        CHECK(res->unchanged);
+
+        agent.stop();
+    } else {
+        FAIL(started.error());
+    }
+}
+
+TEST_CASE("Assets / History")
+{
+    using History = fty::impl::AssetsHistory;
+    auto& history = History::instance();
+    history.clear();
+
+    history.update(History::key("fe80::1", 161, "nut_snmp"), {});
+    history.update(History::key("fe80::1", 80, "nut_xml_pdc"), {});
+    history.update(History::key("fe80::1:2", 161, "nut_snmp"), {});
+    history.update(History::key("10.0.0.1", 161, "nut_snmp"), {});
+    history.update(History::key("10.0.0.12", 161, "nut_snmp"), {});
+    REQUIRE(5 == history.size());
+
+    SECTION("IPv6 address")
+    {
+        history.forget("fe80::1");
+        CHECK(3 == history.size());
+        history.forget("fe80::1:2");
+        CHECK(2 == history.size());
+        history.forget("10.0.0.1");
+        CHECK(1 == history.size());
+    }
+
+    SECTION("Port and protocol")
+    {
+        history.forget("fe80::1", 161, "nut_snmp");
+        CHECK(4 == history.size());
+        history.forget("10.0.0.1", 0, "nut_xml_pdc");
+        CHECK(4 == history.size());
+        history.forget("10.0.0.1", 0, "nut_snmp");
+        CHECK(3 == history.size());
+    }
+
+    SECTION("Capacity")
+    {
+        for (size_t i = 0; i < History::MaxDevices; ++i) {
+            history.update(History::key("10.1." + std::to_string(i / 256) + "." + std::to_string(i % 256), 161,
+                "nut_snmp"), {});
+        }
+        CHECK(History::MaxDevices == history.size());
+    }
+
+    history.clear();
 }
 
 /*TEST_CASE("Assets / Powercom")
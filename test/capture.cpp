@@ -0,0 +1,134 @@
+#include "test-common.h"
+#include "capture.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+TEST_CASE("Capture / Record and replay")
+{
+    std::string file = (std::filesystem::temp_directory_path() / "discovery-capture.jsonl").string();
+
+    const std::string address = "10.255.255.250:161";
+    const std::string oid     = ".1.3.6.1.2.1.1.2.0";
+
+    REQUIRE(fty::capture::start(file));
+
+    fty::Message msg = Test::createMessage(fty::commands::protocols::Subject);
+    msg.userData.setString(R"({"address": "10.255.255.250"})");
+    fty::capture::request(msg);
+
+    auto read = fty::capture::exchangeOne(fty::capture::kind::Snmp, address, oid, []() {
+        return fty::Expected<std::string>(".1.3.6.1.4.1.705.1");
+    });
+    CHECK(".1.3.6.1.4.1.705.1" == *read);
+
+    auto failed = fty::capture::exchangeOne(fty::capture::kind::Http, "10.255.255.250", "80/product.xml", []() {
+        return fty::Expected<std::string>(fty::unexpected("timeout"));
+    });
+    CHECK_FALSE(failed);
+    fty::capture::stop();
+
+    auto records = fty::capture::read(file);
+    REQUIRE(records);
+    REQUIRE(3 == records->size());
+    CHECK(fty::capture::kind::Request == (*records)[0].kind.value());
+    CHECK("protocols" == (*records)[0].key.value());
+    CHECK("unit-test" == (*records)[0].address.value());
+
+    // Answers come from the capture, functions are never called
+    REQUIRE(fty::capture::replay(file));
+    auto never = []() -> fty::Expected<std::string> {
+        FAIL("Exchange must be replayed");
+        return fty::unexpected("not replayed");
+    };
+
+    auto replayed = fty::capture::exchangeOne(fty::capture::kind::Snmp, address, oid, never);
+    REQUIRE(replayed);
+    CHECK(".1.3.6.1.4.1.705.1" == *replayed);
+
+    auto replayedFail = fty::capture::exchangeOne(fty::capture::kind::Http, "10.255.255.250", "80/product.xml", never);
+    REQUIRE_FALSE(replayedFail);
+    CHECK("timeout" == replayedFail.error());
+
+    auto missing = fty::capture::exchangeOne(fty::capture::kind::Snmp, "10.255.255.251:161", oid, never);
+    CHECK_FALSE(missing);
+
+    fty::capture::stop();
+    std::filesystem::remove(file);
+}
+
+TEST_CASE("Capture / Secrets")
+{
+    std::string file = (std::filesystem::temp_directory_path() / "discovery-secrets.jsonl").string();
+
+    REQUIRE(fty::capture::start(file));
+    using std::filesystem::perms;
+    CHECK(perms::none == (std::filesystem::status(file).permissions() & (perms::group_all | perms::others_all)));
+
+    fty::commands::assets::In in;
+    in.address            = "10.255.255.250";
+    in.protocol           = "nut_snmp";
+    in.settings.community = "private-community";
+    in.settings.username  = "admin";
+    in.settings.password  = "secret-password";
+
+    fty::Message msg = Test::createMessage(fty::commands::assets::Subject);
+    msg.userData.setString(*pack::json::serialize(in));
+    fty::capture::request(msg);
+
+    fty::commands::mibs::In mibs;
+    mibs.address   = "10.255.255.250";
+    mibs.community = "private-community";
+
+    fty::Message mmsg = Test::createMessage(fty::commands::mibs::Subject);
+    mmsg.userData.setString(*pack::json::serialize(mibs));
+    fty::capture::request(mmsg);
+    fty::capture::stop();
+
+    std::ifstream     st(file);
+    std::stringstream content;
+    content << st.rdbuf();
+    CHECK(content.str().find("private-community") == std::string::npos);
+    CHECK(content.str().find("secret-password") == std::string::npos);
+    CHECK(content.str().find("admin") == std::string::npos);
+    CHECK(content.str().find("10.255.255.250") != std::string::npos);
+
+    std::filesystem::remove(file);
+}
+
+TEST_CASE("Capture / Replay assets")
+{
+    std::string file = (std::filesystem::temp_directory_path() / "discovery-replay.jsonl").string();
+
+    // Device which does not exist, everything agent needs is in the capture
+    REQUIRE(fty::capture::start(file));
+    fty::capture::exchangeOne(fty::capture::kind::Host, "10.255.255.249", "available", []() {
+        return fty::Expected<std::string>("yes");
+    });
+    fty::capture::exchangeOne(fty::capture::kind::Driver, "10.255.255.249", "nut_xml_pdc:80", []() {
+        return fty::Expected<std::string>(
+            "device.type: ups\ndevice.mfr: EATON\ndevice.model: Eaton 5PX\ndevice.serial: G202E0001\n");
+    });
+    fty::capture::stop();
+
+    REQUIRE(fty::capture::replay(file));
+
+    fty::commands::assets::In in;
+    in.address  = "10.255.255.249";
+    in.protocol = "nut_xml_pdc";
+    in.port     = 80;
+    in.force    = true;
+
+    fty::Message msg = Test::createMessage(fty::commands::assets::Subject);
+    msg.userData.setString(*pack::json::serialize(in));
+
+    fty::Expected<fty::Message> ret = Test::send(msg);
+    fty::capture::stop();
+    std::filesystem::remove(file);
+
+    REQUIRE(ret);
+    auto res = ret->userData.decode<fty::commands::assets::Out>();
+    REQUIRE(res);
+    REQUIRE(1 == res->size());
+    CHECK("ups" == (*res)[0].asset.subtype.value());
+}
@@ -0,0 +1,182 @@
+#include "test-common.h"
+#include "src/jobs/impl/fingerprint.h"
+#include "src/jobs/impl/negative-cache.h"
+#include "snmp-agent.h"
+#include <chrono>
+
+TEST_CASE("Negative cache / Backoff")
+{
+    auto& cache = fty::impl::NegativeCache::instance();
+    cache.clear();
+
+    CHECK_FALSE(cache.find("10.0.0.1", "nut_xml_pdc"));
+
+    cache.failed("10.0.0.1", "nut_xml_pdc", fty::impl::NegativeCache::Kind::Unsupported, "unsupported card type");
+    auto err = cache.find("10.0.0.1", "nut_xml_pdc");
+    REQUIRE(err);
+    CHECK("unsupported card type" == *err);
+    CHECK_FALSE(cache.find("10.0.0.1", "nut_snmp"));
+
+    cache.succeeded("10.0.0.1", "nut_xml_pdc");
+    CHECK_FALSE(cache.find("10.0.0.1", "nut_xml_pdc"));
+
+    int calls = 0;
+    auto probe = [&]() -> fty::Expected<void> {
+        ++calls;
+        return fty::unexpected("Timeout");
+    };
+    CHECK_FALSE(cache.guard("10.0.0.2", "nut_snmp", false, probe));
+    CHECK_FALSE(cache.guard("10.0.0.2", "nut_snmp", false, probe));
+    CHECK(1 == calls);
+    CHECK_FALSE(cache.guard("10.0.0.2", "nut_snmp", true, probe));
+    CHECK(2 == calls);
+
+    cache.clear();
+}
+
+TEST_CASE("Negative cache / Failure kind")
+{
+    using Kind  = fty::impl::NegativeCache::Kind;
+    auto& cache = fty::impl::NegativeCache::instance();
+    cache.clear();
+
+    // Message does not matter, only transport marks the host unreachable
+    CHECK_FALSE(cache.guard("10.0.0.3", "snmp", false, []() -> fty::Expected<void> {
+        return fty::unexpected("Host is not available or SNMP is not supported");
+    }));
+    CHECK(Kind::Unsupported == cache.failure("10.0.0.3", "snmp"));
+
+    CHECK_FALSE(cache.guard("10.0.0.4", "snmp", false, []() -> fty::Expected<void> {
+        fty::impl::NegativeCache::unreachable();
+        return fty::unexpected("Error");
+    }));
+    CHECK(Kind::Unreachable == cache.failure("10.0.0.4", "snmp"));
+
+    // Mark does not leak to the next call
+    CHECK_FALSE(cache.guard("10.0.0.5", "snmp", false, []() -> fty::Expected<void> {
+        return fty::unexpected("Error");
+    }));
+    CHECK(Kind::Unsupported == cache.failure("10.0.0.5", "snmp"));
+
+    cache.clear();
+}
+
+TEST_CASE("Negative cache / Prune")
+{
+    auto& config  = fty::Config::instance();
+    auto  backoff = config.negativeBackoff.value();
+    auto  max     = config.negativeBackoffMax.value();
+    config.negativeBackoff    = 1;
+    config.negativeBackoffMax = 1;
+
+    auto& cache = fty::impl::NegativeCache::instance();
+    cache.clear();
+
+    cache.failed("10.0.0.6", "snmp", fty::impl::NegativeCache::Kind::Unreachable, "Timeout");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2300));
+
+    // Host never queried again is dropped by failure of another one
+    cache.failed("10.0.0.7", "snmp", fty::impl::NegativeCache::Kind::Unreachable, "Timeout");
+    CHECK_FALSE(cache.failure("10.0.0.6", "snmp"));
+    CHECK(cache.failure("10.0.0.7", "snmp"));
+
+    cache.clear();
+    config.negativeBackoff    = backoff;
+    config.negativeBackoffMax = max;
+}
+
+TEST_CASE("Negative cache / Unsupported SNMP")
+{
+    using Kind = fty::impl::NegativeCache::Kind;
+    fty::impl::NegativeCache::instance().clear();
+
+    fty::sim::SnmpAgent agent;
+    REQUIRE(agent.load("assets"));
+    REQUIRE(agent.listen(1161));
+
+    auto started = agent.start();
+    REQUIRE(started);
+
+    fty::commands::mibs::In in;
+    in.address = "127.0.0.1";
+    in.port    = 1161;
+    in.timeout = 500;
+
+    fty::Message msg = Test::createMessage(fty::commands::mibs::Subject);
+
+    SECTION("Device answers without any known mib")
+    {
+        in.community = "generic.1";
+        msg.userData.setString(*pack::json::serialize(in));
+
+        fty::Expected<fty::Message> ret = Test::send(msg);
+        REQUIRE_FALSE(ret);
+
+        auto key = fty::impl::FingerprintCache::key("127.0.0.1", 1161, {}, "generic.1");
+        CHECK(Kind::Unsupported == fty::impl::NegativeCache::instance().failure(key, "snmp"));
+    }
+
+    SECTION("Device does not answer")
+    {
+        in.community = "nobody";
+        msg.userData.setString(*pack::json::serialize(in));
+
+        fty::Expected<fty::Message> ret = Test::send(msg);
+        REQUIRE_FALSE(ret);
+
+        auto key = fty::impl::FingerprintCache::key("127.0.0.1", 1161, {}, "nobody");
+        CHECK(Kind::Unreachable == fty::impl::NegativeCache::instance().failure(key, "snmp"));
+    }
+
+    agent.stop();
+    fty::impl::NegativeCache::instance().clear();
+}
+
+TEST_CASE("Forget / Empty address")
+{
+    fty::Message msg = Test::createMessage(fty::commands::forget::Subject);
+
+    fty::commands::forget::In in;
+    msg.userData.setString(*pack::json::serialize(in));
+
+    fty::Expected<fty::Message> ret = Test::send(msg);
+    CHECK_FALSE(ret);
+    CHECK("Address is empty" == ret.error());
+}
+
+TEST_CASE("Forget / Cached failure")
+{
+    fty::commands::mibs::In in;
+    in.address   = "127.0.0.1";
+    in.port      = 1162;
+    in.community = "nobody";
+    in.timeout   = 500;
+
+    fty::Message msg = Test::createMessage(fty::commands::mibs::Subject);
+    msg.userData.setString(*pack::json::serialize(in));
+
+    fty::Expected<fty::Message> ret = Test::send(msg);
+    REQUIRE_FALSE(ret);
+
+    // Second request is answered from the cache with the same error
+    auto                        start  = std::chrono::steady_clock::now();
+    fty::Expected<fty::Message> cached = Test::send(msg);
+    REQUIRE_FALSE(cached);
+    CHECK(ret.error() == cached.error());
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+
+    fty::commands::forget::In fin;
+    fin.address = "127.0.0.1";
+
+    fty::Message fmsg = Test::createMessage(fty::commands::forget::Subject);
+    fmsg.userData.setString(*pack::json::serialize(fin));
+
+    fty::Expected<fty::Message> forgotten = Test::send(fmsg);
+    REQUIRE(forgotten);
+    auto res = forgotten->userData.decode<fty::commands::forget::Out>();
+    REQUIRE(res);
+    CHECK(res->size() >= 1);
+
+    auto key = fty::impl::FingerprintCache::key("127.0.0.1", 1162, {}, "nobody");
+    CHECK_FALSE(fty::impl::NegativeCache::instance().find(key, "snmp"));
+}
@@ -0,0 +1,132 @@
+#include "test-common.h"
+#include "inspect.h"
+#include "snmp-agent.h"
+#include <future>
+#include <thread>
+
+static std::optional<fty::inspect::Info> find(const std::string& correlationId)
+{
+    for (const auto& info : fty::inspect::jobs()) {
+        if (info.correlationId == correlationId) {
+            return info;
+        }
+    }
+    return std::nullopt;
+}
+
+TEST_CASE("Inspect / Jobs")
+{
+    {
+        fty::inspect::Job job("assets", "inspect-1");
+        job.setTarget("10.0.0.1");
+
+        auto queued = find("inspect-1");
+        REQUIRE(queued);
+        CHECK("assets" == queued->subject);
+        CHECK("10.0.0.1" == queued->target);
+        CHECK(!queued->running);
+        CHECK(0 == queued->thread);
+        CHECK(queued->stage.empty());
+
+        std::promise<void> entered;
+        std::promise<void> release;
+        std::thread        worker([&]() {
+            fty::inspect::Active active(job);
+            fty::inspect::Stage  outer("SNMP GET {}", "sysObjectID");
+            {
+                fty::inspect::Stage inner("waiting {} pid {}", "snmp-ups", 1234);
+                entered.set_value();
+                release.get_future().wait();
+            }
+        });
+        entered.get_future().wait();
+
+        // Read while the job thread is inside the stage
+        auto running = find("inspect-1");
+        REQUIRE(running);
+        CHECK(running->running);
+        CHECK(0 != running->thread);
+        CHECK("waiting snmp-ups pid 1234" == running->stage);
+
+        release.set_value();
+        worker.join();
+
+        // Previous stage is restored on leave
+        CHECK(find("inspect-1")->stage.empty());
+        CHECK(!fty::inspect::active());
+    }
+    CHECK(!find("inspect-1"));
+
+    // Stages of thread without job are ignored, jobs without subject are not listed
+    fty::inspect::Stage  stage("ignored");
+    fty::inspect::Job    anonymous("", "inspect-2");
+    fty::inspect::Active active(anonymous);
+    CHECK(!fty::inspect::active());
+    CHECK(!find("inspect-2"));
+}
+
+TEST_CASE("Inspect / Request")
+{
+    fty::commands::inspect::In in;
+    in.subject = fty::commands::inspect::Subject;
+
+    fty::Message msg = Test::createMessage(fty::commands::inspect::Subject);
+    msg.userData.setString(*pack::json::serialize(in));
+
+    fty::Expected<fty::Message> ret = Test::send(msg);
+    REQUIRE(ret);
+    auto res = ret->userData.decode<fty::commands::inspect::Out>();
+    REQUIRE(res);
+
+    // Request sees itself, served on the bus thread
+    REQUIRE(1 == res->size());
+    auto self = res->find([](const fty::commands::inspect::Job& job) {
+        return job.subject.value() == fty::commands::inspect::Subject;
+    });
+    REQUIRE(self);
+    CHECK("running" == self->state.value());
+    CHECK("running" == self->stage.value());
+    CHECK(0 != self->thread);
+}
+
+TEST_CASE("Inspect / Delta request")
+{
+    fty::sim::SnmpAgent agent;
+    REQUIRE(agent.load("assets"));
+    agent.impair({}, *fty::sim::Impairment::parse("latency=20"));
+    REQUIRE(agent.listen(1161));
+
+    auto started = agent.start();
+    REQUIRE(started);
+
+    fty::commands::delta::In in;
+    in.address            = "127.0.0.1";
+    in.port               = 1161;
+    in.protocol           = "nut_snmp";
+    in.settings.timeout   = 10000;
+    in.settings.mib       = "EATON-EPDU-MIB::eatonEpdu";
+    in.settings.community = "epdu.147";
+
+    fty::Message msg       = Test::createMessage(fty::commands::delta::Subject);
+    msg.meta.correlationId = "inspect-delta";
+    msg.userData.setString(*pack::json::serialize(in));
+
+    auto reply = std::async(std::launch::async, [&]() {
+        return Test::send(msg);
+    });
+
+    // Assets discovery inside the delta request is not listed as one more job
+    size_t seen = 0;
+    while (reply.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready) {
+        size_t count = 0;
+        for (const auto& info : fty::inspect::jobs()) {
+            count += info.correlationId == "inspect-delta";
+        }
+        seen = std::max(seen, count);
+    }
+    CHECK(1 == seen);
+    CHECK(reply.get());
+    CHECK(!find("inspect-delta"));
+
+    agent.stop();
+}
@@ -0,0 +1,49 @@
+#include "test-common.h"
+#include "logger.h"
+
+TEST_CASE("Logger / Format")
+{
+    using fty::logger::format;
+
+    CHECK("Got message" == format("Got message"));
+    CHECK("Got message subject=assets size=42" == format("Got message", {{"subject", "assets"}, {"size", 42}}));
+    CHECK(R"(Got message error="no \"answer\"" empty="")" ==
+          format("Got message", {{"error", std::string("no \"answer\"")}, {"empty", ""}}));
+    CHECK(R"(Output text="a: 1\nb: 2")" == format("Output", {{"text", "a: 1\nb: 2"}}));
+}
+
+TEST_CASE("Logger / Rate limit")
+{
+    fty::logger::Site site(fty::logger::Level::Debug, __FILE__, __LINE__, __func__);
+
+    int allowed = 0;
+    for (int i = 0; i < 10; ++i) {
+        allowed += site.allow(3);
+    }
+    // Can be more if the test crossed a second boundary
+    CHECK(3 <= allowed);
+    CHECK(allowed <= 6);
+    CHECK(10 - allowed == site.takeSuppressed());
+    CHECK(0 == site.takeSuppressed());
+
+    CHECK(site.allow(0));
+}
+
+TEST_CASE("Logger / Dropped records")
+{
+    fty::logger::Site site(fty::logger::Level::Debug, __FILE__, __LINE__, __func__);
+
+    uint64_t before = fty::logger::dropped();
+    fty::logger::start(2, 0);
+    for (int i = 0; i < 1000; ++i) {
+        fty::logger::write(site, "Flood");
+    }
+    fty::logger::stop();
+
+    // Warning about dropped records does not reset the exported count
+    uint64_t after = fty::logger::dropped();
+    CHECK(before < after);
+    fty::logger::start(2, 0);
+    fty::logger::stop();
+    CHECK(after == fty::logger::dropped());
+}
@@ -0,0 +1,105 @@
+#include "test-common.h"
+#include "memory.h"
+#include <thread>
+
+TEST_CASE("Memory / Scope")
+{
+    fty::memory::enable(true);
+
+    std::vector<char>* kept = nullptr;
+    fty::memory::Usage usage;
+    {
+        fty::memory::Scope scope;
+        {
+            std::vector<char> temp(100000);
+        }
+        kept  = new std::vector<char>(1000);
+        usage = scope.finish();
+    }
+
+    CHECK(101000 <= usage.allocated);
+    CHECK(3 <= usage.allocations);
+    CHECK(100000 <= usage.peak);
+    CHECK(1000 <= usage.live());
+    CHECK(usage.live() < 2000);
+    delete kept;
+
+    // Other threads are not counted
+    fty::memory::Scope scope;
+    std::thread([]() {
+        std::string str(5000, 'a');
+    }).join();
+    CHECK(scope.finish().allocated < 5000);
+
+    fty::memory::enable(false);
+    fty::memory::Scope disabled;
+    std::string        str(5000, 'a');
+    CHECK(0 == disabled.finish().allocated);
+    fty::memory::enable(true);
+}
+
+TEST_CASE("Memory / Consumers")
+{
+    fty::memory::reset();
+
+    fty::memory::Usage small;
+    small.allocated   = 100;
+    small.allocations = 2;
+    small.peak        = 80;
+
+    fty::memory::Usage large;
+    large.allocated   = 1000;
+    large.freed       = 900;
+    large.allocations = 10;
+    large.peak        = 800;
+
+    fty::memory::account("mibs", "10.0.0.1", small);
+    fty::memory::account("assets", "10.0.0.2", large);
+    fty::memory::account("assets", "10.0.0.2", small);
+
+    auto top = fty::memory::top(10);
+    REQUIRE(2 == top.size());
+    CHECK("assets" == top[0].subject);
+    CHECK("10.0.0.2" == top[0].target);
+    CHECK(2 == top[0].jobs);
+    CHECK(1100 == top[0].allocated);
+    CHECK(12 == top[0].allocations);
+    CHECK(800 == top[0].peak);
+    CHECK(200 == top[0].retained);
+
+    CHECK(1 == fty::memory::top(1).size());
+    fty::memory::reset();
+    CHECK(fty::memory::top(10).empty());
+}
+
+TEST_CASE("Memory / Request")
+{
+    fty::memory::reset();
+
+    fty::commands::protocols::In in;
+    in.address = "__fake__";
+
+    fty::Message msg = Test::createMessage(fty::commands::protocols::Subject);
+    msg.userData.setString(*pack::json::serialize(in));
+    REQUIRE(Test::send(msg));
+
+    fty::commands::memory::In query;
+    query.reset = true;
+
+    fty::Message mmsg = Test::createMessage(fty::commands::memory::Subject);
+    mmsg.userData.setString(*pack::json::serialize(query));
+
+    fty::Expected<fty::Message> ret = Test::send(mmsg);
+    REQUIRE(ret);
+    auto res = ret->userData.decode<fty::commands::memory::Out>();
+    REQUIRE(res);
+
+    auto protocols = res->find([](const fty::commands::memory::Consumer& con) {
+        return con.subject.value() == "protocols";
+    });
+    REQUIRE(protocols);
+    CHECK("__fake__" == protocols->target.value());
+    CHECK(1 == protocols->jobs);
+    CHECK(0 < protocols->allocations);
+    CHECK(protocols->peak <= protocols->allocated);
+}
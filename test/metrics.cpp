@@ -0,0 +1,128 @@
+#include "test-common.h"
+#include "metrics.h"
+#include "src/exporter.h"
+#include "stats.h"
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+TEST_CASE("Metrics / Render")
+{
+    auto& requests = fty::metrics::counter("test_requests_total", "Test requests", {{"subject", "mibs"}});
+    requests.inc();
+    requests.inc(2);
+    CHECK(&requests == &fty::metrics::counter("test_requests_total", "Test requests", {{"subject", "mibs"}}));
+
+    fty::metrics::counter("test_requests_total", "Test requests", {{"subject", "a\"b\\c"}}).inc();
+
+    auto& running = fty::metrics::gauge("test_running", "Test jobs");
+    {
+        fty::metrics::Track track(running);
+        CHECK(1 == running.value());
+    }
+    CHECK(0 == running.value());
+    running.dec();
+
+    fty::metrics::collect("test_collected", "Test collected value", false, []() {
+        return 42.;
+    });
+
+    fty::stats::reset();
+    fty::stats::record(fty::stats::Stage::SnmpGet, 80);
+    fty::stats::record(fty::stats::Stage::SnmpGet, 2000000, false);
+
+    std::string out = fty::metrics::render();
+    auto        has = [&](const std::string& text) {
+        return out.find(text) != std::string::npos;
+    };
+
+    CHECK(has("# TYPE test_requests_total counter\n"));
+    CHECK(has("test_requests_total{subject=\"mibs\"} 3\n"));
+    CHECK(has("test_requests_total{subject=\"a\\\"b\\\\c\"} 1\n"));
+    CHECK(has("# TYPE test_running gauge\ntest_running -1\n"));
+    CHECK(has("test_collected 42\n"));
+
+    CHECK(has("fty_discovery_stage_duration_seconds_bucket{stage=\"snmp-get\",le=\"0.0001\"} 1\n"));
+    CHECK(has("fty_discovery_stage_duration_seconds_bucket{stage=\"snmp-get\",le=\"1\"} 1\n"));
+    CHECK(has("fty_discovery_stage_duration_seconds_bucket{stage=\"snmp-get\",le=\"5\"} 2\n"));
+    CHECK(has("fty_discovery_stage_duration_seconds_count{stage=\"snmp-get\"} 2\n"));
+    CHECK(has("fty_discovery_stage_errors_total{stage=\"snmp-get\"} 1\n"));
+    fty::stats::reset();
+}
+
+static std::string scrape(const std::string& path, const std::string& request)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return {};
+    }
+
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+    std::string answer;
+    char        buffer[4096];
+    for (ssize_t got; (got = recv(fd, buffer, sizeof(buffer), 0)) > 0;) {
+        answer.append(buffer, size_t(got));
+    }
+    close(fd);
+    return answer;
+}
+
+TEST_CASE("Metrics / Exporter")
+{
+    std::string path = "/tmp/fty-discovery-ng-test-metrics.sock";
+    fty::metrics::counter("test_scraped_total", "Test scraped counter").inc();
+
+    auto& exporter = fty::Exporter::instance();
+    REQUIRE(exporter.start(path, 0));
+    CHECK(!exporter.start(path, 0));
+
+    auto answer = scrape(path, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    CHECK(answer.rfind("HTTP/1.0 200 OK\r\n", 0) == 0);
+    CHECK(answer.find("Content-Type: text/plain; version=0.0.4\r\n") != std::string::npos);
+    CHECK(answer.find("\r\n\r\n# HELP ") != std::string::npos);
+    CHECK(answer.find("test_scraped_total 1\n") != std::string::npos);
+
+    CHECK(scrape(path, "GET /other HTTP/1.1\r\n\r\n").rfind("HTTP/1.0 404 Not Found\r\n", 0) == 0);
+
+    exporter.stop();
+    CHECK(access(path.c_str(), F_OK) != 0);
+}
+
+TEST_CASE("Metrics / Exporter socket in use")
+{
+    std::string path = "/tmp/fty-discovery-ng-test-metrics-live.sock";
+    unlink(path.c_str());
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    // Left by crashed run, nobody listens
+    int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(bind(stale, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    close(stale);
+
+    auto& exporter = fty::Exporter::instance();
+    REQUIRE(exporter.start(path, 0));
+    exporter.stop();
+    CHECK(access(path.c_str(), F_OK) != 0);
+
+    // Socket of another running agent is neither taken nor removed
+    int live = socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(bind(live, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    REQUIRE(listen(live, 1) == 0);
+
+    CHECK(!exporter.start(path, 0));
+    exporter.stop();
+    CHECK(access(path.c_str(), F_OK) == 0);
+
+    close(live);
+    unlink(path.c_str());
+}
@@ -1,5 +1,6 @@
 #include "test-common.h"
-#include <fty/process.h>
+#include "snmp-agent.h"
+#include "src/jobs/impl/fingerprint.h"
 
 TEST_CASE("Mibs / Empty request")
 {
@@ -36,15 +37,9 @@ TEST_CASE("Mibs / Unaviable host")
 
 TEST_CASE("Mibs / get mibs")
 {
-    // clang-format off
-    fty::Process proc("snmpsimd", {
-        "--data-dir=root",
-        "--agent-udpv4-endpoint=127.0.0.1:1161",
-        "--logging-method=file:.snmpsim.txt",
-        "--variation-modules-dir=root",
-        "--log-level=error"
-    });
-    // clang-format on
+    fty::sim::SnmpAgent agent;
+    REQUIRE(agent.load("root"));
+    REQUIRE(agent.listen(1161));
 
     auto getResponse = [](const fty::commands::mibs::In& in) {
         fty::Message msg = Test::createMessage(fty::commands::mibs::Subject);
@@ -62,8 +57,7 @@ TEST_CASE("Mibs / get mibs")
         return *res;
     };
 
-    if (auto pid = proc.run()) {
-std::cerr << *pid << std::endl;
+    if (auto started = agent.start()) {
         fty::commands::mibs::In in;
         in.address = "127.0.0.1";
         in.port    = 1161;
@@ -118,10 +112,44 @@ std::cerr << *pid << std::endl;
             CHECK("EATON-OIDS::xupsMIB" == res[0]);
         }
 
-        //std::cerr << proc.readAllStandardError() << std::endl;
-        proc.interrupt();
-        proc.wait();
+        SECTION("Cached fingerprint xups.238")
+        {
+            in.community = "xups.238";
+            auto res     = getResponse(in);
+
+            auto key   = fty::impl::FingerprintCache::key("127.0.0.1", 1161, {}, "xups.238");
+            auto print = fty::impl::FingerprintCache::instance().find(key);
+            REQUIRE(print);
+            CHECK(1 == print->mibs.size());
+            CHECK(!print->descr.empty());
+
+            auto cached = getResponse(in);
+            CHECK(res.value() == cached.value());
+
+            // Value of sysUpTime.0 recorded for the device
+            uint64_t upTime = print->upTime;
+            CHECK(0 < upTime);
+            CHECK(upTime < (uint64_t(1) << 32));
+
+            // Same device which kept running hits the cache
+            fty::impl::FingerprintCache::instance().update(key, [&](fty::impl::Fingerprint& fp) {
+                fp.upTime = upTime;
+                fp.mibs   = {"WRONG-MIB"};
+            });
+            auto hit = getResponse(in);
+            CHECK("WRONG-MIB" == hit[0]);
+
+            // Device serving lower sysUpTime than cached was restarted and must be detected again
+            fty::impl::FingerprintCache::instance().update(key, [&](fty::impl::Fingerprint& fp) {
+                fp.upTime = upTime + 1000000;
+                fp.mibs   = {"WRONG-MIB"};
+            });
+            auto detected = getResponse(in);
+            CHECK("EATON-OIDS::xupsMIB" == detected[0]);
+        }
+
+        agent.stop();
     } else {
-        FAIL(pid.error());
+        FAIL(started.error());
     }
 }
@@ -1,4 +1,6 @@
 #include "test-common.h"
+#include "http-server.h"
+#include <algorithm>
 
 TEST_CASE("Protocols/ Empty request")
 {
@@ -92,19 +94,71 @@ TEST_CASE("Protocols / resolve")
     fty::Expected<fty::Message> ret2 = Test::send(msg);
 }
 
-/*TEST_CASE("Protocols / powercom")
+TEST_CASE("Protocols / Simulated http devices")
 {
-    fty::Message msg = Test::createMessage(fty::commands::protocols::Subject);
-
-    fty::commands::protocols::In in;
-    in.address = "10.130.33.34";
-    msg.userData.setString(*pack::json::serialize(in));
-
-    fty::Expected<fty::Message> ret = Test::send(msg);
-
-    CHECK(ret);
-    auto res = ret->userData.decode<fty::commands::protocols::Out>();
-    CHECK(res);
-    CHECK(2 == res->size());
-    CHECK("nut_powercom" == (*res)[0]);
-}*/
+    fty::sim::HttpServer http;
+    auto                 port = http.listen();
+    REQUIRE(port);
+    REQUIRE(http.start());
+
+    // Probes go to the simulated devices for this test only
+    struct RestorePort
+    {
+        uint32_t port = fty::Config::instance().httpPort;
+        ~RestorePort()
+        {
+            fty::Config::instance().httpPort = port;
+        }
+    } restore;
+    fty::Config::instance().httpPort = *port;
+
+    auto detect = [&]() {
+        fty::Message msg = Test::createMessage(fty::commands::protocols::Subject);
+
+        fty::commands::protocols::In in;
+        in.address = "127.0.0.1";
+        in.force   = true;
+        msg.userData.setString(*pack::json::serialize(in));
+
+        fty::Expected<fty::Message> ret = Test::send(msg);
+        REQUIRE(ret);
+        auto res = ret->userData.decode<fty::commands::protocols::Out>();
+        REQUIRE(res);
+        return res->value();
+    };
+    auto contains = [](const std::vector<std::string>& list, const std::string& protocol) {
+        return std::find(list.begin(), list.end(), protocol) != list.end();
+    };
+
+    SECTION("Xml pdc")
+    {
+        REQUIRE(http.addFile("product.xml", "http/product.xml"));
+        REQUIRE(http.addFile("ups_propsum.xml", "http/ups_propsum.xml"));
+
+        auto found = detect();
+        CHECK(contains(found, "nut_xml_pdc"));
+        CHECK_FALSE(contains(found, "nut_powercom"));
+    }
+
+    SECTION("Powercom")
+    {
+        REQUIRE(http.addFile("etn/v1/comm", "http/comm.json", "application/json"));
+
+        auto found = detect();
+        CHECK(contains(found, "nut_powercom"));
+        CHECK_FALSE(contains(found, "nut_xml_pdc"));
+    }
+
+    SECTION("Slow xml pdc")
+    {
+        REQUIRE(http.addFile("product.xml", "http/product.xml"));
+        REQUIRE(http.addFile("ups_propsum.xml", "http/ups_propsum.xml"));
+        http.setLatency(std::chrono::milliseconds(200));
+
+        auto start = std::chrono::steady_clock::now();
+        CHECK(contains(detect(), "nut_xml_pdc"));
+        CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(400));
+    }
+
+    http.stop();
+}
@@ -0,0 +1,129 @@
+#include "test-common.h"
+#include "src/scheduler.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+TEST_CASE("Schedule / Timer wheel")
+{
+    fty::TimerWheel wheel(8);
+
+    wheel.add("a", 1);
+    wheel.add("b", 3);
+    wheel.add("c", 20);
+    CHECK(wheel.contains("a"));
+
+    auto fired = wheel.tick();
+    REQUIRE(1 == fired.size());
+    CHECK("a" == fired[0]);
+    CHECK_FALSE(wheel.contains("a"));
+
+    CHECK(wheel.tick().empty());
+    fired = wheel.tick();
+    REQUIRE(1 == fired.size());
+    CHECK("b" == fired[0]);
+
+    // 3 ticks passed, "c" fires after 17 more, in the third turn of the wheel
+    for (int i = 0; i < 16; ++i) {
+        CHECK(wheel.tick().empty());
+    }
+    fired = wheel.tick();
+    REQUIRE(1 == fired.size());
+    CHECK("c" == fired[0]);
+
+    wheel.add("d", 2);
+    wheel.remove("d");
+    CHECK(wheel.tick().empty());
+    CHECK(wheel.tick().empty());
+}
+
+TEST_CASE("Schedule / Register and remove")
+{
+    fty::commands::schedule::In in;
+    in.request.address  = "10.255.255.253";
+    in.request.protocol = "nut_snmp";
+    in.request.port     = 161;
+    in.interval         = 3600;
+
+    fty::Message msg = Test::createMessage(fty::commands::schedule::Subject);
+    msg.userData.setString(*pack::json::serialize(in));
+
+    fty::Expected<fty::Message> ret = Test::send(msg);
+    REQUIRE(ret);
+    auto res = ret->userData.decode<fty::commands::schedule::Out>();
+    REQUIRE(res);
+    REQUIRE(1 == res->size());
+    CHECK("10.255.255.253" == (*res)[0].request.address.value());
+    CHECK(0 < (*res)[0].nextRun);
+
+    // Saved by the scheduler thread in a while
+    fty::Scheduler::instance().flush();
+    CHECK(std::filesystem::exists(fty::Config::instance().scheduleState.value()));
+
+    fty::commands::unschedule::In rem;
+    rem.address = "10.255.255.253";
+
+    fty::Message rmsg = Test::createMessage(fty::commands::unschedule::Subject);
+    rmsg.userData.setString(*pack::json::serialize(rem));
+
+    fty::Expected<fty::Message> removed = Test::send(rmsg);
+    REQUIRE(removed);
+    auto rres = removed->userData.decode<fty::commands::unschedule::Out>();
+    REQUIRE(rres);
+    CHECK(1 == rres->size());
+    CHECK(fty::Scheduler::instance().targets().empty());
+}
+
+TEST_CASE("Schedule / Wrong target")
+{
+    fty::commands::schedule::In in;
+    in.request.address = "10.255.255.253";
+    in.interval        = 3600;
+
+    fty::Message msg = Test::createMessage(fty::commands::schedule::Subject);
+    msg.userData.setString(*pack::json::serialize(in));
+
+    fty::Expected<fty::Message> ret = Test::send(msg);
+    CHECK_FALSE(ret);
+    CHECK("Protocol is empty" == ret.error());
+}
+
+TEST_CASE("Schedule / Secrets")
+{
+    fty::commands::schedule::In in;
+    in.request.address            = "10.255.255.252";
+    in.request.protocol           = "nut_snmp";
+    in.request.port               = 161;
+    in.request.settings.community = "schedule-secret-community";
+    in.request.settings.password  = "schedule-secret-password";
+    in.interval                   = 3600;
+
+    fty::Message msg = Test::createMessage(fty::commands::schedule::Subject);
+    msg.userData.setString(*pack::json::serialize(in));
+
+    fty::Expected<fty::Message> ret = Test::send(msg);
+    REQUIRE(ret);
+    CHECK(ret->userData.asString().find("schedule-secret") == std::string::npos);
+    auto res = ret->userData.decode<fty::commands::schedule::Out>();
+    REQUIRE(res);
+    REQUIRE(1 == res->size());
+    CHECK("redacted" == (*res)[0].request.settings.community.value());
+
+    fty::Scheduler::instance().flush();
+
+    const std::string& path = fty::Config::instance().scheduleState;
+    struct stat        st;
+    REQUIRE(stat(path.c_str(), &st) == 0);
+    CHECK((st.st_mode & 0777) == 0600);
+
+    std::ifstream     file(path);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    CHECK(ss.str().find("10.255.255.252") != std::string::npos);
+    CHECK(ss.str().find("schedule-secret") == std::string::npos);
+
+    auto removed = fty::Scheduler::instance().unschedule("10.255.255.252", 0, "");
+    REQUIRE(1 == removed.size());
+    CHECK("redacted" == removed[0].request.settings.password.value());
+}
@@ -0,0 +1,333 @@
+#include "test-common.h"
+#include "ber.h"
+#include "fleet.h"
+#include "impairment.h"
+#include "snmp-agent.h"
+#include <chrono>
+#include <filesystem>
+#include <set>
+
+namespace ber = fty::sim::ber;
+
+static std::string request(int64_t version, uint8_t type, const std::vector<std::string>& oids, int64_t first = 0,
+    int64_t second = 0, const std::string& community = "device")
+{
+    std::string binds;
+    for (const auto& str : oids) {
+        std::string bind;
+        ber::append(bind, ber::ObjectId, ber::objectId(*fty::sim::parseOid(str)));
+        ber::append(bind, ber::Null, {});
+        ber::append(binds, ber::Sequence, bind);
+    }
+
+    std::string pdu;
+    ber::append(pdu, ber::Integer, ber::integer(42));
+    ber::append(pdu, ber::Integer, ber::integer(first));
+    ber::append(pdu, ber::Integer, ber::integer(second));
+    ber::append(pdu, ber::Sequence, binds);
+
+    std::string content;
+    ber::append(content, ber::Integer, ber::integer(version));
+    ber::append(content, ber::OctetString, community);
+    ber::append(content, type, pdu);
+
+    std::string msg;
+    ber::append(msg, ber::Sequence, content);
+    return msg;
+}
+
+struct Answer
+{
+    int64_t                                               error = 0;
+    int64_t                                               index = 0;
+    std::vector<std::pair<std::string, ber::Reader::Tlv>> binds;
+};
+
+static Answer decode(const std::string& data)
+{
+    Answer      answer;
+    ber::Reader msg(*ber::Reader(data).expect(ber::Sequence));
+    msg.expect(ber::Integer);
+    msg.expect(ber::OctetString);
+
+    ber::Reader pdu(*msg.expect(ber::Response));
+    CHECK(42 == *ber::toInteger(*pdu.expect(ber::Integer)));
+    answer.error = *ber::toInteger(*pdu.expect(ber::Integer));
+    answer.index = *ber::toInteger(*pdu.expect(ber::Integer));
+    for (ber::Reader binds(*pdu.expect(ber::Sequence)); !binds.atEnd();) {
+        ber::Reader bind(*binds.expect(ber::Sequence));
+        auto        oid = fty::sim::toString(*ber::toObjectId(*bind.expect(ber::ObjectId)));
+        answer.binds.emplace_back(oid, *bind.next());
+    }
+    return answer;
+}
+
+TEST_CASE("Sim / Ber")
+{
+    CHECK(std::string("\x00", 1) == ber::integer(0));
+    CHECK(std::string("\x00\x80", 2) == ber::integer(128));
+    CHECK(std::string("\xff", 1) == ber::integer(-1));
+    CHECK(std::string("\xff\x7f", 2) == ber::integer(-129));
+    CHECK(std::string("\x00\xff\xff\xff\xff", 5) == ber::unsignedInteger(0xffffffff));
+
+    for (int64_t value : {0l, 1l, -1l, 127l, 128l, -128l, -129l, 65535l, 2147483647l, -2147483648l}) {
+        CHECK(value == *ber::toInteger(ber::integer(value)));
+    }
+
+    auto oid = *fty::sim::parseOid(".1.3.6.1.4.1.534.1.1.2.0");
+    CHECK(oid == *ber::toObjectId(ber::objectId(oid)));
+    CHECK(std::string("\x2b\x06\x01\x04\x01\x84\x16", 7) == ber::objectId(*fty::sim::parseOid("1.3.6.1.4.1.534")));
+}
+
+TEST_CASE("Sim / Snmprec")
+{
+    auto rec = fty::sim::Snmprec::parse(
+        "1.3.6.1.2.1.1.5.0|4|UPS31\n"
+        "1.3.6.1.2.1.1.2.0|6|1.3.6.1.4.1.534.1\n"
+        "1.3.6.1.2.1.1.1.0|4x|4561746f6e\n"
+        "1.3.6.1.2.1.1.3.0|67|61070811\n");
+    REQUIRE(rec);
+    REQUIRE(4 == (*rec)->entries().size());
+
+    // Sorted by OID, numerically
+    CHECK("1.3.6.1.2.1.1.1.0" == fty::sim::toString((*rec)->entries()[0].oid));
+
+    const auto* entry = (*rec)->get(*fty::sim::parseOid("1.3.6.1.2.1.1.1.0"));
+    REQUIRE(entry);
+    CHECK(entry->hex);
+    CHECK(ber::OctetString == entry->tag);
+
+    std::string encoded;
+    ber::append(encoded, ber::OctetString, "Eaton");
+    CHECK(encoded == ber::value(*entry));
+
+    const auto* next = (*rec)->next(*fty::sim::parseOid("1.3.6.1.2.1.1.3.0"));
+    REQUIRE(next);
+    CHECK("1.3.6.1.2.1.1.5.0" == fty::sim::toString(next->oid));
+    CHECK(nullptr == (*rec)->next(next->oid));
+
+    CHECK_FALSE(fty::sim::Snmprec::parse("1.3.6.1|4\n"));
+}
+
+TEST_CASE("Sim / Requests")
+{
+    fty::sim::SnmpAgent agent;
+    agent.add("device", *fty::sim::Snmprec::parse(
+        "1.3.6.1.2.1.1.1.0|4|Eaton\n"
+        "1.3.6.1.2.1.1.2.0|6|1.3.6.1.4.1.534.1\n"
+        "1.3.6.1.2.1.1.3.0|67|61070811\n"));
+
+    // Unknown community is dropped
+    CHECK(agent.answer(request(1, ber::GetRequest, {"1.3.6.1.2.1.1.1.0"}, 0, 0, "public")).empty());
+
+    auto get = decode(agent.answer(request(1, ber::GetRequest, {"1.3.6.1.2.1.1.1.0", "1.3.6.1.2.1.1.9.0"})));
+    CHECK(0 == get.error);
+    REQUIRE(2 == get.binds.size());
+    CHECK(ber::OctetString == get.binds[0].second.tag);
+    CHECK("Eaton" == get.binds[0].second.content);
+    CHECK(ber::NoSuchObject == get.binds[1].second.tag);
+
+    auto v1 = decode(agent.answer(request(0, ber::GetRequest, {"1.3.6.1.2.1.1.1.0", "1.3.6.1.2.1.1.9.0"})));
+    CHECK(2 == v1.error);
+    CHECK(2 == v1.index);
+
+    auto next = decode(agent.answer(request(1, ber::GetNextRequest, {"1.3.6.1.2.1.1.1.0"})));
+    REQUIRE(1 == next.binds.size());
+    CHECK("1.3.6.1.2.1.1.2.0" == next.binds[0].first);
+    CHECK(ber::ObjectId == next.binds[0].second.tag);
+
+    auto bulk = decode(agent.answer(request(1, ber::GetBulkRequest, {"1.3.6.1.2.1.1"}, 0, 10)));
+    REQUIRE(4 == bulk.binds.size());
+    CHECK("1.3.6.1.2.1.1.3.0" == bulk.binds[2].first);
+    CHECK(ber::TimeTicks == bulk.binds[2].second.tag);
+    CHECK(ber::EndOfMibView == bulk.binds[3].second.tag);
+
+    // Bulk is not a v1 request
+    CHECK(agent.answer(request(0, ber::GetBulkRequest, {"1.3.6.1.2.1.1"}, 0, 10)).empty());
+}
+
+TEST_CASE("Sim / Snmp session")
+{
+    fty::sim::SnmpAgent agent;
+    REQUIRE(agent.load("assets"));
+    REQUIRE(agent.device("xups.238"));
+
+    auto port = agent.listen();
+    REQUIRE(port);
+    REQUIRE(agent.start(2));
+
+    auto session = fty::impl::Snmp::instance().session("127.0.0.1", *port);
+    REQUIRE(session->setCommunity("xups.238"));
+    REQUIRE(session->open());
+
+    auto model = session->read(".1.3.6.1.4.1.534.1.1.2.0");
+    REQUIRE(model);
+    CHECK("93PM 100kW" == *model);
+    CHECK(0 < agent.requests());
+
+    agent.stop();
+}
+
+TEST_CASE("Sim / Impairment")
+{
+    using fty::sim::Impairment;
+
+    SECTION("Parse")
+    {
+        auto imp = Impairment::parse("latency=50, jitter=10,loss=0.25");
+        REQUIRE(imp);
+        CHECK(50 == imp->latency.count());
+        CHECK(10 == imp->jitter.count());
+        CHECK(0.25 == imp->loss);
+        CHECK_FALSE(imp->blackhole);
+
+        CHECK(Impairment::parse("blackhole")->blackhole);
+        CHECK(Impairment::parse("")->empty());
+        CHECK_FALSE(Impairment::parse("loss=2"));
+        CHECK_FALSE(Impairment::parse("latency=slow"));
+        CHECK_FALSE(Impairment::parse("delay=10"));
+    }
+
+    SECTION("Datagrams")
+    {
+        Impairment imp = *Impairment::parse("latency=100,jitter=20");
+        for (int i = 0; i < 100; ++i) {
+            auto delay = imp.datagram();
+            REQUIRE(delay);
+            CHECK(80 <= delay->count());
+            CHECK(120 >= delay->count());
+        }
+
+        CHECK_FALSE(Impairment::parse("loss=1")->datagram());
+        CHECK_FALSE(Impairment::parse("blackhole")->stream());
+
+        // Lost segment is retransmitted, so stream is only delayed
+        imp = *Impairment::parse("latency=10,loss=0.5");
+        for (int i = 0; i < 100; ++i) {
+            if (auto delay = imp.stream()) {
+                CHECK(10 <= delay->count());
+            }
+        }
+    }
+
+    SECTION("Snmp session")
+    {
+        fty::sim::SnmpAgent agent;
+        REQUIRE(agent.load("assets"));
+
+        auto port = agent.listen();
+        REQUIRE(port);
+        REQUIRE(agent.start(2));
+
+        auto read = [&]() {
+            auto session = fty::impl::Snmp::instance().session("127.0.0.1", *port);
+            REQUIRE(session->setCommunity("xups.238"));
+            REQUIRE(session->setTimeout(1000));
+            REQUIRE(session->open());
+            return session->read(".1.3.6.1.4.1.534.1.1.2.0");
+        };
+
+        agent.impair("xups.238", *Impairment::parse("latency=300"));
+        auto start = std::chrono::steady_clock::now();
+        CHECK(read());
+        CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(300));
+
+        // Device impairment is preferred to the default one
+        agent.impair("", *Impairment::parse("blackhole"));
+        CHECK(read());
+
+        agent.impair("xups.238", {});
+        CHECK_FALSE(read());
+        CHECK(0 < agent.dropped());
+
+        agent.stop();
+    }
+}
+
+TEST_CASE("Sim / Fleet")
+{
+    namespace fleet = fty::sim::fleet;
+    using fty::sim::parseOid;
+
+    auto templates = fleet::templates("assets");
+    REQUIRE(templates);
+    REQUIRE(templates->count("epdu.147"));
+
+    fleet::Options options;
+    options.count      = 3 * uint32_t(templates->size());
+    options.maxChain   = 6;
+    options.minOutlets = 4;
+    options.maxOutlets = 30;
+    options.minDelay   = std::chrono::milliseconds(5);
+    options.maxDelay   = std::chrono::milliseconds(10);
+
+    auto devices = fleet::generate(*templates, options);
+    REQUIRE(devices);
+    REQUIRE(options.count == devices->size());
+
+    std::set<std::string> names, engines, serials;
+    for (const auto& dev : *devices) {
+        names.insert(dev.name);
+        CHECK(5 <= dev.impairment.latency.count());
+        CHECK(10 >= dev.impairment.latency.count());
+
+        if (const auto* engine = dev.recording->get(*parseOid("1.3.6.1.6.3.10.2.1.1.0"))) {
+            engines.insert(std::string(engine->value));
+        }
+
+        if (dev.origin != "epdu.147") {
+            continue;
+        }
+
+        // Every unit of the daisy chain has own serial and outlets as announced by the unit table
+        for (uint32_t unit = 0;; ++unit) {
+            std::string index  = std::to_string(unit);
+            const auto* serial = dev.recording->get(*parseOid("1.3.6.1.4.1.534.6.6.7.1.2.1.4." + index));
+            if (!serial) {
+                CHECK((1 <= unit && unit <= 6));
+                break;
+            }
+            serials.insert(std::string(serial->value));
+
+            auto outlets = std::stoul(std::string(dev.recording->get(
+                *parseOid("1.3.6.1.4.1.534.6.6.7.1.2.1.22." + index))->value));
+            CHECK((4 <= outlets && outlets <= 30));
+            CHECK(dev.recording->get(
+                *parseOid("1.3.6.1.4.1.534.6.6.7.6.1.1.2." + index + "." + std::to_string(outlets))));
+            CHECK_FALSE(dev.recording->get(
+                *parseOid("1.3.6.1.4.1.534.6.6.7.6.1.1.2." + index + "." + std::to_string(outlets + 1))));
+        }
+    }
+    CHECK(devices->size() == names.size());
+    CHECK(devices->size() == engines.size());
+    CHECK(3 <= serials.size());
+
+    // Same seed, same fleet
+    auto again = fleet::generate(*templates, options);
+    REQUIRE(again);
+    CHECK((*devices)[1].recording->content() == (*again)[1].recording->content());
+
+    // Saved fleet is loaded by the agent with its delays
+    auto dir = (std::filesystem::temp_directory_path() / "discovery-fleet").string();
+    std::filesystem::remove_all(dir);
+    REQUIRE(fleet::save(dir, *devices));
+
+    fty::sim::SnmpAgent agent;
+    REQUIRE(agent.load(dir));
+    CHECK(devices->size() == agent.names().size());
+
+    auto port = agent.listen();
+    REQUIRE(port);
+    REQUIRE(agent.start());
+
+    auto session = fty::impl::Snmp::instance().session("127.0.0.1", *port);
+    REQUIRE(session->setCommunity((*devices)[1].name));
+    REQUIRE(session->open());
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK(session->read(".1.3.6.1.6.3.10.2.1.1.0"));
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(5));
+
+    agent.stop();
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,95 @@
+#include "test-common.h"
+#include "stats.h"
+
+TEST_CASE("Stats / Histogram")
+{
+    using fty::stats::Histogram;
+
+    for (uint64_t value = 0; value < 1000000; value += 13) {
+        size_t bucket = Histogram::bucket(value);
+        CHECK(value <= Histogram::highest(bucket));
+        if (bucket) {
+            CHECK(value > Histogram::highest(bucket - 1));
+        }
+    }
+
+    Histogram hist;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        hist.add(value);
+    }
+    CHECK(1000 == hist.count);
+    CHECK(1000 == hist.max);
+    CHECK(1000 == hist.percentile(1));
+
+    // Relative error is below 1/16
+    CHECK(500 <= hist.percentile(0.5));
+    CHECK(hist.percentile(0.5) < 500 + 500 / 16);
+    CHECK(990 <= hist.percentile(0.99));
+}
+
+TEST_CASE("Stats / Request")
+{
+    fty::stats::reset();
+
+    fty::commands::protocols::In in;
+    in.address = "__fake__";
+
+    fty::Message msg = Test::createMessage(fty::commands::protocols::Subject);
+    msg.userData.setString(*pack::json::serialize(in));
+    REQUIRE(Test::send(msg));
+
+    fty::commands::stats::In query;
+    query.reset = true;
+
+    fty::Message smsg = Test::createMessage(fty::commands::stats::Subject);
+    smsg.userData.setString(*pack::json::serialize(query));
+
+    fty::Expected<fty::Message> ret = Test::send(smsg);
+    REQUIRE(ret);
+    auto res = ret->userData.decode<fty::commands::stats::Out>();
+    REQUIRE(res);
+
+    auto protocols = res->find([](const fty::commands::stats::Stage& stage) {
+        return stage.name.value() == "protocols";
+    });
+    REQUIRE(protocols);
+    CHECK(1 == protocols->count);
+    CHECK(0 == protocols->errors);
+    CHECK(protocols->p50 <= protocols->max);
+
+    // Reset with the previous request
+    auto snapshot = fty::stats::snapshot();
+    CHECK(0 == snapshot[size_t(fty::stats::Stage::Protocols)].count);
+}
+
+TEST_CASE("Stats / Breakdown")
+{
+    using fty::stats::Stage;
+
+    fty::stats::record(Stage::Dns, 100);
+    {
+        fty::stats::Scope scope;
+        fty::stats::record(Stage::Dns, 400);
+        fty::stats::record(Stage::SnmpGet, 1000);
+        fty::stats::record(Stage::SnmpGet, 2000, false);
+        {
+            // Nested scope takes over
+            fty::stats::Scope inner;
+            fty::stats::record(Stage::Parse, 300);
+            CHECK(1 == inner.breakdown().count[size_t(Stage::Parse)]);
+        }
+        fty::stats::record(Stage::DriverRun, 5000, false);
+
+        const auto& breakdown = scope.breakdown();
+        CHECK(400 == breakdown.micros[size_t(Stage::Dns)]);
+        CHECK(2 == breakdown.count[size_t(Stage::SnmpGet)]);
+        CHECK(1 == breakdown.errors[size_t(Stage::SnmpGet)]);
+        CHECK(0 == breakdown.count[size_t(Stage::Parse)]);
+        CHECK("dns=0.4ms snmp-get=3.0ms(2x, 1 failed) driver-run=5.0ms(failed)" == breakdown.format());
+    }
+
+    fty::stats::setSlowThreshold(250);
+    CHECK(250000 == fty::stats::slowThreshold());
+    fty::stats::setSlowThreshold(0);
+    CHECK(0 == fty::stats::slowThreshold());
+}
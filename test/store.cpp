@@ -0,0 +1,249 @@
+#include "test-common.h"
+#include "src/jobs/impl/fingerprint.h"
+#include "src/store.h"
+#include <filesystem>
+#include <fstream>
+
+static std::string storeDir(const std::string& name)
+{
+    auto path = std::filesystem::temp_directory_path() / ("discovery-ng-" + name);
+    std::filesystem::remove_all(path);
+    return path.string();
+}
+
+TEST_CASE("Store / Update and reopen")
+{
+    std::string path = storeDir("store-reopen");
+
+    {
+        fty::Store store;
+        REQUIRE(store.open(path));
+
+        CHECK(store.update("10.0.0.1", [](fty::Store::Host& host) {
+            host.protocols.setValue({"nut_snmp"});
+        }));
+        CHECK(store.update("10.0.0.2", [](fty::Store::Host& host) {
+            host.protocols.setValue({"nut_xml_pdc"});
+        }));
+        CHECK(store.update("10.0.0.1", [](fty::Store::Host& host) {
+            CHECK(1 == host.protocols.size());
+            host.mibs.setValue({"XUPS-MIB"});
+        }));
+        CHECK(store.remove("10.0.0.2"));
+
+        CHECK(store.find("10.0.0.1"));
+        CHECK_FALSE(store.find("10.0.0.2"));
+    }
+
+    fty::Store store;
+    REQUIRE(store.open(path));
+
+    auto host = store.find("10.0.0.1");
+    REQUIRE(host);
+    CHECK("10.0.0.1" == host->address.value());
+    CHECK(1 == host->protocols.size());
+    CHECK("nut_snmp" == host->protocols[0]);
+    CHECK(1 == host->mibs.size());
+    CHECK("XUPS-MIB" == host->mibs[0]);
+    CHECK(host->firstSeen.value() <= host->lastSeen.value());
+
+    CHECK_FALSE(store.find("10.0.0.2"));
+    CHECK(1 == store.all().size());
+}
+
+TEST_CASE("Store / Broken tail and lost index")
+{
+    std::string path = storeDir("store-broken");
+
+    {
+        fty::Store store;
+        REQUIRE(store.open(path));
+        for (int i = 0; i < 2000; ++i) {
+            CHECK(store.update("10.0." + std::to_string(i / 256) + "." + std::to_string(i % 256), [](auto&) {}));
+        }
+    }
+
+    // Simulates crash in the middle of the record write
+    {
+        std::ofstream log(path + "/hosts.log", std::ios::app | std::ios::binary);
+        log << "garbage";
+    }
+    std::filesystem::remove(path + "/hosts.idx");
+
+    fty::Store store;
+    REQUIRE(store.open(path));
+    CHECK(2000 == store.all().size());
+    CHECK(store.find("10.0.7.207"));
+
+    CHECK(store.update("10.0.0.1", [](fty::Store::Host& host) {
+        host.driver = "nut_snmp";
+    }));
+    auto host = store.find("10.0.0.1");
+    REQUIRE(host);
+    CHECK("nut_snmp" == host->driver.value());
+}
+
+TEST_CASE("Store / Compact")
+{
+    std::string path = storeDir("store-compact");
+
+    fty::Store store;
+    REQUIRE(store.open(path));
+    for (int i = 0; i < 100; ++i) {
+        CHECK(store.update("10.0.0.1", [&](fty::Store::Host& host) {
+            host.driver = "nut_snmp_" + std::to_string(i);
+        }));
+    }
+    CHECK(store.update("10.0.0.2", [](auto&) {}));
+    CHECK(store.remove("10.0.0.2"));
+
+    auto before = std::filesystem::file_size(path + "/hosts.log");
+    CHECK(store.compact());
+    CHECK(std::filesystem::file_size(path + "/hosts.log") < before);
+
+    auto host = store.find("10.0.0.1");
+    REQUIRE(host);
+    CHECK("nut_snmp_99" == host->driver.value());
+    CHECK_FALSE(store.find("10.0.0.2"));
+
+    store.close();
+    REQUIRE(store.open(path));
+    CHECK(1 == store.all().size());
+}
+
+TEST_CASE("Hosts / Known host")
+{
+    fty::commands::protocols::In in;
+    in.address = "127.0.0.1";
+
+    fty::Message msg = Test::createMessage(fty::commands::protocols::Subject);
+    msg.userData.setString(*pack::json::serialize(in));
+    REQUIRE(Test::send(msg));
+
+    fty::commands::hosts::In query;
+    query.address = "127.0.0.1";
+
+    fty::Message hmsg = Test::createMessage(fty::commands::hosts::Subject);
+    hmsg.userData.setString(*pack::json::serialize(query));
+
+    fty::Expected<fty::Message> ret = Test::send(hmsg);
+    REQUIRE(ret);
+    auto res = ret->userData.decode<fty::commands::hosts::Out>();
+    REQUIRE(res);
+    REQUIRE(1 == res->size());
+    CHECK("127.0.0.1" == (*res)[0].address.value());
+    CHECK(0 < (*res)[0].lastSeen);
+}
+
+TEST_CASE("Hosts / Unknown host")
+{
+    fty::commands::hosts::In query;
+    query.address = "10.255.255.254";
+
+    fty::Message msg = Test::createMessage(fty::commands::hosts::Subject);
+    msg.userData.setString(*pack::json::serialize(query));
+
+    fty::Expected<fty::Message> ret = Test::send(msg);
+    CHECK_FALSE(ret);
+    CHECK("Host is not known: 10.255.255.254" == ret.error());
+}
+
+TEST_CASE("Store / Warm start fingerprints")
+{
+    using fty::impl::FingerprintCache;
+
+    CHECK("10.0.0.1" == FingerprintCache::addressOf(FingerprintCache::key("10.0.0.1")));
+    CHECK("10.0.0.1" == FingerprintCache::addressOf(FingerprintCache::key("10.0.0.1", 161, "cred-1")));
+    CHECK("10.0.0.1" == FingerprintCache::addressOf(FingerprintCache::key("10.0.0.1", 161, {}, "public")));
+    CHECK("fd00::1" == FingerprintCache::addressOf(FingerprintCache::key("fd00::1")));
+    CHECK("fd00::1" == FingerprintCache::addressOf(FingerprintCache::key("fd00::1", 161, {}, "public")));
+
+    // Community is neither in the key as is nor persisted
+    auto communityKey = FingerprintCache::key("10.0.0.1", 161, {}, "public");
+    CHECK(communityKey.find("public") == std::string::npos);
+    CHECK_FALSE(FingerprintCache::persistent(communityKey));
+    CHECK(FingerprintCache::persistent(FingerprintCache::key("10.0.0.1", 161, "cred-1", "public")));
+
+    REQUIRE(fty::Store::instance().isOpen());
+
+    auto key = FingerprintCache::key("10.255.255.252", 161, "cred-epdu");
+    FingerprintCache::instance().update(key, [](fty::impl::Fingerprint& fp) {
+        fp.objectId = "EATON-EPDU-MIB::eatonEpdu";
+        fp.descr    = "Eaton ePDU";
+        fp.upTime   = 1000;
+        fp.rtt      = 12;
+        fp.mibs     = {"EATON-EPDU-MIB"};
+    });
+
+    auto host = fty::Store::instance().find("10.255.255.252");
+    REQUIRE(host);
+    REQUIRE(1 == host->fingerprints.size());
+    CHECK(key == host->fingerprints[0].key.value());
+
+    // Refresh of the matched fingerprint stays in memory
+    FingerprintCache::instance().update(key, [](fty::impl::Fingerprint& fp) {
+        fp.upTime = 2000;
+        fp.rtt    = 20;
+    });
+    CHECK(12 == fty::Store::instance().find("10.255.255.252")->fingerprints[0].rtt);
+
+    auto unsaved = FingerprintCache::key("10.255.255.252", 161, {}, "public");
+    FingerprintCache::instance().update(unsaved, [](fty::impl::Fingerprint& fp) {
+        fp.mibs = {"EATON-EPDU-MIB"};
+    });
+    CHECK(1 == fty::Store::instance().find("10.255.255.252")->fingerprints.size());
+
+    // Restart: cache is empty, store still has the fingerprint
+    FingerprintCache::instance().clear();
+    CHECK_FALSE(FingerprintCache::instance().find(key));
+    CHECK(0 < FingerprintCache::instance().preload());
+    CHECK_FALSE(FingerprintCache::instance().find(unsaved));
+
+    auto print = FingerprintCache::instance().find(key);
+    REQUIRE(print);
+    CHECK("EATON-EPDU-MIB::eatonEpdu" == print->objectId);
+    CHECK(12 == print->rtt);
+    REQUIRE(1 == print->mibs.size());
+    CHECK("EATON-EPDU-MIB" == print->mibs[0]);
+
+    FingerprintCache::instance().forget("10.255.255.252");
+    REQUIRE(fty::Store::instance().remove("10.255.255.252"));
+}
+
+TEST_CASE("Store / Verified fingerprint outlives ttl")
+{
+    using fty::impl::FingerprintCache;
+
+    REQUIRE(fty::Store::instance().isOpen());
+
+    auto ttl                               = fty::Config::instance().fingerprintTtl.value();
+    fty::Config::instance().fingerprintTtl = 4;
+
+    auto key    = FingerprintCache::key("10.255.255.251", 161, "cred-ups");
+    auto detect = [](fty::impl::Fingerprint& fp) {
+        fp.objectId = "EATON-OIDS::xupsMIB";
+        fp.descr    = "Eaton UPS";
+        fp.upTime   = 1000;
+        fp.mibs     = {"EATON-OIDS::xupsMIB"};
+    };
+    FingerprintCache::instance().update(key, detect);
+
+    // Matched again after half of the ttl, stored time is refreshed
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    FingerprintCache::instance().update(key, [](fty::impl::Fingerprint& fp) {
+        fp.upTime = 3000;
+    });
+
+    // Ttl elapsed since the detection, not since the last match
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    FingerprintCache::instance().clear();
+    CHECK(0 < FingerprintCache::instance().preload());
+
+    auto print = FingerprintCache::instance().find(key);
+    REQUIRE(print);
+    CHECK(3000 == print->upTime);
+
+    fty::Config::instance().fingerprintTtl = ttl;
+    FingerprintCache::instance().forget("10.255.255.251");
+    REQUIRE(fty::Store::instance().remove("10.255.255.251"));
+}
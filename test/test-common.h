@@ -49,7 +49,7 @@ public:
             return fty::unexpected(res.error());
         }
 
-        if (auto res = inst->m_bus.init("unit-test"); !res) {
+        if (auto res = inst->m_bus.init("unit-test", fty::Config::instance().endpoint); !res) {
             return fty::unexpected(res.error());
         }
 
@@ -0,0 +1,36 @@
+#include "test-common.h"
+
+TEST_CASE("Trace / Request spans")
+{
+    fty::commands::protocols::In in;
+    in.address = "__fake__";
+
+    fty::Message msg       = Test::createMessage(fty::commands::protocols::Subject);
+    msg.meta.correlationId = "trace-request";
+    msg.userData.setString(*pack::json::serialize(in));
+    REQUIRE(Test::send(msg));
+
+    fty::commands::trace::In query;
+    query.correlationId = "trace-request";
+
+    fty::Message tmsg = Test::createMessage(fty::commands::trace::Subject);
+    tmsg.userData.setString(*pack::json::serialize(query));
+
+    fty::Expected<fty::Message> ret = Test::send(tmsg);
+    REQUIRE(ret);
+    auto res = ret->userData.decode<fty::commands::trace::Out>();
+    REQUIRE(res);
+
+    // Whole request span ends after reply is sent, so only spans before reply are checked
+    auto protocols = res->traceEvents.find([](const fty::commands::trace::Event& event) {
+        return event.name.value() == "protocols";
+    });
+    auto serialize = res->traceEvents.find([](const fty::commands::trace::Event& event) {
+        return event.name.value() == "serialize";
+    });
+    REQUIRE(protocols);
+    REQUIRE(serialize);
+    CHECK("X" == protocols->ph.value());
+    CHECK(protocols->ts <= serialize->ts);
+    CHECK("trace-request" == protocols->args["correlation_id"]);
+}
@@ -0,0 +1,79 @@
+#include "test-common.h"
+#include "src/watchers.h"
+
+TEST_CASE("Watch / Patterns")
+{
+    using fty::Watchers;
+
+    CHECK(Watchers::matches("*", "10.0.0.1"));
+    CHECK(Watchers::matches("10.0.0.1", "10.0.0.1"));
+    CHECK_FALSE(Watchers::matches("10.0.0.1", "10.0.0.10"));
+
+    CHECK(Watchers::matches("10.0.0.0/24", "10.0.0.254"));
+    CHECK_FALSE(Watchers::matches("10.0.0.0/24", "10.0.1.1"));
+    CHECK(Watchers::matches("10.0.0.0/22", "10.0.3.1"));
+    CHECK_FALSE(Watchers::matches("10.0.0.0/22", "10.0.4.1"));
+    CHECK(Watchers::matches("0.0.0.0/0", "192.168.1.1"));
+
+    CHECK(Watchers::matches("fd00::/64", "fd00::1"));
+    CHECK_FALSE(Watchers::matches("fd00::/64", "fd00:0:0:1::1"));
+    CHECK_FALSE(Watchers::matches("fd00::/64", "10.0.0.1"));
+
+    CHECK_FALSE(Watchers::matches("10.0.0.0/33", "10.0.0.1"));
+    CHECK_FALSE(Watchers::matches("host/24", "10.0.0.1"));
+    CHECK_FALSE(Watchers::matches("10.0.0.0/x", "10.0.0.1"));
+    CHECK_FALSE(Watchers::matches("10.0.0.0/", "10.0.0.1"));
+
+    CHECK(Watchers::Pattern::parse("10.0.0.0/24"));
+    CHECK(Watchers::Pattern::parse("fd00::/64"));
+    CHECK_FALSE(Watchers::Pattern::parse("10.0.0.0/x"));
+    CHECK_FALSE(Watchers::Pattern::parse("10.0.0.0/-1"));
+    CHECK_FALSE(Watchers::Pattern::parse("fd00::/129"));
+    CHECK_FALSE(Watchers::Pattern::parse(""));
+}
+
+TEST_CASE("Watch / Register and remove")
+{
+    auto request = [](const std::vector<std::string>& hosts, bool remove) {
+        fty::commands::watch::In in;
+        in.hosts.setValue(hosts);
+        in.remove = remove;
+
+        fty::Message msg = Test::createMessage(fty::commands::watch::Subject);
+        msg.userData.setString(*pack::json::serialize(in));
+        return Test::send(msg);
+    };
+
+    fty::Expected<fty::Message> ret = request({"10.0.0.0/24", "127.0.0.1"}, false);
+    REQUIRE(ret);
+    auto res = ret->userData.decode<fty::commands::watch::Out>();
+    REQUIRE(res);
+    CHECK(2 == res->size());
+
+    ret = request({"10.0.0.0/24"}, true);
+    REQUIRE(ret);
+    res = ret->userData.decode<fty::commands::watch::Out>();
+    REQUIRE(res);
+    REQUIRE(1 == res->size());
+    CHECK("127.0.0.1" == (*res)[0]);
+
+    ret = request({}, true);
+    REQUIRE(ret);
+    res = ret->userData.decode<fty::commands::watch::Out>();
+    REQUIRE(res);
+    CHECK(res->empty());
+
+    ret = request({}, false);
+    CHECK_FALSE(ret);
+
+    // Malformed pattern is rejected, nothing is registered
+    ret = request({"10.0.0.1", "10.0.0.0/x"}, false);
+    CHECK_FALSE(ret);
+    ret = request({"127.0.0.2"}, false);
+    REQUIRE(ret);
+    res = ret->userData.decode<fty::commands::watch::Out>();
+    REQUIRE(res);
+    REQUIRE(1 == res->size());
+    CHECK("127.0.0.2" == (*res)[0]);
+    CHECK(request({}, true));
+}